@@ -87,19 +87,15 @@ void OffScreenCanvas2DGameState::setCustomTextureToSkin( Colibri::Renderable *wi
 
 	if( itor != skins.end() )
 	{
-		Colibri::SkinInfo *skinInfos[Colibri::States::NumStates];
-		Colibri::SkinInfo mainSkinInfo;
+		// _setSkinPack would keep pointing to our local variable, thus we
+		// must use setStateInformation which copies the data instead.
+		Colibri::StateInformation stateInfo = itor->second.stateInfo;
+		stateInfo.materialName = materialName;
 
-		mainSkinInfo = itor->second;
-		mainSkinInfo.materialName = materialName;
-		mainSkinInfo.stateInfo.materialName = materialName;
-
-		mainSkinInfo.stateInfo.uvTopLeftBottomRight[Colibri::GridLocations::Center] =
+		stateInfo.uvTopLeftBottomRight[Colibri::GridLocations::Center] =
 			Ogre::Vector4( 0.0f, 0.0f, 1.0f, 1.0f );
 
-		for( size_t i = 0; i < Colibri::States::NumStates; ++i )
-			skinInfos[i] = &mainSkinInfo;
-		widget->_setSkinPack( skinInfos );
+		widget->setStateInformation( stateInfo );
 	}
 }
 //-----------------------------------------------------------------------------------
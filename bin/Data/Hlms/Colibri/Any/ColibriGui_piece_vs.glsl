@@ -40,7 +40,15 @@
 		outVs.uvText.x = (vertId <= 1u || vertId == 5u) ? 0.0f : float( blendIndices.x );
 		outVs.uvText.y = (vertId == 0u || vertId >= 4u) ? 0.0f : float( blendIndices.y );
 		outVs.pixelsPerRow		= blendIndices.x;
+		outVs.glyphHeight		= blendIndices.y;
 		outVs.glyphOffsetStart	= tangent;
+
+		// Label::setShadowOutline. Written right after the regular per-draw data.
+		// See HlmsColibri::fillBuffersForColibri
+		uint4 textShadow = worldMaterialIdx[inVs_drawId + 1u];
+		outVs.shadowColour		= unpackUnorm4x8( textShadow.x );
+		outVs.shadowDisplace	= float2( uintBitsToFloat( textShadow.y ),
+										  uintBitsToFloat( textShadow.z ) );
 	@end
 @end
 
@@ -36,7 +36,15 @@
 		outVs.uvText.x = (vertId <= 1u || vertId == 5u) ? 0.0f : float( input.blendIndices.x );
 		outVs.uvText.y = (vertId == 0u || vertId >= 4u) ? 0.0f : float( input.blendIndices.y );
 		outVs.pixelsPerRow		= input.blendIndices.x;
+		outVs.glyphHeight		= input.blendIndices.y;
 		outVs.glyphOffsetStart	= input.tangent;
+
+		// Label::setShadowOutline. Written right after the regular per-draw data.
+		// See HlmsColibri::fillBuffersForColibri
+		uint4 textShadow = worldMaterialIdx[inVs_drawId + 1u];
+		outVs.shadowColour		= unpackUnorm4x8( textShadow.x );
+		outVs.shadowDisplace	= float2( as_type<float>( textShadow.y ),
+										  as_type<float>( textShadow.z ) );
 	@end
 @end
 
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "ColibriGui/ColibriGuiPrerequisites.h"
+
+#include <string>
+#include <vector>
+
+COLIBRI_ASSUME_NONNULL_BEGIN
+
+namespace Colibri
+{
+	namespace BatchBreakReason
+	{
+		/// Why Renderable::_addCommands had to start a new draw
+		enum BatchBreakReason
+		{
+			/// First draw of the frame
+			FirstDraw,
+			/// The shader / PSO changed (e.g. different blendblock, text vs regular widgets,
+			/// CustomShape vs regular widgets)
+			HlmsCacheChange,
+			/// Same shader, but different textures or buffers had to be bound
+			/// (e.g. skins using materials with different textures)
+			TextureChange,
+			/// Switched between the VAO of regular widgets and the one of text
+			VaoChange,
+			/// A Label uses a different datablock than the previous Label
+			LabelDatablockChange,
+			/// A Label has a different shadow than the previous Label (see
+			/// Label::setShadowOutline). Labels without shadow never break because of this
+			LabelShadowChange,
+			/// Vertices were not contiguous with the previous draw. Usually caused by
+			/// breadth first rendering (see Widget::m_breadthFirst)
+			VertexDiscontinuity,
+			/// CustomShapes always get their own draw
+			CustomShape,
+			NumBatchBreakReasons
+		};
+	}  // namespace BatchBreakReason
+
+	struct BatchBreakRecord
+	{
+		BatchBreakReason::BatchBreakReason reason;
+		/// True if a new draw command was issued (CbDrawCallStrip), false if
+		/// only a new indirect draw was added to the current command
+		bool newCommand;
+		/// Window containing the widget that caused the break (may be the widget itself).
+		/// Only valid during the frame it was recorded.
+		Window const *window;
+		/// Widget::_getDebugName of the widget (empty in release builds)
+		std::string debugName;
+		/// Widget::_getDebugName of window
+		std::string windowDebugName;
+	};
+
+	/** @class BatchBreakStats
+		Records every time rendering had to start a new draw, and why.
+		See ColibriManager::setBatchBreakStatsEnabled.
+	*/
+	struct BatchBreakStats
+	{
+		/// Number of breaks per reason
+		uint32_t numBreaks[BatchBreakReason::NumBatchBreakReasons];
+		/// Number of draw commands (CbDrawCallStrip) issued
+		uint32_t numCommands;
+		/// Number of indirect draws issued (>= numCommands)
+		uint32_t numDraws;
+
+		/// Every break, in rendering order
+		std::vector<BatchBreakRecord> records;
+
+		BatchBreakStats();
+
+		void clear();
+
+		void addRecord( BatchBreakReason::BatchBreakReason reason, bool newCommand,
+						const Widget *widget );
+
+		/// Undoes the last addRecord. Called when its draw is taken back because
+		/// it ended up empty (see Renderable::_addCommands)
+		void removeLastRecord();
+
+		/** Outputs the number of breaks of each reason caused by widgets
+			belonging to the given window.
+		@param window
+			Window to look for. Child windows are not included.
+		@param outNumBreaks [out]
+			Array with the number of breaks per reason
+		*/
+		void getWindowBreakdown(
+			const Window *window,
+			uint32_t outNumBreaks[colibri_nonnull BatchBreakReason::NumBatchBreakReasons] ) const;
+
+		/// Logs a summary followed by the breakdown of each window that caused breaks
+		void log( LogListener *logListener ) const;
+
+		static const char *getReasonName( BatchBreakReason::BatchBreakReason reason );
+	};
+}  // namespace Colibri
+
+COLIBRI_ASSUME_NONNULL_END
@@ -23,6 +23,9 @@ namespace Colibri
 		void _initialize() override;
 		void _destroy() override;
 
+		void _cloneSettingsTo( Widget *dst ) const override;
+		bool _isInternalChild( const Widget *child ) const override;
+
 		/** By default getLabel()->m_margin can be used to set both top left & bottom right
 			margins. This setting allows to control them separately, which are ADDED on top of
 			getLabel()->m_margin.
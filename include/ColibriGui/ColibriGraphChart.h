@@ -23,7 +23,7 @@ namespace Colibri
 			Colibri::Label *label;
 
 			/// This dataset's colour lives in rectangle->setColour().
-			/// But changes won't take effect until the next GraphChart::build call.
+			/// But changes won't take effect until the next GraphChart::syncChart call.
 			Colibri::CustomShape *rectangle;
 		};
 
@@ -48,7 +48,11 @@ namespace Colibri
 		std::vector<Column> m_columns;
 		std::vector<float>  m_allValues;
 
+		/// One row per column with its values, plus a last row with the chart's
+		/// Params and the colours of each column (see syncChart). The shader reads
+		/// them from here so that all charts can share the same shader.
 		Ogre::TextureGpu *m_textureData;
+		uint32_t          m_entriesPerColumn;
 
 		bool m_labelsDirty;
 
@@ -166,7 +170,8 @@ namespace Colibri
 					setColour( true, Ogre::ColourValue( 0.0f, 1.0f, 0.0f, 0.85f ) );
 			@endcode
 		@remarks
-			Changing these settings can trigger a shader recompilation.
+			Changing the number of columns can trigger a shader recompilation.
+			The rest of the settings don't.
 			You *can* call syncChart() after build().
 			<br/>
 			You *can* call this function again if you wish to change settings.
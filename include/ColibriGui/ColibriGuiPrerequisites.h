@@ -61,6 +61,7 @@ COLIBRI_ASSUME_NONNULL_BEGIN
 /// @defgroup Api_Backend
 namespace Colibri
 {
+	struct BatchBreakStats;
 	class BmpFont;
 	class Button;
 	struct CachedGlyph;
@@ -73,6 +74,8 @@ namespace Colibri
 	class LayoutCell;
 	class LogListener;
 	class OffScreenCanvas;
+	struct OverdrawStats;
+	class Prefab;
 	class Progressbar;
 	class RadarChart;
 	class Renderable;
@@ -83,6 +86,7 @@ namespace Colibri
 	class SkinManager;
 	class Slider;
 	class Spinner;
+	class TextView;
 	class ToggleButton;
 	class Widget;
 	class Window;
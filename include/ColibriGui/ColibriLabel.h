@@ -36,6 +36,20 @@ namespace Colibri
 			float lastCharWidth;
 		};
 
+		/// A run of glyphs that can't be broken apart: a word, a word breaker (e.g. a
+		/// whitespace), a tab or a newline. Cached so re-wrapping needs no rescans.
+		struct BreakOpportunity
+		{
+			uint32_t offset;
+			uint32_t length;
+			/// Sum of the advances of all its glyphs
+			Ogre::Vector2 advance;
+			Ogre::Vector2 lastAdvance;
+			float lastCharWidth;
+		};
+
+		typedef std::vector<BreakOpportunity> BreakOpportunityVec;
+
 		typedef std::vector<uint32_t> PrivateAreaGlyphsVec;
 
 		std::string		m_text[States::NumStates];
@@ -44,6 +58,23 @@ namespace Colibri
 
 		bool m_glyphsDirty[States::NumStates];
 		bool m_glyphsPlaced[States::NumStates];
+
+		/// Derived from m_shapes. See updateBreakOpportunities
+		BreakOpportunityVec m_breakOpportunities[States::NumStates];
+		/// Largest newlineSize of each line delimited by newlines (i.e. not
+		/// counting word wrap), before applying m_lineHeightScale
+		std::vector<float> m_hardLineHeights[States::NumStates];
+		/// First glyph of each line delimited by newlines. See replaceText.
+		/// Empty when the text has RTL glyphs, as the newline is then not
+		/// necessarily the last glyph of its line.
+		std::vector<uint32_t> m_hardLineFirstGlyph[States::NumStates];
+		/// First UTF16 code unit of each line delimited by newlines. Same rules
+		/// as m_hardLineFirstGlyph
+		std::vector<uint32_t> m_hardLineStartUtf16[States::NumStates];
+		bool m_breakOpportunitiesDirty[States::NumStates];
+		/// Bounds used by the last placeGlyphs. Placing again with the same bounds
+		/// would produce the same result, so it can be skipped. Negative when unknown.
+		Ogre::Vector2 m_placedBounds[States::NumStates];
 #if COLIBRIGUI_DEBUG >= COLIBRIGUI_DEBUG_MEDIUM
 		bool m_glyphsAligned[States::NumStates];
 #endif
@@ -140,10 +171,28 @@ namespace Colibri
 	protected:
 		void flagDirty( States::States state );
 
-		/// Returns false when there are no more words (and output is now empty)
-		bool findNextWord( Word &inOutWord, States::States state ) const;
-		float findLineMaxHeight( ShapedGlyphVec::const_iterator start,
-								 States::States state ) const;
+		/** Rebuilds m_breakOpportunities & m_hardLineHeights from m_shapes if they're dirty.
+			Shaped glyphs don't change when the Label is resized, so this is done once after
+			shaping and then each re-wrap is a single linear pass over the cached data.
+		*/
+		void updateBreakOpportunities( States::States state );
+
+		/** Replaces the given UTF16 range of m_text[state] with newText, reshaping only the lines
+			(delimited by newlines) touched by the edit and splicing the result into m_shapes.
+		@remarks
+			Only possible when the state's glyphs are up to date, and there is a single RichText,
+			no RTL glyphs, no Private Use Area glyphs, and no vertical reading.
+		@return
+			False if the edit couldn't be performed this way. Nothing was modified then.
+		*/
+		bool spliceText( States::States state, size_t utf16Start, size_t utf16Length,
+						 const char *newText );
+
+		/// Returns the height of the given line (delimited by newlines) with line height scale applied
+		float getHardLineHeight( States::States state, size_t lineIdx ) const;
+
+		/// Returns the bounds placeGlyphs uses to wrap and align text, in pixels
+		Ogre::Vector2 getPlacementBounds() const;
 
 		colibri_virtual_l1 inline void addQuad( GlyphVertex * RESTRICT_ALIAS vertexBuffer,
 							 Ogre::Vector2 topLeft,
@@ -164,6 +213,13 @@ namespace Colibri
 
 		void _destroy() override;
 
+		/** Already shaped & placed glyphs are shared with dst (by increasing their ref count)
+			instead of shaping the text again. States that are dirty in 'this' will be
+			dirty in dst too.
+		*/
+		void _cloneSettingsTo( Widget *dst ) const override;
+		bool _isInternalChild( const Widget *child ) const override;
+
 		WidgetRenderType::WidgetRenderType getWidgetRenderType() const override
 		{
 			return WidgetRenderType::Label;
@@ -255,7 +311,9 @@ namespace Colibri
 		@remarks
 			This feature is controlled per Label, not per RichText entry.
 			There is no overhead for calling this function often.
-			Drawing the shadow may incur in higher GPU cost though, due to overdraw.
+			The shadow is evaluated in the pixel shader (a second fetch from the glyph atlas),
+			thus it does not add vertices. Each glyph's quad is enlarged to fit the shadow
+			(only when enabled). Labels with different shadows can't share the same draw.
 		@param enable
 			True to enable. False to disable.
 		@param shadowColour
@@ -274,6 +332,12 @@ namespace Colibri
 
 		const Ogre::Vector2 &getShadowDisplace() const { return m_shadowDisplace; }
 
+		/** Outputs the shadow as the shader expects it: [0] = RGBA8 colour,
+			[1] & [2] = displacement in pixels (as float), [3] = 0.
+			All zeroes when the shadow is disabled. See HlmsColibri::fillBuffersForColibri
+		*/
+		void _getShadowDrawData( uint32_t outData[4] ) const;
+
 		/** Called by ColibriManager after we've told them we're dirty.
 			It will update m_shapes so we can correctly render text.
 		*/
@@ -294,6 +358,25 @@ namespace Colibri
 		*/
 		void setText( const std::string &text, States::States forState=States::NumStates );
 
+		/** Replaces a range of the text with newText. Affects all states that currently
+			have the same text as the current state.
+
+			Unlike setText, only the lines (delimited by newlines) touched by the edit are
+			shaped again when possible; which keeps editing large multiline text fast.
+			Otherwise it falls back to setText.
+		@remarks
+			Rich Edit settings are preserved when the fast path is taken,
+			cleared otherwise (see setText).
+		@param utf16Start
+			Start of the range to replace, in UTF16 code units (see getGlyphStartUtf16).
+			Out of bounds values get clamped.
+		@param utf16Length
+			Length of the range to replace, in UTF16 code units. Can be 0 to just insert.
+		@param newText
+			Text to insert. Must be UTF8. Can be empty to just remove.
+		*/
+		void replaceText( size_t utf16Start, size_t utf16Length, const char *newText );
+
 		/// Returns the text for the given state. When state == States::NumStates, it
 		/// returns the text from the current state
 		const std::string& getText( States::States state=States::NumStates );
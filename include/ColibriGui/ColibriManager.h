@@ -1,6 +1,8 @@
 
 #pragma once
 
+#include "ColibriGui/ColibriBatchBreakStats.h"
+#include "ColibriGui/ColibriOverdrawStats.h"
 #include "ColibriGui/ColibriWidget.h"
 
 #include "OgreIdString.h"
@@ -168,6 +170,17 @@ namespace Colibri
 
 		typedef std::vector<DelayedDestruction> DelayedDestructionVec;
 
+		/// Region covered by an opaque main window. See Window::setOpaque
+		struct Occluder
+		{
+			Ogre::Vector2 topLeft;
+			Ogre::Vector2 bottomRight;
+			/// Index to m_windows. Only windows drawn before it are occluded.
+			size_t windowIdx;
+		};
+
+		typedef std::vector<Occluder> OccluderVec;
+
 	public:
 		static const std::string c_defaultTextDatablockNames[States::NumStates];
 
@@ -212,6 +225,8 @@ namespace Colibri
 		bool m_numGlyphsBmpDirty;
 
 		bool m_widgetTransformsDirty;
+		/// Position, size and derived transforms of every widget. See WidgetTransformStore
+		WidgetTransformStore m_transformStore;
 
 		/// Is any widget dirty
 		bool m_zOrderWidgetDirty;
@@ -287,8 +302,35 @@ namespace Colibri
 		UiVertex    *m_vertexBufferBase;
 		GlyphVertex *m_textVertexBufferBase;
 
-		/// Only used when m_multipass == true
-		std::vector<uint8_t> m_multipassTmpBuffer;
+		/// Only used when m_multipass == true. Vaos for the 2nd, 3rd, etc. pass of the
+		/// same frame, since a dynamic buffer can only be mapped once per frame.
+		/// The 1st pass uses m_vao & m_textVao. [0] = regular widgets, [1] = text
+		std::vector<Ogre::VertexArrayObject *> m_multipassVaos[2];
+		/// Vaos written by the last prepareRenderCommands. [0] = regular widgets, [1] = text
+		Ogre::VertexArrayObject *colibri_nullable m_passVaos[2];
+
+		/// True if the vertex data written by the last prepareRenderCommands can be
+		/// rendered again. See isLastFillReusable
+		bool     m_lastFillValid;
+		uint32_t m_lastFrameIdxFilled;
+
+		/// Hidden window holding the widgets used by prewarmMaterials. Nullptr if none.
+		Window *colibri_nullable m_prewarmWindow;
+		/// True while prewarmMaterials is waiting for the next render()
+		bool m_prewarmPending;
+
+		bool            m_batchBreakStatsEnabled;
+		BatchBreakStats m_batchBreakStats;
+
+		/// 0 when disabled. See setOverdrawStatsEnabled
+		uint32_t      m_overdrawStatsDownscale;
+		OverdrawStats m_overdrawStats;
+
+		/// Opaque main windows, sorted by windowIdx. Rebuilt by prepareRenderCommands
+		OccluderVec m_occluders;
+		/// Occluders in range [m_firstActiveOccluder; end) are in front of
+		/// the window currently being filled
+		size_t m_firstActiveOccluder;
 
 #if COLIBRIGUI_DEBUG >= COLIBRIGUI_DEBUG_MEDIUM
 		bool m_fillBuffersStarted;
@@ -312,8 +354,16 @@ namespace Colibri
 	protected:
 		void checkVertexBufferCapacity();
 
-		UiVertex    *getMultipassVertexBuffer( size_t numElements, size_t textNumElements );
-		GlyphVertex *getMultipassTextVertexBuffer( size_t numElements, size_t textNumElements );
+		/** Outputs the Vaos the given pass of the current frame must write to.
+			Creates them (or grows them) if needed.
+		@param passIdx
+			Number of passes of the current frame rendered before this one.
+		@param outVaos [in/out]
+			Must contain m_vao & m_textVao. Overwritten unless passIdx is 0.
+		*/
+		void getMultipassVaos( size_t passIdx,
+							   Ogre::VertexArrayObject *outVaos[colibri_nonnull 2] );
+		void destroyMultipassVaos();
 
 		template <typename T>
 		void autosetNavigation( const std::vector<T> &container, size_t start, size_t numWidgets );
@@ -333,8 +383,9 @@ namespace Colibri
 			Set this to true to allow rendering more than once in the same frame (otherwise you'll
 			get exceptions about mapping the same buffer twice in the same frame).
 
-			Recommended value for the main UI is false if you don't need it; since multipass is not
-			mobile-friendly and *might* be slower on Desktop too.
+			Each pass of the frame writes to its own persistently mapped vertex buffers
+			(created on demand), thus it costs extra GPU memory per pass.
+			Recommended value for the main UI is false if you don't need it.
 		@param bSecondary
 			If this value is set to true, you must call _setPrimary.
 			See OffScreenCanvas's implementation.
@@ -346,6 +397,66 @@ namespace Colibri
 		void loadSkins( const char *fullPath );
 		SkinManager* getSkinManager()								{ return m_skinManager; }
 
+		/** Generates the shaders & PSOs of every skin (in all states), Labels, CustomShapes
+			and GraphCharts up front.
+
+			Otherwise they get created the first time a widget with that material is drawn,
+			e.g. the first time the user hovers a button, causing a hitch.
+		@remarks
+			PSOs depend on the render target, thus the work is actually done the next time
+			this manager renders (i.e. from the CompositorPassColibriGui). Call it once skins
+			are loaded and fonts are set up.
+
+			The number of permutations created is logged.
+		@param maxGraphChartColumns
+			GraphChart needs one shader per number of columns. All counts
+			in range [1; maxGraphChartColumns] are prewarmed. 0 to skip GraphCharts.
+		*/
+		void prewarmMaterials( uint32_t maxGraphChartColumns = 0u );
+
+		/** Diagnostics. When enabled, every time rendering needs to start a new draw,
+			the reason and the widget responsible are recorded (see BatchBreakReason).
+			Useful to find out which layouts or skins are splitting batches.
+		@remarks
+			Has a small CPU cost per draw. Debug names (Widget::setDebugName)
+			are only available in debug builds.
+		@param bEnabled
+			True to enable. Default is false.
+		*/
+		void setBatchBreakStatsEnabled( bool bEnabled );
+		bool getBatchBreakStatsEnabled() const { return m_batchBreakStatsEnabled; }
+
+		/// Returns the stats of the last render() call. Empty if disabled.
+		/// See setBatchBreakStatsEnabled
+		const BatchBreakStats &getBatchBreakStats() const { return m_batchBreakStats; }
+
+		/// Logs the summary and per-window breakdown of getBatchBreakStats
+		void logBatchBreakStats() const;
+
+		/** Diagnostics. When enabled, prepareRenderCommands estimates how many times each
+			pixel gets shaded by rasterizing on the CPU the quads of every visible widget
+			and glyph (see OverdrawStats). Useful to find layouts that are expensive on
+			fill-rate bound GPUs (e.g. mobile). Does not need the GPU to render anything.
+		@remarks
+			Has a considerable CPU cost, and reads back from the mapped vertex buffers.
+			Only enable it while profiling.
+		@param bEnabled
+			True to enable. Default is false.
+		@param downscale
+			The analysis is done at the window resolution (see setCanvasSize) divided
+			by this value. Must be > 0.
+		*/
+		void setOverdrawStatsEnabled( bool bEnabled, uint32_t downscale = 4u );
+		bool getOverdrawStatsEnabled() const { return m_overdrawStatsDownscale != 0u; }
+
+		/// Returns the stats of the last prepareRenderCommands call. Empty if disabled.
+		/// Use OverdrawStats::saveHeatmap to dump them to an image.
+		/// See setOverdrawStatsEnabled
+		const OverdrawStats &getOverdrawStats() const { return m_overdrawStats; }
+
+		/// Logs the summary and per-window breakdown of getOverdrawStats
+		void logOverdrawStats() const;
+
 		ShaperManager* getShaperManager()							{ return m_shaperManager; }
 
 		/** This function allows to create secondary managers (i.e. for offscreen rendering)
@@ -661,6 +772,13 @@ namespace Colibri
 
 		void _setWidgetTransformsDirty();
 
+		/// For internal use. See Widget::m_transformStore
+		WidgetTransformStore &_getTransformStore() { return m_transformStore; }
+
+		/// Refreshes all widgets after the skins were modified in place.
+		/// See Widget::_notifySkinsChanged
+		void _notifySkinsChanged();
+
 		/// If creating a custom label widget, this must be called on creation.
 		void _notifyLabelCreated( Label* label );
 
@@ -685,10 +803,53 @@ namespace Colibri
 		/// Cannot be nullptr
 		void _stealKeyboardFocus( Widget *widget );
 
+		/// Creates the shader caches requested by prewarmMaterials. Called from render()
+		/// because PSOs depend on the pass we render to.
+		void prewarmPendingMaterials( ApiEncapsulatedObjects &apiObjects );
+
+		/// Fills m_occluders with the opaque main windows. Called from prepareRenderCommands
+		void gatherOccluders();
+
+		/** Returns true if the given rect (in NDC) is fully covered by an opaque
+			window drawn after the window currently being filled.
+			Only valid during prepareRenderCommands.
+		*/
+		bool _isOccluded( const Ogre::Vector2 &topLeft, const Ogre::Vector2 &bottomRight ) const
+		{
+			OccluderVec::const_iterator itor = m_occluders.begin() + ptrdiff_t( m_firstActiveOccluder );
+			OccluderVec::const_iterator endt = m_occluders.end();
+
+			while( itor != endt )
+			{
+				if( topLeft.x >= itor->topLeft.x && topLeft.y >= itor->topLeft.y &&
+					bottomRight.x <= itor->bottomRight.x && bottomRight.y <= itor->bottomRight.y )
+				{
+					return true;
+				}
+				++itor;
+			}
+
+			return false;
+		}
+
 		void update( float timeSinceLast );
 		void prepareRenderCommands();
 		void render();
 
+		/** Returns true if prepareRenderCommands was already called this frame and nothing
+			that affects the vertex data changed since (i.e. neither update nor
+			setCanvasSize were called). In that case render can be called again
+			without calling prepareRenderCommands first, e.g. to draw the same UI
+			to several views (split-screen, VR, mirrors).
+		@remarks
+			Changes to widgets made after prepareRenderCommands are not
+			tracked. They will not be visible until the next prepareRenderCommands.
+
+			Unlike calling prepareRenderCommands once per pass, this does not
+			require multipass (see ColibriManager::ColibriManager).
+		*/
+		bool isLastFillReusable() const;
+
 		const UiVertex* _getVertexBufferBase() const
 		{
 			COLIBRI_ASSERT_HIGH( m_fillBuffersStarted );
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "ColibriGui/ColibriGuiPrerequisites.h"
+
+#include <string>
+#include <vector>
+
+COLIBRI_ASSUME_NONNULL_BEGIN
+
+namespace Colibri
+{
+	struct UiVertex;
+	struct GlyphVertex;
+
+	struct WindowOverdraw
+	{
+		/// Only valid during the frame it was recorded.
+		Window const *window;
+		/// Widget::_getDebugName of window (empty in release builds)
+		std::string debugName;
+		/// Pixels shaded by the widgets of this window (child windows not included).
+		/// A pixel shaded twice counts twice
+		uint64_t numShadedPixels;
+		/// Number of quads (or triangle pairs, for CustomShapes) rasterized
+		uint32_t numQuads;
+	};
+
+	/** @class OverdrawStats
+		Estimates how many times each pixel is shaded by the UI, by rasterizing on the CPU,
+		at reduced resolution, the vertices written by _fillBuffersAndCommands.
+		See ColibriManager::setOverdrawStatsEnabled.
+	@remarks
+		Every quad counts, including transparent regions of skins and glyphs, as the GPU
+		must shade them too. Clipping is taken into account. Rotated widgets
+		and CustomShapes are approximated by their bounding rects.
+	*/
+	struct OverdrawStats
+	{
+		/// Resolution of counters
+		uint32_t width;
+		uint32_t height;
+		/// Number of times each pixel was shaded. Row-major, top row first.
+		/// Saturates at 65535
+		std::vector<uint16_t> counters;
+
+		/// Sum of all counters
+		uint64_t numShadedPixels;
+		/// Number of pixels shaded at least once
+		uint32_t numCoveredPixels;
+		/// Highest value in counters
+		uint16_t maxOverdraw;
+
+		/// One entry per visible window, in rendering order
+		std::vector<WindowOverdraw> windows;
+
+	protected:
+		template <typename T>
+		void addQuads( const T *vertices, size_t numVertices, size_t verticesPerQuad,
+					   WindowOverdraw &windowOverdraw );
+
+		void addWidget( const Widget *widget, size_t windowIdx,
+						const UiVertex *vertexBufferBase,
+						const GlyphVertex *textVertexBufferBase );
+
+	public:
+		OverdrawStats();
+
+		/// Resets all counters. Resizes them if the resolution changed
+		void clear( uint32_t newWidth, uint32_t newHeight );
+
+		/** Rasterizes the visible widgets of the given window and its child windows.
+			Must be called after the window was filled, while the vertex buffers
+			are still mapped.
+		*/
+		void addWindow( const Window *window, const UiVertex *vertexBufferBase,
+						const GlyphVertex *textVertexBufferBase );
+
+		/// Calculates numShadedPixels, numCoveredPixels and maxOverdraw.
+		/// Call after the last addWindow
+		void finish();
+
+		/// Returns the average number of times each pixel of the screen is shaded
+		float getAverageOverdraw() const;
+
+		/// Returns the average number of times each pixel covered by the UI is shaded.
+		/// 1.0 means no overdraw at all
+		float getAverageOverdrawOfCovered() const;
+
+		/// Logs a summary followed by the breakdown of each window
+		void log( LogListener *logListener ) const;
+
+		/** Saves counters as an RGBA8 image where black means not shaded, then
+			blue, green, yellow, orange & red as the number of times each pixel
+			is shaded goes from 1 to 5. Magenta for 6 or more.
+		@param fullpath
+			Path to the output file. The extension determines the format (e.g. png).
+		*/
+		void saveHeatmap( const std::string &fullpath ) const;
+	};
+}  // namespace Colibri
+
+COLIBRI_ASSUME_NONNULL_END
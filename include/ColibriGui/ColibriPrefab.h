@@ -0,0 +1,87 @@
+#pragma once
+
+#include "ColibriGui/ColibriWidget.h"
+
+COLIBRI_ASSUME_NONNULL_BEGIN
+
+namespace Colibri
+{
+	/** @class Prefab
+		Captures an already configured Widget tree (the template) so that it can be
+		instantiated many times with a single call. e.g. a row of a list made of a Button,
+		an icon, a few Labels, and a Progressbar.
+
+		Creating such a row by hand means dozens of calls, each looking up skins by name,
+		propagating dirty flags, and shaping text. Instantiating a Prefab instead copies the
+		settings of each widget directly (see Widget::_cloneSettingsTo):
+
+			- Skins are copied by pointer, without SkinManager lookups.
+			- Labels share the already shaped glyphs of the template (by increasing their
+			  ref count) instead of shaping the same text again.
+
+		Supported types are Widget, Renderable, Label and Button. Other types
+		(and their children) are skipped when capturing, and a warning is logged.
+	@remarks
+		The template must remain alive while the Prefab is in use, as its widgets are
+		used as the source of the copies. It is common to keep the template hidden
+		(see Widget::setHidden) and capture it once. The hidden flag of the root
+		is not copied to the instances.
+
+		Windows cannot be part of a Prefab.
+	*/
+	class Prefab
+	{
+		struct Node
+		{
+			Widget const *source;
+			/// Index to Prefab::m_nodes. Node 0 (the root) has no parent.
+			size_t parentIdx;
+		};
+
+		typedef std::vector<Node> NodeVec;
+
+		ColibriManager *colibri_nullable m_manager;
+		/// Depth-first order. m_nodes[0] is the root. Parents always go before their children.
+		NodeVec m_nodes;
+
+		void captureChildren( const Widget *widget, size_t widgetIdx );
+
+		/// Returns true if widget's type can be cloned. Logs a warning otherwise.
+		bool isSupported( const Widget *widget ) const;
+
+		/// Creates an empty widget of the same type as source
+		Widget *createSameType( const Widget *source, Widget *parent ) const;
+
+	public:
+		Prefab();
+
+		/** Captures the tree starting from root. The previous capture (if any) is discarded.
+		@param root
+			The template. Must not be a Window.
+		*/
+		void capture( const Widget *root );
+
+		/// Returns the number of widgets each instance will create
+		size_t getNumWidgets() const { return m_nodes.size(); }
+
+		/** Creates a copy of the captured tree.
+		@param parent
+			Parent of the new instance.
+		@return
+			Root of the new instance. Nullptr if nothing was captured.
+		*/
+		Widget *colibri_nullable instantiate( Widget *parent );
+
+		/** Creates numInstances copies of the captured tree.
+		@param parent
+			Parent of the new instances.
+		@param numInstances
+			Number of instances to create.
+		@param outRoots [out]
+			The root of each new instance is appended here.
+		*/
+		void instantiate( Widget *parent, size_t numInstances, WidgetVec &outRoots );
+	};
+}  // namespace Colibri
+
+COLIBRI_ASSUME_NONNULL_END
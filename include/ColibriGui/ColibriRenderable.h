@@ -75,12 +75,20 @@ namespace Colibri
 		//has arbitrary number of of vertices, thus we can't properly calculate the drawId and
 		//therefore the material ID)
 		Ogre::HlmsDatablock			*lastDatablock;
+		/// Same as lastDatablock, for the shadow of the text. See Label::_getShadowDrawData
+		uint32_t					lastTextShadow[4];
 		int							baseInstanceAndIndirectBuffers;
 		Ogre::CbDrawCallStrip		* colibri_nullable drawCmd;
 		Ogre::CbDrawStrip			* colibri_nullable drawCountPtr;
 		uint32_t primCount;
+		/// Vaos written by ColibriManager::prepareRenderCommands.
+		/// [0] = regular widgets, [1] = text
+		Ogre::VertexArrayObject *vaos[2];
 		uint32_t basePrimCount[2]; //[0] = regular widgets, [1] = text
 		uint32_t nextFirstVertex;
+		/// When not nullptr, every new draw is recorded here along with its reason.
+		/// See ColibriManager::setBatchBreakStatsEnabled
+		BatchBreakStats *colibri_nullable batchBreakStats;
 	};
 
 	/**
@@ -95,7 +103,14 @@ namespace Colibri
 	class Renderable : public Widget, public Ogre::ColibriOgreRenderable
 	{
 	protected:
-		StateInformation m_stateInformation[States::NumStates];
+		/// Points to data owned by SkinManager (or by whoever called _setSkinPack),
+		/// which is shared by all Renderables using the same skin.
+		/// When a Renderable needs to modify its skin (e.g. setBorderSize)
+		/// it points to its own copy in m_stateInfoOverride instead.
+		/// See getOverridableStateInformation.
+		StateInformation const *m_stateInformation[States::NumStates];
+		/// Array of States::NumStates. Nullptr until a state needs to be overriden.
+		StateInformation *colibri_nullable m_stateInfoOverride;
 
 		bool              m_overrideSkinColour;
 		Ogre::ColourValue m_colour;
@@ -139,11 +154,40 @@ namespace Colibri
 							 Matrix2x3 parentRot );
 
 		void _notifyCanvasChanged() override;
+		void _notifySkinsChanged() override;
 
 		void stateChanged( States::States newState ) override;
 
+		/** Sets the datablock of the given skin material, unless the current one produces
+			the exact same output (same textures, samplers, blending, colour, etc.).
+
+			Per-state UVs and colour are already sent per vertex, so when all states of a
+			skin sample from the same texture (e.g. a skin atlas) changing the state
+			(e.g. highlighting a button) only changes vertices. Swapping the datablock
+			instead would recalculate the Hlms hash, and could split the batch.
+		*/
+		void setDatablockFromSkin( Ogre::IdString materialName );
+
+		/** Copy-on-write. Returns a StateInformation for the given state that can be modified
+			without affecting other Renderables sharing the same skin. Copies the current
+			skin data into m_stateInfoOverride the first time it's called for that state.
+		@remarks
+			The override is lost the next time the skin is changed for that state.
+		*/
+		StateInformation &getOverridableStateInformation( States::States state );
+
 	public:
 		Renderable( ColibriManager *manager );
+		~Renderable() override;
+
+		/** Returns true if both datablocks would render exactly the same given the same vertices.
+		@param bIgnoreSlot0
+			When true, the textures in slot 0 are not compared (the rest of that slot's
+			settings still are). See SkinManager::buildSkinAtlas.
+		*/
+		static bool areDatablocksInterchangeable( const Ogre::HlmsDatablock *a,
+												  const Ogre::HlmsDatablock *b,
+												  bool bIgnoreSlot0 = false );
 
 		/** Disables drawing this widget, but it is still active. That means you can click on it,
 			highlight it, navigate to it via the keyboard, etc; as if everything were normal.
@@ -163,6 +207,12 @@ namespace Colibri
 		void setVisualsEnabled( bool bEnabled );
 		bool isVisualsEnabled() const final;
 
+		/// Number of vertices written by the last _fillBuffersAndCommands
+		uint32_t _getNumVertices() const { return m_numVertices; }
+		/// Where the last _fillBuffersAndCommands started writing, relative to
+		/// ColibriManager::_getVertexBufferBase (or _getTextVertexBufferBase for Labels)
+		uint32_t _getVertexBufferOffset() const { return m_currVertexBufferOffset; }
+
 		/** Sets a custom colour
 		@param overrideSkinColour
 			When false, we ignore 'colour' argument and reset back to using the skin's default
@@ -209,6 +259,11 @@ namespace Colibri
 							bool bClipBordersMatchSkin = true );
 
 		/** Directly set the skins via pointers instead of requiring map lookups.
+		@remarks
+			Skin data is not copied, we keep pointing to skinInfo[i]->stateInfo.
+			Therefore skinInfo[i] must outlive its use by this Renderable.
+			Skins owned by SkinManager always do.
+			Use setStateInformation if you need to set a skin built on the fly.
 		@param skinInfo
 			Must not be null.
 			skinInfo[i] can be null
@@ -216,8 +271,21 @@ namespace Colibri
 		*/
 		void _setSkinPack( SkinInfo const * colibri_nonnull const * colibri_nullable skinInfos );
 
+		/** Sets a custom skin built by the user. Unlike _setSkinPack, the data is copied
+			(i.e. it's treated as an override, see getOverridableStateInformation).
+		@param stateInfo
+			Skin data to use.
+		@param forState
+			The state to use, use special value States::NumStates to set it to all states
+		*/
+		void setStateInformation( const StateInformation &stateInfo,
+								  States::States forState = States::NumStates );
+
 		void setState( States::States state, bool smartHighlight=true ) override;
 
+		/// Skins are copied by pointer (no map lookups)
+		void _cloneSettingsTo( Widget *dst ) const override;
+
 		/** Calls setClipBorders and makes the clipping region to match that of the current skin
 
 			IMPORTANT: Skins' border size is dependent on real resolution (not canvas), thus
@@ -51,13 +51,26 @@ namespace Colibri
 
 	typedef std::map<Ogre::IdString, SkinInfo> SkinInfoMap;
 	typedef std::map<Ogre::IdString, SkinPack> SkinPackMap;
+	typedef std::map<Ogre::IdString, StateInformation> StateInformationMap;
 
 	class SkinManager
 	{
 		ColibriManager	*m_colibriManager;
+		/// Renderables point directly to SkinInfo::stateInfo. Thus entries
+		/// must never be removed, otherwise those pointers would dangle.
 		SkinInfoMap		m_skins;
 		SkinPackMap		m_skinPacks;
 
+		/// See getDefaultStateInformation
+		StateInformationMap m_defaultStateInfos;
+
+		bool		m_packSkinsIntoAtlas;
+		uint32_t	m_skinAtlasMaxResolution;
+		/// Every atlas built by buildSkinAtlas. Older ones are kept alive because
+		/// existing widgets may still be using them.
+		std::vector<Ogre::TextureGpu *> m_skinAtlasTextures;
+		std::vector<Ogre::IdString> m_skinAtlasDatablocks;
+
 		inline Ogre::Vector2 getVector2Array( const rapidjson::Value &jsonArray );
 		inline Ogre::Vector4 getVector4Array( const rapidjson::Value &jsonArray );
 
@@ -70,7 +83,8 @@ namespace Colibri
 									   StateInformation &stateInfo,
 									   const char *skinName, const char *filename );
 
-		void loadSkins( const rapidjson::Value &skinsValue, const char *filename );
+		/// Returns true if at least one existing skin was overwritten
+		bool loadSkins( const rapidjson::Value &skinsValue, const char *filename );
 		void loadSkinPacks( const rapidjson::Value &packsValue, const rapidjson::Value &skinsValue,
 							const char *filename );
 		void loadDefaultSkinPacks( const rapidjson::Value &packsValue, const char *filename );
@@ -83,6 +97,15 @@ namespace Colibri
 			return m_colibriManager == colibriManager;
 		}
 
+		/** Returns a blank StateInformation (no UVs, no borders, white colour) which uses
+			the given material. The returned pointer is shared by everyone who asks for
+			the same material and remains valid until SkinManager is destroyed.
+
+			Useful for widgets that don't use skins (e.g. Labels) so that they don't need
+			their own copy of StateInformation.
+		*/
+		StateInformation const *getDefaultStateInformation( Ogre::IdString materialName );
+
 		const SkinInfoMap &getSkins() const { return m_skins; }
 		const SkinPackMap &getSkinPacks() const { return m_skinPacks; }
 
@@ -111,6 +134,59 @@ namespace Colibri
 						findSkin( const SkinPack &pack, States::States state,
 								  LogSeverity::LogSeverity logSeverity = LogSeverity::Warning ) const;
 
+		/** When enabled, every loadSkins call ends with a call to buildSkinAtlas.
+		@param bPack
+			True to enable. Default is false.
+		@param maxResolution
+			See buildSkinAtlas.
+		*/
+		void setPackSkinsIntoAtlas( bool bPack, uint32_t maxResolution = 4096u );
+		bool getPackSkinsIntoAtlas() const { return m_packSkinsIntoAtlas; }
+
+		/** Packs the textures used by all loaded skins into a single texture (the atlas),
+			remaps the skins' UVs into it, and makes them all use a single datablock.
+
+			Renderable::_addCommands must start a new draw every time the datablock changes.
+			When each skin uses its own material, a window mixing buttons, checkboxes, sliders
+			and frames ends up split into many draws. Once skins share the atlas, widgets
+			can be batched together regardless of their type or state.
+
+			The whole texture of each material is copied (GPU to GPU), thus it works with
+			any skin layout. Materials are only merged if they're compatible with the first
+			one found, i.e. they'd render the same if they sampled the same diffuse texture
+			(blendblock, macroblock, colour, samplerblocks, other texture slots, etc.)
+			and have the same pixel format. The atlas has no mipmaps, thus textures with
+			mipmaps aren't packed either. Skins using other materials (or materials
+			without a texture) are left untouched.
+		@remarks
+			Existing widgets of the manager that owns this SkinManager are refreshed to use
+			the atlas (see ColibriManager::_notifySkinsChanged). Managers sharing this
+			SkinManager (e.g. OffScreenCanvas) must call _notifySkinsChanged themselves.
+
+			It can be called again after loading more skins. Previous atlases are treated
+			as one more texture to pack.
+		@param maxResolution
+			Maximum width and height of the atlas. If the textures don't fit, nothing
+			is done and an error is logged.
+		@return
+			True if the atlas was built.
+		*/
+		bool buildSkinAtlas( uint32_t maxResolution = 4096u );
+
+		/// Returns the most recent atlas built by buildSkinAtlas. Nullptr if none.
+		Ogre::TextureGpu *colibri_nullable getSkinAtlasTexture() const;
+
+		/// For internal use. Destroys all the atlases and their datablocks.
+		/// Skins pointing to them are left dangling.
+		void _destroySkinAtlases();
+
+		/** Loads skins, skin packs and default skin packs from JSON.
+		@remarks
+			Skins can be reloaded (i.e. a skin with the same name is loaded again) while
+			widgets use them. They're overwritten in place and the widgets of the manager
+			that owns this SkinManager are refreshed (see ColibriManager::_notifySkinsChanged).
+			Managers sharing this SkinManager must call _notifySkinsChanged themselves.
+		*/
 		void loadSkins( const char *fullPath );
 		void loadSkins( const char *jsonString, const char *filename );
 	};
@@ -0,0 +1,197 @@
+#pragma once
+
+#include "ColibriGui/ColibriWidget.h"
+
+#include "ColibriGui/Text/ColibriShaper.h"
+
+COLIBRI_ASSUME_NONNULL_BEGIN
+
+namespace Colibri
+{
+	/** @ingroup Controls
+	@class TextView
+		Displays large amounts of text (e.g. a quest log, a chat or a combat log).
+
+		A single Label holds its whole string in one ShapedGlyphVec, thus any change
+		reshapes the entire text. TextView instead stores its text as paragraphs
+		(separated by newlines), each shaped independently by its own Label.
+		Glyphs are shared via the ShaperManager's ref count as usual:
+
+			- Appending a paragraph only shapes that paragraph.
+			- Changing or removing a paragraph only shapes that paragraph (if any), then
+			  repositions the ones below it without reshaping them.
+			- A change of width re-wraps every paragraph, but it's deferred until
+			  the next ColibriManager::update (i.e. once per frame while drag-resizing)
+			  and never reshapes.
+			- Only the paragraphs intersecting the visible region are visited when
+			  updating transforms and filling the vertex buffers. Finding them is a
+			  binary search.
+
+		TextView scrolls vertically on its own (see setScroll); it does not need a Window
+		to do so. Its paragraphs are Labels that it creates and destroys itself. Other
+		children are not supported.
+	*/
+	class TextView : public Widget
+	{
+	protected:
+		/// Paragraph labels, from top to bottom
+		std::vector<Label *> m_paragraphs;
+		/// Top of each paragraph, relative to our top-left. Always sorted.
+		/// May not start at 0 (see removeParagraphs)
+		std::vector<float> m_paragraphTops;
+
+		/// Bottom of the last paragraph, relative to our top-left
+		float m_contentBottom;
+		/// Vertical scroll (x is always 0). Absolute, i.e. in range
+		/// [m_paragraphTops.front(); m_contentBottom - visible height]
+		Ogre::Vector2 m_currentScroll;
+		float m_paragraphSpacing;
+
+		/// Width the paragraphs were last wrapped with
+		float m_wrappedWidth;
+		/// Paragraphs in range [m_firstDirtyParagraph; end) need to be repositioned
+		size_t m_firstDirtyParagraph;
+		/// When true, all paragraphs must be wrapped again (e.g. the width changed)
+		bool m_rewrapPending;
+
+		bool m_autoScrollToBottom;
+		size_t m_maxParagraphs;
+
+		FontSize m_defaultFontSize;
+		uint16_t m_defaultFont;
+		Ogre::ColourValue m_defaultColour;
+
+		/// Paragraphs in range [m_visibleBegin; m_visibleEnd) were visited by the last
+		/// _fillBuffersAndCommands. The rest are culled.
+		size_t m_visibleBegin;
+		size_t m_visibleEnd;
+
+		/// Wraps the given paragraph to fit our current width. Shapes it first if needed.
+		void wrapParagraph( Label *paragraph );
+
+		/// Flags the paragraphs from m_visibleBegin to m_visibleEnd as culled
+		void cullVisibleParagraphs();
+
+		/// Outputs the range of paragraphs intersecting the visible region
+		void getVisibleParagraphs( size_t &outBegin, size_t &outEnd ) const;
+
+		float getMinScroll() const;
+
+		/// Clamps the scroll to the valid range. Or moves it to the bottom if toBottom is true
+		void clampScroll( bool toBottom );
+
+		/// Subtracts the top of the first paragraph from every paragraph, so that
+		/// positions don't grow unbounded after removing from the front for a long time
+		void rebaseParagraphs();
+
+	public:
+		TextView( ColibriManager *manager );
+
+		void _initialize() override;
+		void _destroy() override;
+
+		bool _isInternalChild( const Widget *child ) const override;
+
+		/** Adds a new paragraph at the bottom. Only this paragraph is shaped.
+		@param text
+			Text of the paragraph. It should not contain newlines.
+			An empty string produces an empty line (it is stored as a single space
+			so that it keeps the height of a line).
+		@return
+			Index of the new paragraph
+		*/
+		size_t appendParagraph( const std::string &text );
+
+		/// Replaces the text of an existing paragraph. Only this paragraph is reshaped.
+		void setParagraphText( size_t idx, const std::string &text );
+
+		/// Returns the text of the given paragraph
+		const std::string &getParagraphText( size_t idx ) const;
+
+		/** Returns the Label used to display the given paragraph, e.g. for setting
+			rich text or a different colour. Do not destroy it or change its transform.
+		*/
+		Label *getParagraphLabel( size_t idx );
+
+		/** Removes count paragraphs starting from first.
+			Removing from the front (e.g. trimming a log) does not reposition
+			the rest of the paragraphs.
+		*/
+		void removeParagraphs( size_t first, size_t count );
+
+		/// Removes all paragraphs
+		void clear();
+
+		size_t getNumParagraphs() const { return m_paragraphs.size(); }
+
+		/** Replaces all the text. It is split into paragraphs at each newline.
+			Prefer appendParagraph & setParagraphText for incremental changes.
+		*/
+		void setText( const std::string &text );
+
+		/** When the number of paragraphs exceeds this value, the oldest ones
+			(i.e. at the top) are removed.
+		@param maxParagraphs
+			0 for no limit. Default is 0.
+		*/
+		void setMaxParagraphs( size_t maxParagraphs );
+		size_t getMaxParagraphs() const { return m_maxParagraphs; }
+
+		/// When true (default), if the view was scrolled to the bottom it
+		/// stays at the bottom when paragraphs are added. Useful for logs.
+		void setAutoScrollToBottom( bool autoScroll ) { m_autoScrollToBottom = autoScroll; }
+		bool getAutoScrollToBottom() const { return m_autoScrollToBottom; }
+
+		/// Extra vertical space between paragraphs, in virtual canvas units
+		void setParagraphSpacing( float spacing );
+		float getParagraphSpacing() const { return m_paragraphSpacing; }
+
+		/// Applies to all existing paragraphs (reshaping them all) and new ones
+		void setDefaultFontSize( FontSize defaultFontSize );
+		FontSize getDefaultFontSize() const { return m_defaultFontSize; }
+
+		/// Applies to all existing paragraphs (reshaping them all) and new ones
+		void setDefaultFont( uint16_t defaultFont );
+		uint16_t getDefaultFont() const { return m_defaultFont; }
+
+		/// Applies to all existing paragraphs and new ones
+		void setTextColour( const Ogre::ColourValue &colour );
+		const Ogre::ColourValue &getTextColour() const { return m_defaultColour; }
+
+		/** Sets the vertical scroll, in virtual canvas units.
+		@param scroll
+			Clamped to range [0; getMaxScroll()]
+		*/
+		void setScroll( float scroll );
+		float getScroll() const;
+		float getMaxScroll() const;
+		void scrollToBottom();
+		/// Returns true if the view is scrolled all the way down
+		bool isAtBottom() const;
+
+		/// Returns the height of all paragraphs together, in virtual canvas units
+		float getContentHeight() const;
+
+		/** Repositions (and re-wraps if the width changed) the paragraphs that need it.
+			Called automatically by ColibriManager::update. Call it manually if you need
+			getContentHeight or getMaxScroll to be up to date right away.
+		*/
+		void updateLayout();
+
+		const Ogre::Vector2 &getCurrentScroll() const override;
+
+		void setTransformDirty( uint32_t dirtyReason ) override;
+
+		void _update( float timeSinceLast ) override;
+
+		void _fillBuffersAndCommands( UiVertex *colibri_nonnull *colibri_nonnull RESTRICT_ALIAS
+																				vertexBuffer,
+									  GlyphVertex *colibri_nonnull *colibri_nonnull RESTRICT_ALIAS
+																				textVertBuffer,
+									  const Ogre::Vector2 &parentPos,
+									  const Ogre::Vector2 &parentCurrentScrollPos,
+									  const Matrix2x3 &parentRot ) override;
+	};
+}  // namespace Colibri
+
+COLIBRI_ASSUME_NONNULL_END
@@ -3,6 +3,8 @@
 
 #include "ColibriGui/ColibriGuiPrerequisites.h"
 
+#include "ColibriGui/ColibriWidgetTransformStore.h"
+
 #include "ColibriGui/Layouts/ColibriLayoutCell.h"
 
 #include "OgreVector2.h"
@@ -39,24 +41,6 @@ namespace Colibri
 			refCount( 0 ), listener( _listener ) {}
 	};
 
-	struct Matrix2x3
-	{
-		float m[2][3];
-
-		static const Matrix2x3 IDENTITY;
-
-		Matrix2x3() {}
-		Matrix2x3( float m00, float m01, float m02, float m10, float m11, float m12 )
-		{
-			m[0][0] = m00;
-			m[0][1] = m01;
-			m[0][2] = m02;
-			m[1][0] = m10;
-			m[1][1] = m11;
-			m[1][2] = m12;
-		}
-	};
-
 	typedef std::vector<WidgetListenerPair> WidgetListenerPairVec;
 
 	namespace WidgetRenderType
@@ -77,6 +61,9 @@ namespace Colibri
 		friend class Renderable;
 		friend class Label;
 		friend class LabelBmp;
+		friend class Prefab;
+		friend class TextView;
+		friend class WidgetTransformStore;
 
 		struct WidgetActionListenerRecord
 		{
@@ -88,6 +75,18 @@ namespace Colibri
 
 		typedef std::vector<WidgetActionListenerRecord> WidgetActionListenerRecordVec;
 
+		/// Data that is rarely accessed (i.e. not every frame) and that most widgets don't use.
+		/// Kept out of line so that per-frame traversals (transforms, culling, filling vertex
+		/// buffers) touch less memory per Widget.
+		struct ColdData
+		{
+			WidgetListenerPairVec			listeners;
+			WidgetActionListenerRecordVec	actionListeners;
+#if COLIBRIGUI_DEBUG >= COLIBRIGUI_DEBUG_MEDIUM
+			std::string debugName;
+#endif
+		};
+
 		/// Child and parent relationships are explicit, thus they're not tracked via
 		/// WidgetListener::notifyWidgetDestroyed
 		/// Can only be nullptr if 'this' is a Window.
@@ -106,6 +105,17 @@ namespace Colibri
 
 		ColibriManager          *m_manager;
 
+		/// Our position, size, orientation, derived transforms and clipping live in
+		/// m_transformStore (owned by m_manager) at index m_transformId, so that
+		/// ColibriManager::updateAllDerivedTransforms can update them in a linear pass.
+		/// Use the accessors below (e.g. _position()) to read & write them.
+		/// m_transformId may change whenever the store gets reordered.
+		WidgetTransformStore *m_transformStore;
+		uint32_t              m_transformId;
+
+		/// See Widget::ColdData. Nullptr until needed.
+		ColdData * colibri_nullable m_coldData;
+
 		Widget * colibri_nullable	m_nextWidget[Borders::NumBorders];
 		bool							m_autoSetNextWidget[Borders::NumBorders];
 		bool					m_hidden;
@@ -130,8 +140,6 @@ namespace Colibri
 		/// If the cursor is interacting with this widget, no scroll can take place if this is true.
 		/// This is useful for widgets which require some sort of mouse movement to function.
 		bool					m_consumesScroll;
-
-		bool m_culled;
 	public:
 		/// When true, this widgets and its children will be rendered in breadth first
 		/// order, instead of depth first.
@@ -169,31 +177,31 @@ namespace Colibri
 		/// @see	Widget::isUltimatelyBreadthFirst
 		bool m_breadthFirst;
 
+		/// When true, our children may be drawn in a different order than they
+		/// appear in the tree, so that children with the same material and shader
+		/// get drawn one after the other.
+		///
+		/// Unlike m_breadthFirst, this is safe even if widgets overlap: children whose
+		/// rectangles overlap are still drawn in tree order relative to each other.
+		/// Each child is moved along with its whole subtree.
+		///
+		/// It only affects depth first rendering (it is ignored when this widget
+		/// or a parent is breadth first). Children with more than
+		/// c_maxReorderedSiblings siblings are drawn in tree order.
+		///
+		/// @remark	PUBLIC MEMEBER: CAN BE EDITED DIRECTLY
+		/// @see	Widget::addChildrenCommandsReordered
+		bool m_reorderChildrenForBatching;
+
 		/// A value for any sort of use. Colibri does not use it in any way.
 		uint64_t m_userId;
 
 	protected:
 		States::States			m_currentState;
 
-		WidgetListenerPairVec			m_listeners;
-		WidgetActionListenerRecordVec	m_actionListeners;
-
-		Ogre::Vector2	m_position;
-		Ogre::Vector2	m_size;
-		Ogre::Vector4	m_orientation; // 2x2 matrix
-
-		Ogre::Vector2	m_derivedTopLeft;
-		Ogre::Vector2	m_derivedBottomRight;
-		Matrix2x3		m_derivedOrientation;
-
 		Ogre::Vector2	m_clipBorderTL;
 		Ogre::Vector2	m_clipBorderBR;
 
-		/// Without m_accumMinClipTL & m_accumMaxClipBR, 'this' will be visible
-		/// even if our parent is partially obscured by our parent's parent
-		Ogre::Vector2	m_accumMinClipTL;
-		Ogre::Vector2	m_accumMaxClipBR;
-
 		/// When true the current widget needs to have its children reordered.
 		/// A widget can still have dirty children but not need its list reordered,
 		/// for instance if the dirty widgets are further down the tree.
@@ -203,12 +211,65 @@ namespace Colibri
 		uint16_t	m_zOrder;
 
 #if COLIBRIGUI_DEBUG >= COLIBRIGUI_DEBUG_MEDIUM
-		bool	m_transformOutOfDate;
 		bool	m_destructionStarted;
-
-		std::string m_debugName;
 #endif
 
+		Ogre::Vector2 &_position() { return m_transformStore->m_position[m_transformId]; }
+		Ogre::Vector2 &_size() { return m_transformStore->m_size[m_transformId]; }
+		/// 2x2 matrix
+		Ogre::Vector4 &_orientation() { return m_transformStore->m_orientation[m_transformId]; }
+		Ogre::Vector2 &_derivedTopLeft() { return m_transformStore->m_derivedTopLeft[m_transformId]; }
+		Ogre::Vector2 &_derivedBottomRight()
+		{
+			return m_transformStore->m_derivedBottomRight[m_transformId];
+		}
+		Matrix2x3 &_derivedOrientation()
+		{
+			return m_transformStore->m_derivedOrientation[m_transformId];
+		}
+		/// Without _accumMinClipTL & _accumMaxClipBR, 'this' will be visible
+		/// even if our parent is partially obscured by our parent's parent
+		Ogre::Vector2 &_accumMinClipTL() { return m_transformStore->m_accumMinClipTL[m_transformId]; }
+		Ogre::Vector2 &_accumMaxClipBR() { return m_transformStore->m_accumMaxClipBR[m_transformId]; }
+		uint8_t       &_culled() { return m_transformStore->m_culled[m_transformId]; }
+
+		const Ogre::Vector2 &_position() const { return m_transformStore->m_position[m_transformId]; }
+		const Ogre::Vector2 &_size() const { return m_transformStore->m_size[m_transformId]; }
+		const Ogre::Vector4 &_orientation() const
+		{
+			return m_transformStore->m_orientation[m_transformId];
+		}
+		const Ogre::Vector2 &_derivedTopLeft() const
+		{
+			return m_transformStore->m_derivedTopLeft[m_transformId];
+		}
+		const Ogre::Vector2 &_derivedBottomRight() const
+		{
+			return m_transformStore->m_derivedBottomRight[m_transformId];
+		}
+		const Matrix2x3 &_derivedOrientation() const
+		{
+			return m_transformStore->m_derivedOrientation[m_transformId];
+		}
+		const Ogre::Vector2 &_accumMinClipTL() const
+		{
+			return m_transformStore->m_accumMinClipTL[m_transformId];
+		}
+		const Ogre::Vector2 &_accumMaxClipBR() const
+		{
+			return m_transformStore->m_accumMaxClipBR[m_transformId];
+		}
+
+		/// Copies m_clipBorderTL, m_clipBorderBR and getCurrentScroll() to m_transformStore.
+		/// Must be called whenever any of them changes.
+		void syncTransformClipping();
+
+		/// Returns m_coldData. Creates it if it doesn't exist.
+		ColdData &getColdData();
+		/// Returns m_coldData. Nullptr if it was never created.
+		ColdData *colibri_nullable getColdDataIfExists() const;
+
+		/// m_coldData must not be nullptr
 		WidgetListenerPairVec::iterator findListener( WidgetListener *listener );
 
 		static Ogre::Vector2 mul( const Ogre::Vector4 &m2x2, Ogre::Vector2 xyPos );
@@ -280,12 +341,27 @@ namespace Colibri
 		virtual void _initialize();
 		virtual void _destroy();
 
+		/** Copies our settings (transform, flags, layout cell, state, skins, text, etc)
+			into dst. Used by Prefab to instantiate widgets in bulk.
+			Children are not copied, except for those considered internal (see _isInternalChild)
+		@param dst
+			Freshly created widget. Must be of the exact same type as 'this'.
+		*/
+		virtual void _cloneSettingsTo( Widget *dst ) const;
+
+		/// Returns true if child was created by 'this' as part of its own implementation
+		/// (e.g. Button's Label). _cloneSettingsTo takes care of these, thus
+		/// Prefab must not clone them as regular children.
+		virtual bool _isInternalChild( const Widget *child ) const { return false; }
+
 		/// Do not call directly. 'this' cannot be a Window
 		void _setParent( Widget *parent );
 		Widget * colibri_nonnull getParent() const				{ return m_parent; }
 
 		virtual bool isRenderable() const { return false; }
 		virtual bool isWindow() const { return false; }
+		/// True if it was skipped by the last _fillBuffersAndCommands (e.g. out of view)
+		bool         _isCulled() const { return m_transformStore->m_culled[m_transformId] != 0u; }
 		bool         isLabel() const { return getWidgetRenderType() == WidgetRenderType::Label; }
 		virtual bool isLabelBmp() const { return false; }
 
@@ -499,13 +575,14 @@ namespace Colibri
 		/// Input must be in NDC space i.e. in range [-1; 1]
 		bool intersects( const Ogre::Vector2 &posNdc ) const;
 
+		/// Returns true if our derived rectangle overlaps with the other's.
+		/// Touching edges don't count as overlapping.
+		bool overlapsWith( const Widget *other ) const;
+
 		FocusPair _setIdleCursorMoved( const Ogre::Vector2 &newPosNdc );
 
 		virtual void broadcastNewVao( Ogre::VertexArrayObject *vao, Ogre::VertexArrayObject *textVao );
 
-		virtual void _updateDerivedTransformOnly( const Ogre::Vector2 &parentPos,
-												  const Matrix2x3 &parentRot );
-
 		/** Fills vertexBuffer & textVertBuffer for rendering, perfoming occlussion culling.
 			It also updates derived transforms. Derived classes change their functionality.
 			This function is mostly relevant in Renderable and its derived classes
@@ -553,6 +630,17 @@ namespace Colibri
 		*/
 		void addChildrenCommands( ApiEncapsulatedObjects &apiObject, bool collectingBreadthFirst );
 
+		/// Max number of renderable siblings m_reorderChildrenForBatching can handle.
+		/// The cost is quadratic in the number of siblings.
+		static const size_t c_maxReorderedSiblings;
+
+		/** Depth first rendering, but our renderable children are drawn in a greedy order
+			that keeps together those with the same Hlms hash and datablock, while respecting
+			tree order between children that overlap.
+			@see	Widget::m_reorderChildrenForBatching
+		*/
+		void addChildrenCommandsReordered( ApiEncapsulatedObjects &apiObject );
+
 		static bool _compareWidgetZOrder( const Widget* w1, const Widget* w2 )
 		{
 			return w1->_getZOrderInternal() < w2->_getZOrderInternal();
@@ -645,10 +733,10 @@ namespace Colibri
 		*/
 		Ogre::Vector2 getCenterIgnoringBorder() const;
 
-		const Ogre::Vector2& getLocalTopLeft() const			{ return m_position; }
-		Ogre::Vector2 getLocalBottomRight() const				{ return m_position + m_size; }
-		const Ogre::Vector2& getSize() const					{ return m_size; }
-		const Ogre::Vector4& getOrientation() const				{ return m_orientation; }
+		Ogre::Vector2 getLocalTopLeft() const					{ return _position(); }
+		Ogre::Vector2 getLocalBottomRight() const				{ return _position() + _size(); }
+		Ogre::Vector2 getSize() const							{ return _size(); }
+		Ogre::Vector4 getOrientation() const					{ return _orientation(); }
 
 		/** Establishes the clipping area to apply to our children widgets. Childrens
 			will be clipped against:
@@ -679,9 +767,9 @@ namespace Colibri
 		@param clipBorders
 		*/
 		void setClipBorders( float clipBorders[colibri_nonnull Borders::NumBorders] );
-		/// Returns m_position + clipBorderTopLeft; aka where the working area for children starts
+		/// Returns getLocalTopLeft() + clipBorderTopLeft; aka where the working area for children starts
 		Ogre::Vector2 getTopLeftAfterClipping() const;
-		/// Returns m_position + m_size - clipBorderBottomRight;
+		/// Returns getLocalBottomRight() - clipBorderBottomRight;
 		/// aka where the working area for children ends
 		Ogre::Vector2 getBottomRightAfterClipping() const;
 		/// Sets the size of the working area.
@@ -738,6 +826,10 @@ namespace Colibri
 
 		virtual void _notifyCanvasChanged();
 
+		/// Called when the skins were modified in place (e.g. SkinManager::buildSkinAtlas).
+		/// Refreshes whatever was derived from them, then notifies the children.
+		virtual void _notifySkinsChanged();
+
 		ColibriManager *getManager();
 
 		/// Notify the widget that the cursor moved somewhere within its bounds.
@@ -750,9 +842,9 @@ namespace Colibri
 			at the top left corner, while the top left function will return a value
 			at the bottom right corner.
 		*/
-		const Ogre::Vector2 &getDerivedTopLeft() const;
-		const Ogre::Vector2 &getDerivedBottomRight() const;
-		const Matrix2x3 &    getDerivedOrientation() const;
+		Ogre::Vector2 getDerivedTopLeft() const;
+		Ogre::Vector2 getDerivedBottomRight() const;
+		Matrix2x3     getDerivedOrientation() const;
 		Ogre::Vector2 getDerivedCenter() const;
 
 		/// Does not consider child windows
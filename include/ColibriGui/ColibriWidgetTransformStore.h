@@ -0,0 +1,118 @@
+#pragma once
+
+#include "ColibriGui/ColibriGuiPrerequisites.h"
+
+#include "OgreVector2.h"
+#include "OgreVector4.h"
+
+#include <vector>
+
+COLIBRI_ASSUME_NONNULL_BEGIN
+
+namespace Colibri
+{
+	struct Matrix2x3
+	{
+		float m[2][3];
+
+		static const Matrix2x3 IDENTITY;
+
+		Matrix2x3() {}
+		Matrix2x3( float m00, float m01, float m02, float m10, float m11, float m12 )
+		{
+			m[0][0] = m00;
+			m[0][1] = m01;
+			m[0][2] = m02;
+			m[1][0] = m10;
+			m[1][1] = m11;
+			m[1][2] = m12;
+		}
+	};
+
+	/** @class WidgetTransformStore
+		Owned by ColibriManager. Holds the transform of every Widget as structure of arrays,
+		indexed by Widget::m_transformId. Widgets access it through their own accessors
+		(e.g. Widget::getSize) so this class is rarely needed directly.
+
+		Slots are kept sorted so that a parent is always before its children, which lets
+		updateAllDerivedTransforms update the whole hierarchy with one linear pass,
+		instead of recursing through every Widget::m_children.
+	@remarks
+		Never keep a reference to an element across the creation of a Widget,
+		as the arrays may grow and reallocate.
+	*/
+	class WidgetTransformStore
+	{
+	public:
+		static const uint32_t c_noParent = 0xFFFFFFFFu;
+
+		/// Widget that owns each slot. Nullptr if the slot was released
+		/// (it's removed in the next reorder)
+		std::vector<Widget *> m_owner;
+		/// Slot of the parent, or c_noParent for parentless windows (and released slots)
+		/// Always lower than the slot of the child, unless m_orderDirty is true.
+		std::vector<uint32_t> m_parentId;
+
+		/// In canvas units, relative to parent
+		std::vector<Ogre::Vector2> m_position;
+		std::vector<Ogre::Vector2> m_size;
+		/// 2x2 matrix
+		std::vector<Ogre::Vector4> m_orientation;
+
+		/// Mirrors of Widget::m_clipBorderTL, m_clipBorderBR & Widget::getCurrentScroll
+		/// so that updateAllDerivedTransforms doesn't need to look at the Widget.
+		/// See Widget::syncTransformClipping
+		std::vector<Ogre::Vector2> m_clipBorderTL;
+		std::vector<Ogre::Vector2> m_clipBorderBR;
+		std::vector<Ogre::Vector2> m_currentScroll;
+
+		/// In NDC space
+		std::vector<Ogre::Vector2> m_derivedTopLeft;
+		std::vector<Ogre::Vector2> m_derivedBottomRight;
+		std::vector<Matrix2x3>     m_derivedOrientation;
+
+		/// Without m_accumMinClipTL & m_accumMaxClipBR, the widget will be visible
+		/// even if its parent is partially obscured by its parent's parent
+		std::vector<Ogre::Vector2> m_accumMinClipTL;
+		std::vector<Ogre::Vector2> m_accumMaxClipBR;
+
+		/// See Widget::_isCulled. Written by Widget::_fillBuffersAndCommands
+		std::vector<uint8_t> m_culled;
+
+#if COLIBRIGUI_DEBUG >= COLIBRIGUI_DEBUG_MEDIUM
+		std::vector<uint8_t> m_transformOutOfDate;
+#endif
+
+	protected:
+		/// When true some slot has its parent after it, or there are released slots
+		bool m_orderDirty;
+
+		/// Sorts the slots by depth in the hierarchy (thus parents go before their
+		/// children, and siblings are next to each other) and removes released slots.
+		/// Updates Widget::m_transformId of every Widget.
+		void reorder();
+
+	public:
+		WidgetTransformStore();
+
+		/// Returns the slot for the new Widget. It has no parent
+		uint32_t createSlot( Widget *owner );
+		void     destroySlot( uint32_t transformId );
+
+		/// parentId can be c_noParent
+		void setParent( uint32_t transformId, uint32_t parentId );
+
+		/// Updates m_derivedTopLeft, m_derivedBottomRight & m_derivedOrientation of the slot
+		void updateDerivedTransform( uint32_t transformId, const Ogre::Vector2 &parentPos,
+									 const Matrix2x3 &parentRot, const Ogre::Vector2 &invCanvasSize2x,
+									 float invCanvasAr );
+
+		/// Updates the derived transforms and clip accumulators of all slots.
+		/// Does not cull (that needs the occluders, see Widget::_fillBuffersAndCommands)
+		void updateAllDerivedTransforms( const Ogre::Vector2 &invCanvasSize2x, float invCanvasAr );
+
+		size_t getNumSlots() const { return m_owner.size(); }
+	};
+}  // namespace Colibri
+
+COLIBRI_ASSUME_NONNULL_END
@@ -38,6 +38,9 @@ namespace Colibri
 		/// are not dirty, but one of our children's child is.
 		bool		m_childrenNavigationDirty;
 
+		/// See setOpaque
+		bool		m_opaque;
+
 		WindowVec m_childWindows;
 
 		Widget *colibri_nullable m_arrows[Borders::NumBorders];
@@ -152,6 +155,23 @@ namespace Colibri
 		/// Detaches from current parent. Does nothing if already parentless
 		void detachFromParent();
 
+		/** Tells ColibriManager this window completely hides whatever is behind it
+			(i.e. its skin has no transparency). Widgets fully covered by an opaque
+			window are neither filled nor drawn. e.g. the HUD when a full-screen
+			menu is open.
+		@remarks
+			Only applies to main windows (i.e. parentless), and only hides
+			the windows drawn before it (i.e. with lower Z order or created earlier).
+			Rotation is not taken into account.
+
+			The skin's alpha is not inspected; setting this flag on a window
+			that is not actually opaque will cause what's behind to disappear.
+		@param bOpaque
+			True to flag as opaque. Default is false.
+		*/
+		void setOpaque( bool bOpaque ) { m_opaque = bOpaque; }
+		bool isOpaque() const { return m_opaque; }
+
 		/// Makes this widget the default widget (i.e. which widget the cursor
 		/// defaults to when the window is created)
 		/// If widget is not our child or nullptr, the current default is unset
@@ -187,9 +207,6 @@ namespace Colibri
 		void setConsumeCursor( bool bConsumeCursor ) { m_clickable = bConsumeCursor; }
 		bool getConsumeCursor() const { return m_clickable; }
 
-		void _updateDerivedTransformOnly( const Ogre::Vector2 &parentPos,
-										  const Matrix2x3     &parentRot ) override;
-
 		void _fillBuffersAndCommands(
 			UiVertex *colibri_nonnull *colibri_nonnull RESTRICT_ALIAS    vertexBuffer,            //
 			GlyphVertex *colibri_nonnull *colibri_nonnull RESTRICT_ALIAS textVertBuffer,          //
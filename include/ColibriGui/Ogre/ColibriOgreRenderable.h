@@ -22,10 +22,8 @@ namespace Ogre
 	class ColibriOgreRenderable : public MovableObject, public Renderable
 	{
 	public:
-		static VertexArrayObject *createVao( uint32 vertexCount, VaoManager *vaoManager,
-											 bool bMultiPass );
-		static VertexArrayObject *createTextVao( uint32 vertexCount, VaoManager *vaoManager,
-												 bool bMultiPass );
+		static VertexArrayObject *createVao( uint32 vertexCount, VaoManager *vaoManager );
+		static VertexArrayObject *createTextVao( uint32 vertexCount, VaoManager *vaoManager );
 
 		static void destroyVao( VertexArrayObject *vao, VaoManager *vaoManager );
 
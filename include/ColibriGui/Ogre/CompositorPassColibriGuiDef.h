@@ -33,13 +33,19 @@ namespace Ogre
 
 		bool mSetsResolution;
 		AspectRatioMode mAspectRatioMode;
+		/// When true, if the UI was already filled this frame by another pass (and nothing
+		/// changed since, see ColibriManager::isLastFillReusable), its vertex data is
+		/// rendered again instead of being regenerated. Useful for split-screen, VR and
+		/// mirror views. Default is false.
+		bool mReuseFill;
 
 	public:
 		CompositorPassColibriGuiDef( CompositorTargetDef *parentTargetDef,
 									 bool                 bSkipLoadStoreSemantics ) :
 			CompositorPassDef( PASS_CUSTOM, parentTargetDef ),
 			mSetsResolution( true ),
-			mAspectRatioMode( ArNone )
+			mAspectRatioMode( ArNone ),
+			mReuseFill( false )
 		{
 			mProfilingId = "Colibri Gui";
 
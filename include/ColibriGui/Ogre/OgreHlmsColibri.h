@@ -30,6 +30,8 @@ THE SOFTWARE.
 
 #include "OgreHlmsUnlit.h"
 
+#include <atomic>
+
 #ifndef OGRE_MAKE_VERSION
 #	define OGRE_MAKE_VERSION( maj, min, patch ) ( ( maj << 16 ) | ( min << 8 ) | patch )
 #endif
@@ -77,6 +79,10 @@ namespace Ogre
 		// It's TexBufferPacked everywhere else
 		BufferPacked *mGlyphAtlasBuffer;
 
+		/// Incremented every time a shader cache entry (i.e. a new permutation) is created.
+		/// Atomic because caches may be created from worker threads.
+		std::atomic<uint32> mNumShaderCacheEntriesCreated;
+
 #if OGRE_VERSION >= OGRE_MAKE_VERSION( 2, 3, 0 )
 		void setupRootLayout( RootLayout &rootLayout COLIBRI_TID_ARG_DECL ) override;
 #endif
@@ -107,9 +113,19 @@ namespace Ogre
 
 		void prepareRenderCommands();
 
+		/// Returns the number of shader cache entries (permutations) created so far.
+		/// See ColibriManager::prewarmMaterials
+		uint32 getNumShaderCacheEntriesCreated() const { return mNumShaderCacheEntriesCreated; }
+
+		/** Writes the per-draw data. Returns the drawId to use as baseInstance
+		@param textShadowData
+			Only for text. 4 uint32 written right after the regular per-draw data, thus the
+			vertex shader finds them at drawId + 1. See Label::_getShadowDrawData
+		*/
 		uint32 fillBuffersForColibri( const HlmsCache *cache, const QueuedRenderable &queuedRenderable,
 									  bool casterPass, uint32 baseVertex, uint32 lastCacheHash,
-									  CommandBuffer *commandBuffer );
+									  CommandBuffer *commandBuffer,
+									  const uint32 *textShadowData = 0 );
 
 		/// @copydoc HlmsPbs::getDefaultPaths
 		static void getDefaultPaths( String &outDataFolderPath, StringVector &outLibraryFoldersPaths );
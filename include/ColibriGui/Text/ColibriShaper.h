@@ -6,6 +6,7 @@
 
 #include "hb.h"
 
+#include <map>
 #include <string>
 #include <vector>
 
@@ -13,6 +14,7 @@ COLIBRI_ASSUME_NONNULL_BEGIN
 
 typedef struct FT_FaceRec_    *FT_Face;
 typedef struct FT_LibraryRec_ *FT_Library;
+typedef struct FT_SizeRec_    *FT_Size;
 
 #ifdef __ANDROID__
 struct AAsset;
@@ -43,17 +45,52 @@ namespace Colibri
 	class Shaper
 	{
 	protected:
+		/// A font size (at a given DPI) that was already set on the face
+		struct SizeEntry
+		{
+			FontSize  ptSize;
+			uint32_t  dpi;
+			FT_Size   ftSize;
+			hb_font_t *hbFont;
+			/// Used to evict the least recently used entry
+			uint32_t lastUsed;
+		};
+
+		typedef std::vector<SizeEntry> SizeEntryVec;
+
+		/// One bit per codepoint, for a block of 256 codepoints
+		struct CoverageBlock
+		{
+			uint64_t bits[4];
+		};
+
+		/// Key is codepoint >> 8u
+		typedef std::map<uint32_t, CoverageBlock> CoverageBlockMap;
+
 		hb_script_t   m_script;
 		FT_Face       m_ftFont;
 		hb_language_t m_hbLanguage;
-		hb_font_t    *m_hbFont;
+		/// Font of the current size. Owned by m_sizes
+		hb_font_t *colibri_nullable m_hbFont;
 		hb_buffer_t  *m_buffer;
 
+		/// Switching sizes via FT_Set_Char_Size + hb_ft_font_changed is expensive, and
+		/// screens that mix sizes would do it on every run. Thus we keep one FT_Size and
+		/// hb_font_t per size, and switching is just a matter of activating it.
+		SizeEntryVec m_sizes;
+		size_t       m_currentSizeIdx;
+		uint32_t     m_sizeUsageCounter;
+
+		/// Which codepoints the font has. Built lazily. See coversCodepoint
+		CoverageBlockMap m_coverage;
+
 		std::vector<hb_feature_t> m_features;
 
 		FT_Library     m_library;
 		ShaperManager *m_shaperManager;
 
+		std::string m_fontLocation;
+
 #ifdef __ANDROID__
 		AAsset *colibri_nullable m_asset;
 		FT_StreamRec            *m_stream;
@@ -65,6 +102,13 @@ namespace Colibri
 		/// See setUseCodepoint0ForRaster()
 		bool m_useCodepoint0ForRaster;
 
+		/// See setSdfMode()
+		bool m_sdfMode;
+
+		/// Creates a new entry in m_sizes, evicting the least recently used one if full.
+		/// Returns its index
+		size_t createSizeEntry( FontSize ptSize, uint32_t dpi );
+
 		size_t renderWithSubstituteFont( const uint16_t *utf16Str, size_t stringLength,
 										 hb_direction_t dir, uint32_t richTextIdx,
 										 uint32_t clusterOffset, ShapedGlyphVec &outShapes,
@@ -75,12 +119,26 @@ namespace Colibri
 				ShaperManager *shaperManager );
 		~Shaper();
 
+		/// Path the font was loaded from
+		const std::string &getFontLocation() const { return m_fontLocation; }
+
+		FT_Face  getFtFace() const { return m_ftFont; }
+		uint16_t getFontIdx() const { return m_fontIdx; }
+
 		void setFeatures( const std::vector<hb_feature_t> &features );
 		void addFeatures( const hb_feature_t &feature );
 
+		/** Sets the size for shaping and rasterizing.
+		@remarks
+			We keep a small cache of sizes per font (see getMaxCachedSizes) so going
+			back and forth between a few sizes is cheap.
+		*/
 		void     setFontSize( FontSize ptSize );
 		FontSize getFontSize() const;
 
+		/// Max number of sizes (at a given DPI) we keep per font. See setFontSize
+		static size_t getMaxCachedSizes() { return 8u; }
+
 		/** When raster fonts are used, we need to fetch a dummy glyph to base our parameters
 			and align the raster glyphs (e.g. emoji).
 
@@ -99,10 +157,30 @@ namespace Colibri
 		void setUseCodepoint0ForRaster( bool useCodepoint0ForRaster );
 		bool getUseCodepoint0ForRaster() const;
 
+		/** When enabled, glyphs from this font are rasterized once as a signed distance field
+			(at ShaperManager::getSdfReferenceSize) and scaled in the pixel shader, instead of
+			being rasterized for every size.
+
+			Saves atlas memory and rasterization time when the same font is used
+			at many sizes (or with animated sizes), at the cost of slightly softer glyphs
+			at small sizes.
+		@remarks
+			Must be set before any text with this font is shaped.
+		*/
+		void setSdfMode( bool sdfMode );
+		bool getSdfMode() const { return m_sdfMode; }
+
 		size_t renderString( const uint16_t *utf16Str, size_t stringLength, hb_direction_t dir,
 							 uint32_t richTextIdx, uint32_t clusterOffset, ShapedGlyphVec &outShapes,
 							 bool &bOutHasPrivateUse, bool substituteIfNotFound );
 
+		/** Returns true if the font has a glyph for the given codepoint.
+			Queries the font's charmap once per block of 256 codepoints, and caches the results.
+		@param codepoint
+			Codepoint (UTF-32)
+		*/
+		bool coversCodepoint( uint32_t codepoint );
+
 		bool operator<( const Shaper &other ) const;
 
 		static const hb_feature_t LigatureOff;
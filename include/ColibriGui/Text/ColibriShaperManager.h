@@ -35,18 +35,32 @@ namespace Colibri
 	{
 		uint32_t codepoint;
 		uint32_t ptSize;
+		/// Offset into the glyph atlas. Encodes both the page and the offset within
+		/// that page. See ShaperManager::setGlyphAtlasPageSize
 		uint32_t offsetStart;
 		float bearingX;
 		float bearingY;
+		/// Size on screen, in pixels
 		uint16_t width;
 		uint16_t height;
+		/// Size of the bitmap in the atlas. Same as width & height unless isSdf is true
+		uint16_t atlasWidth;
+		uint16_t atlasHeight;
 		float newlineSize;
 		float regionUp;
 		uint16_t font;
+		/// When true, the atlas contains a signed distance field rasterized at
+		/// ShaperManager::getSdfReferenceSize that is shared with all the other sizes.
+		bool isSdf;
 		uint32_t refCount;
 
+		/// Returns the size this glyph owns in the atlas. 0 for SDF glyphs, as
+		/// they share the bitmap with the other sizes.
 		size_t getSizeBytes() const;
 
+		/// Returns what the shader expects as offset (the highest bit indicates SDF)
+		uint32_t getVertexOffset() const { return isSdf ? ( offsetStart | 0x80000000u ) : offsetStart; }
+
 		bool isCodepointInPrivateArea() const;
 
 		/*bool operator < ( const CachedGlyph &other ) const;
@@ -67,7 +81,30 @@ namespace Colibri
 		{
 			size_t	offset;
 			size_t	size;
+
+			bool operator < ( const Range &other ) const { return this->offset < other.offset; }
+		};
+		/// A glyph whose space in the atlas is already reserved, but still needs to be rasterized
+		struct PendingRaster
+		{
+			uint32_t glyphIndex;
+			uint32_t ptSize;
+			uint32_t offsetStart;
+			uint16_t fontIdx;
+			uint16_t width;
+			uint16_t height;
+
+			/// Sort by font & size so each worker changes face sizes as little as possible
+			bool operator < ( const PendingRaster &other ) const
+			{
+				if( this->fontIdx != other.fontIdx )
+					return this->fontIdx < other.fontIdx;
+				return this->ptSize < other.ptSize;
+			}
 		};
+		/// Defined in the cpp
+		struct RasterWorkers;
+
 		struct GlyphKey
 		{
 			uint32_t codepoint;
@@ -102,11 +139,43 @@ namespace Colibri
 
 		typedef std::vector<Range> RangeVec;
 
-		uint8_t		*m_glyphAtlas;
+		typedef std::vector<uint8_t *> AtlasPageVec;
+
+		/// The atlas is split in pages of m_atlasPageSize bytes so that growing it doesn't
+		/// need to reallocate and copy what we already have. Glyphs never straddle two pages.
+		/// Offsets are linear: page = offset / m_atlasPageSize
+		AtlasPageVec m_atlasPages;
+		size_t		m_atlasPageSize;
+		size_t		m_maxAtlasSize;
 		RangeVec	m_freeRanges; //NOT sorted
 		size_t		m_offsetPtr;
 		size_t		m_atlasCapacity;
-		RangeVec	m_dirtyRanges; //NOT sorted?
+		RangeVec	m_dirtyRanges; //NOT sorted. See uploadDirtyRanges
+
+		/// Glyphs we hold a reference to so they don't get evicted. See prewarm
+		std::vector<CachedGlyph const *> m_prewarmedGlyphs;
+
+		/// A signed distance field shared by all sizes of the same glyph. See Shaper::setSdfMode
+		struct SdfBitmap
+		{
+			uint32_t offsetStart;
+			uint16_t width;
+			uint16_t height;
+			float    bearingX;
+			float    bearingY;
+			/// Number of CachedGlyph (one per size) using this bitmap
+			uint32_t refCount;
+		};
+
+		/// GlyphKey::ptSize is always 0
+		typedef std::map<GlyphKey, SdfBitmap> SdfBitmapMap;
+		SdfBitmapMap m_sdfBitmaps;
+		FontSize     m_sdfReferenceSize;
+		uint16_t     m_sdfSpread;
+
+		typedef std::vector<PendingRaster> PendingRasterVec;
+		PendingRasterVec m_pendingRasters;
+		RasterWorkers *colibri_nullable m_rasterWorkers;
 
 		VertReadingDir::VertReadingDir m_preferredVertReadingDir;
 
@@ -116,6 +185,11 @@ namespace Colibri
 
 		/// m_shapers[0] is the default and not a strong reference
 		ShaperVec  m_shapers;
+
+		/// Memoizes findFallbackFont. Key is the codepoint, value the index to m_shapers
+		/// of the first font that has it (0 if none)
+		typedef std::map<uint32_t, uint16_t> CodepointFontMap;
+		CodepointFontMap m_fallbackFonts;
 		/// Unlike m_shapers, m_bmpFonts[0] is not repeated and is a strong ref
 		BmpFontVec m_bmpFonts;
 
@@ -127,16 +201,44 @@ namespace Colibri
 		Ogre::HlmsColibri *colibri_nullable  m_hlms;
 		Ogre::VaoManager *colibri_nullable   m_vaoManager;
 
-		void growAtlas( size_t sizeBytes );
+		/// Adds a new page. Returns false if we've reached m_maxAtlasSize
+		bool growAtlas();
+		/// Advances m_offsetPtr. Returns false if there's not enough capacity
+		bool allocateFromOffsetPtr( size_t sizeBytes, size_t &outOffset );
+		/// Returns std::numeric_limits<size_t>::max() if the atlas is full
 		size_t getAtlasOffset( size_t sizeBytes );
+		uint8_t *getAtlasPtr( size_t offset );
 		CachedGlyph *createGlyph( FT_Face font, uint32_t codepoint, uint32_t ptSize, uint16_t fontIdx,
 								  bool bDummy );
+		/// Used for fonts in SDF mode. See Shaper::setSdfMode
+		CachedGlyph *createSdfGlyph( FT_Face font, uint32_t codepoint, uint32_t ptSize, uint16_t fontIdx,
+									 bool bDummy );
+		/// Rasterizes the glyph at m_sdfReferenceSize and stores its distance field in the atlas.
+		SdfBitmap rasterizeSdfBitmap( FT_Face font, uint32_t glyphIndex, uint16_t fontIdx );
 		/// Used only for private areas
 		CachedGlyph *createRasterGlyph( FT_Face font, uint32_t codepoint, uint32_t ptSize,
 										uint16_t fontIdx, const bool bUseCodepoint0ForRaster );
 		void         destroyGlyph( CachedGlyphMap::iterator glyphIt );
+		/// Returns a region obtained from getAtlasOffset back to the pool
+		void         freeAtlasRange( size_t offset, size_t sizeBytes );
 		void mergeContiguousBlocks( RangeVec::iterator blockToMerge, RangeVec &blocks );
 
+		/// Identifies the fonts, settings and FreeType version a glyph cache file is valid for
+		void getGlyphCacheKey( std::vector<uint64_t> &outKey ) const;
+		/// Returns true if [offset; offset + sizeBytes) is below offsetPtr and within a single page.
+		/// Used to validate what loadGlyphCache reads from disk
+		bool isAtlasRegionValid( uint64_t offset, uint64_t sizeBytes, uint64_t offsetPtr ) const;
+
+		/// Rasterizes this thread's share of m_pendingRasters.
+		/// Called from the worker threads.
+		void rasterizePendingGlyphs( size_t threadIdx );
+
+		/** Uploads m_dirtyRanges to m_glyphAtlasBuffer and clears m_dirtyRanges.
+			Ranges are sorted and merged first, and all of them are packed into
+			a single StagingBuffer so they can be sent with one transfer.
+		*/
+		void uploadDirtyRanges();
+
 	public:
 		ShaperManager( ColibriManager *colibriManager );
 		~ShaperManager();
@@ -156,6 +258,17 @@ namespace Colibri
 		///			means it will appear twice in the array
 		const ShaperVec& getShapers() const			{ return m_shapers; }
 
+		/** Finds a font that can be used when the requested one doesn't have a codepoint.
+		@param codepoint
+			Codepoint (UTF-32)
+		@param exclude
+			Font that is known not to work (i.e. the one that didn't have the codepoint).
+		@return
+			Index to getShapers() of the first font that has the codepoint.
+			0 if there is none.
+		*/
+		uint16_t findFallbackFont( uint32_t codepoint, const Shaper *exclude );
+
 		void addBmpFont( const char *fontPath, bool bBilinearFilter = true );
 
 		BmpFont *getBmpFont( size_t idx ) { return m_bmpFonts[idx]; }
@@ -214,6 +327,58 @@ namespace Colibri
 
 		void flushReleasedGlyphs();
 
+		/** Rasterizes ahead of time all the glyphs needed to render utf8Str, so that they
+			don't have to be rasterized the first time they're used (e.g. during a loading screen).
+			The glyphs are pinned, i.e. they're never evicted until releasePrewarmedGlyphs.
+		@remarks
+			If setNumRasterThreads > 0, the glyphs are rasterized in parallel.
+		@param font
+			Index to getShapers()
+		@param ptSizes
+			All the sizes the glyphs will be used at.
+		@param utf8Str
+			Sample text. It is shaped, so ligatures and fallback fonts are taken into account.
+		*/
+		void prewarm( uint16_t font, const std::vector<FontSize> &ptSizes, const char *utf8Str );
+
+		/** Same as the other overload, but for all codepoints in the range
+			[firstCodepoint; lastCodepoint] that are in the font.
+		@remarks
+			Codepoints are not shaped, thus ligatures are not prewarmed.
+			Useful for large sets (e.g. digits, an alphabet, common CJK characters).
+			lastCodepoint is clamped to 0x10FFFF (the last Unicode codepoint).
+		*/
+		void prewarm( uint16_t font, const std::vector<FontSize> &ptSizes, uint32_t firstCodepoint,
+					  uint32_t lastCodepoint );
+
+		/// Unpins all glyphs pinned by prewarm. They're kept in the cache until
+		/// space is needed (like any other unused glyph).
+		void releasePrewarmedGlyphs();
+
+		/** Saves all rasterized glyphs and the atlas to disk, so that they can be loaded
+			with loadGlyphCache on the next run instead of rasterizing them again.
+		@remarks
+			The file is only valid for the same fonts (in the same order), default font, DPI,
+			glyph atlas page size and FreeType version.
+		@param fullPath
+			Path to a writable location.
+		@return
+			False on failure.
+		*/
+		bool saveGlyphCache( const char *fullPath );
+
+		/** Loads a file saved with saveGlyphCache. Must be called after all fonts have
+			been added and the DPI was set; but before any text is shaped.
+			The whole atlas is uploaded in one go by the next updateGpuBuffers.
+		@remarks
+			If the file doesn't match the current fonts/settings (see saveGlyphCache)
+			it is ignored and false is returned. Glyphs will be rasterized as usual.
+		@param fullPath
+		@return
+			True if the cache was loaded.
+		*/
+		bool loadGlyphCache( const char *fullPath );
+
 		/**
 		@brief renderString
 		@param utf8Str
@@ -239,6 +404,59 @@ namespace Colibri
 		TextHorizAlignment::TextHorizAlignment getDefaultTextDirection() const;
 		VertReadingDir::VertReadingDir getPreferredVertReadingDir() const;
 
+		/** Sets the size in bytes of each page of the glyph atlas.
+			The atlas grows one page at a time. Glyphs bigger than a page are rendered empty.
+		@remarks
+			Must be called before any glyph is created.
+			Value is rounded up to a multiple of 4096. Default is 1MiB.
+		*/
+		void   setGlyphAtlasPageSize( size_t pageSizeBytes );
+		size_t getGlyphAtlasPageSize() const { return m_atlasPageSize; }
+
+		/** Caps the memory used by the glyph atlas (in bytes). When the cap is reached,
+			glyphs that are no longer in use are evicted to make room. If that's not enough,
+			an error is logged and new glyphs are rendered empty.
+		@remarks
+			The first page is always allocated even if it's bigger than the cap.
+			Default is no limit.
+		*/
+		void   setMaxGlyphAtlasSize( size_t maxSizeBytes );
+		size_t getMaxGlyphAtlasSize() const { return m_maxAtlasSize; }
+
+		/** Sets the size at which glyphs of fonts in SDF mode are rasterized
+			(see Shaper::setSdfMode), and how far (in pixels at that size) the distance
+			field extends beyond the glyph's outline.
+		@remarks
+			Must be called before any text in SDF mode is shaped.
+			Default is 48pt with a spread of 6 pixels.
+		*/
+		void     setSdfReferenceSize( FontSize ptSize, uint16_t spread );
+		FontSize getSdfReferenceSize() const { return m_sdfReferenceSize; }
+		uint16_t getSdfSpread() const { return m_sdfSpread; }
+
+		/// Returns the current size of the glyph atlas in bytes
+		size_t getGlyphAtlasCapacity() const { return m_atlasCapacity; }
+
+		/** Sets the number of worker threads used for rasterizing glyphs.
+
+			When 0 (default), glyphs are rasterized as soon as they're needed while shaping.
+
+			Otherwise shaping only reserves the space in the atlas, and the glyphs are
+			rasterized in parallel (each worker has its own FreeType faces) when
+			rasterizePendingGlyphs is called. That happens automatically in updateGpuBuffers.
+		@remarks
+			Not supported on Android, since fonts are read from APK streams.
+		*/
+		void   setNumRasterThreads( size_t numThreads );
+		size_t getNumRasterThreads() const;
+
+		/// Rasterizes all the glyphs that were reserved but not rasterized yet.
+		/// Blocks until the workers are done. See setNumRasterThreads
+		void rasterizePendingGlyphs();
+
+		/// For internal use. Entry point of the worker threads
+		unsigned long _rasterWorkerThread( size_t threadIdx );
+
 		void updateGpuBuffers();
 
 		void prepareToRender();
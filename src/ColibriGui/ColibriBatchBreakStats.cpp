@@ -0,0 +1,146 @@
+
+#include "ColibriGui/ColibriBatchBreakStats.h"
+
+#include "ColibriGui/ColibriManager.h"
+#include "ColibriGui/ColibriWindow.h"
+
+#include "OgreLwString.h"
+
+#include <algorithm>
+#include <string.h>
+
+namespace Colibri
+{
+	static const char *c_batchBreakReasonNames[BatchBreakReason::NumBatchBreakReasons] = {
+		"FirstDraw",           "HlmsCacheChange",     "TextureChange", "VaoChange",
+		"LabelDatablockChange", "LabelShadowChange",   "VertexDiscontinuity", "CustomShape"
+	};
+
+	BatchBreakStats::BatchBreakStats() : numCommands( 0u ), numDraws( 0u )
+	{
+		memset( numBreaks, 0, sizeof( numBreaks ) );
+	}
+	//-------------------------------------------------------------------------
+	void BatchBreakStats::clear()
+	{
+		memset( numBreaks, 0, sizeof( numBreaks ) );
+		numCommands = 0u;
+		numDraws = 0u;
+		records.clear();
+	}
+	//-------------------------------------------------------------------------
+	void BatchBreakStats::addRecord( BatchBreakReason::BatchBreakReason reason, bool newCommand,
+									 const Widget *widget )
+	{
+		const Widget *window = widget;
+		while( !window->isWindow() )
+			window = window->getParent();
+
+		++numBreaks[reason];
+		if( newCommand )
+			++numCommands;
+		++numDraws;
+
+		BatchBreakRecord record;
+		record.reason = reason;
+		record.newCommand = newCommand;
+		record.window = static_cast<const Window *>( window );
+		record.debugName = widget->_getDebugName();
+		record.windowDebugName = window->_getDebugName();
+		records.push_back( record );
+	}
+	//-------------------------------------------------------------------------
+	void BatchBreakStats::removeLastRecord()
+	{
+		COLIBRI_ASSERT_LOW( !records.empty() );
+
+		const BatchBreakRecord &record = records.back();
+		--numBreaks[record.reason];
+		if( record.newCommand )
+			--numCommands;
+		--numDraws;
+		records.pop_back();
+	}
+	//-------------------------------------------------------------------------
+	void BatchBreakStats::getWindowBreakdown(
+		const Window *window,
+		uint32_t outNumBreaks[colibri_nonnull BatchBreakReason::NumBatchBreakReasons] ) const
+	{
+		memset( outNumBreaks, 0, sizeof( uint32_t ) * BatchBreakReason::NumBatchBreakReasons );
+
+		std::vector<BatchBreakRecord>::const_iterator itor = records.begin();
+		std::vector<BatchBreakRecord>::const_iterator endt = records.end();
+
+		while( itor != endt )
+		{
+			if( itor->window == window )
+				++outNumBreaks[itor->reason];
+			++itor;
+		}
+	}
+	//-------------------------------------------------------------------------
+	void BatchBreakStats::log( LogListener *logListener ) const
+	{
+		char tmpBuffer[512];
+		Ogre::LwString msg( Ogre::LwString::FromEmptyPointer( tmpBuffer, sizeof( tmpBuffer ) ) );
+
+		msg.a( "[BatchBreakStats]: ", numCommands, " draw commands, ", numDraws, " draws." );
+		for( size_t i = 0u; i < BatchBreakReason::NumBatchBreakReasons; ++i )
+		{
+			if( numBreaks[i] != 0u )
+				msg.a( " ", c_batchBreakReasonNames[i], ": ", numBreaks[i] );
+		}
+		logListener->log( msg.c_str(), LogSeverity::Info );
+
+		// Per-window breakdown, in the order windows were first seen
+		std::vector<const Window *> windows;
+		std::vector<BatchBreakRecord>::const_iterator itor = records.begin();
+		std::vector<BatchBreakRecord>::const_iterator endt = records.end();
+
+		while( itor != endt )
+		{
+			if( std::find( windows.begin(), windows.end(), itor->window ) != windows.end() )
+			{
+				++itor;
+				continue;
+			}
+
+			windows.push_back( itor->window );
+
+			uint32_t windowBreaks[BatchBreakReason::NumBatchBreakReasons];
+			getWindowBreakdown( itor->window, windowBreaks );
+
+			msg.clear();
+			msg.a( "[BatchBreakStats]:   Window #", (uint32_t)windows.size(), " '",
+				   itor->windowDebugName.c_str(), "':" );
+			for( size_t i = 0u; i < BatchBreakReason::NumBatchBreakReasons; ++i )
+			{
+				if( windowBreaks[i] != 0u )
+					msg.a( " ", c_batchBreakReasonNames[i], ": ", windowBreaks[i] );
+			}
+			logListener->log( msg.c_str(), LogSeverity::Info );
+
+			++itor;
+		}
+
+		// Every break with the name of its widget (only useful in debug builds)
+		itor = records.begin();
+		while( itor != endt )
+		{
+			if( !itor->debugName.empty() )
+			{
+				msg.clear();
+				msg.a( "[BatchBreakStats]:     ", c_batchBreakReasonNames[itor->reason],
+					   itor->newCommand ? " (new command) by '" : " by '", itor->debugName.c_str(),
+					   "' in window '", itor->windowDebugName.c_str(), "'" );
+				logListener->log( msg.c_str(), LogSeverity::Info );
+			}
+			++itor;
+		}
+	}
+	//-------------------------------------------------------------------------
+	const char *BatchBreakStats::getReasonName( BatchBreakReason::BatchBreakReason reason )
+	{
+		return c_batchBreakReasonNames[reason];
+	}
+}  // namespace Colibri
@@ -30,6 +30,22 @@ namespace Colibri
 		m_label = 0;
 	}
 	//-------------------------------------------------------------------------
+	void Button::_cloneSettingsTo( Widget *_dst ) const
+	{
+		Renderable::_cloneSettingsTo( _dst );
+
+		COLIBRI_ASSERT_HIGH( dynamic_cast<Button *>( _dst ) );
+		Button *dst = static_cast<Button *>( _dst );
+
+		dst->m_labelTopLeftMargin = m_labelTopLeftMargin;
+		dst->m_labelBottomRightMargin = m_labelBottomRightMargin;
+
+		if( m_label )
+			m_label->_cloneSettingsTo( dst->getLabel() );
+	}
+	//-------------------------------------------------------------------------
+	bool Button::_isInternalChild( const Widget *child ) const { return child == m_label; }
+	//-------------------------------------------------------------------------
 	void Button::setLabelMargins( const Ogre::Vector2 &labelTopLeftMargin,
 								  const Ogre::Vector2 &labelBottomRightMargin )
 	{
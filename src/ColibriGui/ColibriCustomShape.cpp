@@ -141,34 +141,35 @@ void CustomShape::_fillBuffersAndCommands(
 
 	updateDerivedTransform( parentPos, parentRot );
 
-	m_culled = true;
+	_culled() = true;
 
-	if( !m_parent->intersectsChild( this, parentScrollPos ) || m_hidden )
+	if( !m_parent->intersectsChild( this, parentScrollPos ) || m_hidden ||
+		m_manager->_isOccluded( _derivedTopLeft(), _derivedBottomRight() ) )
 		return;
 
-	m_culled = false;
+	_culled() = false;
 
 	Ogre::Vector2 parentDerivedTL;
 	Ogre::Vector2 parentDerivedBR;
 
 	const Ogre::Vector2 invCanvasSize2x = m_manager->getInvCanvasSize2x();
 
-	parentDerivedTL = m_parent->m_derivedTopLeft + m_parent->m_clipBorderTL * invCanvasSize2x;
-	parentDerivedBR = m_parent->m_derivedBottomRight - m_parent->m_clipBorderBR * invCanvasSize2x;
+	parentDerivedTL = m_parent->_derivedTopLeft() + m_parent->m_clipBorderTL * invCanvasSize2x;
+	parentDerivedBR = m_parent->_derivedBottomRight() - m_parent->m_clipBorderBR * invCanvasSize2x;
 
-	parentDerivedTL.makeCeil( m_parent->m_accumMinClipTL );
-	parentDerivedBR.makeFloor( m_parent->m_accumMaxClipBR );
+	parentDerivedTL.makeCeil( m_parent->_accumMinClipTL() );
+	parentDerivedBR.makeFloor( m_parent->_accumMaxClipBR() );
 
-	parentDerivedTL.makeCeil( this->m_derivedTopLeft );
-	parentDerivedBR.makeFloor( this->m_derivedBottomRight );
+	parentDerivedTL.makeCeil( this->_derivedTopLeft() );
+	parentDerivedBR.makeFloor( this->_derivedBottomRight() );
 
-	m_accumMinClipTL = parentDerivedTL;
-	m_accumMaxClipBR = parentDerivedBR;
+	_accumMinClipTL() = parentDerivedTL;
+	_accumMaxClipBR() = parentDerivedBR;
 
 	const Ogre::Vector2 widgetOffset =
 		m_sizeMode == CustomShapeSizeMode::Ndc ? Ogre::Vector2::UNIT_SCALE : Ogre::Vector2::ZERO;
 	const Ogre::Vector2 widgetHalfSize =
-		( m_sizeMode == CustomShapeSizeMode::Ndc ? ( m_size * 0.5f ) : Ogre::Vector2::UNIT_SCALE ) *
+		( m_sizeMode == CustomShapeSizeMode::Ndc ? ( _size() * 0.5f ) : Ogre::Vector2::UNIT_SCALE ) *
 		invCanvasSize2x;
 
 	if( m_visualsEnabled )
@@ -185,8 +186,8 @@ void CustomShape::_fillBuffersAndCommands(
 		const float canvasAspectRatio = m_manager->getCanvasAspectRatio();
 		const float invCanvasAspectRatio = m_manager->getCanvasInvAspectRatio();
 
-		const Matrix2x3 derivedRot = m_derivedOrientation;
-		const Ogre::Vector2 derivedTopLeft = m_derivedTopLeft;
+		const Matrix2x3 derivedRot = _derivedOrientation();
+		const Ogre::Vector2 derivedTopLeft = _derivedTopLeft();
 
 		for( const UiVertex &vertex : m_vertices )
 		{
@@ -218,12 +219,12 @@ void CustomShape::_fillBuffersAndCommands(
 
 		*_vertexBuffer = vertexBuffer;
 
-		const Matrix2x3 &finalRot = this->m_derivedOrientation;
+		const Matrix2x3 finalRot = this->_derivedOrientation();
 
 		const Ogre::Vector2 currentScrollPos = Ogre::Vector2::ZERO;
 
 		const Ogre::Vector2 outerTopLeftWithClipping =
-			m_derivedTopLeft + ( m_clipBorderTL - currentScrollPos ) * invCanvasSize2x;
+			_derivedTopLeft() + ( m_clipBorderTL - currentScrollPos ) * invCanvasSize2x;
 
 		for( Widget *child : m_children )
 		{
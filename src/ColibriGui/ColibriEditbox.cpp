@@ -3,15 +3,6 @@
 #include "ColibriGui/ColibriLabel.h"
 #include "ColibriGui/ColibriManager.h"
 
-#if defined( __clang__ )
-#	pragma clang diagnostic push
-#	pragma clang diagnostic ignored "-Wsign-conversion"
-#endif
-#include "unicode/unistr.h"
-#if defined( __clang__ )
-#	pragma clang diagnostic pop
-#endif
-
 #define TODO_text_edit
 
 namespace Colibri
@@ -304,9 +295,6 @@ namespace Colibri
 
 			if( !isAtLimit )
 			{
-				const std::string &oldText = m_label->getText();
-				UnicodeString uStr( UnicodeString::fromUTF8( oldText ) );
-
 				size_t lastCursorPosToDelete = m_cursorPos;
 				if( keyCode == KeyCode::Backspace )
 				{
@@ -336,20 +324,16 @@ namespace Colibri
 				if( glyphLength > 0 )
 				{
 					m_manager->setEffectReaction( EffectReaction::TextInputRemoved, glyphLength );
-					uStr.remove( static_cast<int32_t>( firstGlyphStart ),
-								 static_cast<int32_t>( glyphLength ) );
+					// Only reshapes the lines touched by the removal
+					m_label->replaceText( firstGlyphStart, glyphLength, "" );
 				}
 				else
 				{
 					m_manager->setEffectReaction( EffectReaction::TextInputRemoveFailed, repetition );
 				}
 
-				// Convert back to UTF8
-				std::string result;
-				uStr.toUTF8String( result );
-				m_label->setText( result );
 				if( m_placeholder )
-					m_placeholder->setVisualsEnabled( result.empty() );
+					m_placeholder->setVisualsEnabled( getText().empty() );
 				m_manager->callActionListeners( this, Action::ValueChanged );
 				m_manager->flushEffectReaction();
 			}
@@ -433,10 +417,6 @@ namespace Colibri
 
 		if( !bReplaceContents )
 		{
-			const std::string &oldText = m_label->getText();
-			UnicodeString uStr( UnicodeString::fromUTF8( oldText ) );
-			UnicodeString appendText( UnicodeString::fromUTF8( text ) );
-
 			oldGlyphCount = m_label->getGlyphCount();
 
 			// Convert m_cursorPos from glyph to code units
@@ -444,15 +424,10 @@ namespace Colibri
 			size_t glyphLength;
 			m_label->getGlyphStartUtf16( m_cursorPos, glyphStart, glyphLength );
 
-			// Append the text
-			uStr.insert( static_cast<int32_t>( glyphStart ), appendText );
-
-			// Convert back to UTF8
-			std::string result;
-			uStr.toUTF8String( result );
-			m_label->setText( result );
+			// Insert the text. Only reshapes the lines touched by the insertion
+			m_label->replaceText( glyphStart, 0u, text );
 			if( m_placeholder )
-				m_placeholder->setVisualsEnabled( result.empty() );
+				m_placeholder->setVisualsEnabled( getText().empty() );
 		}
 		else
 		{
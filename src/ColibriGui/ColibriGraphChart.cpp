@@ -6,6 +6,7 @@
 #include "ColibriGui/Layouts/ColibriLayoutLine.h"
 #include "ColibriGui/Layouts/ColibriLayoutTableSameSize.h"
 
+#include "OgreBitwise.h"
 #include "OgreHlms.h"
 #include "OgreHlmsManager.h"
 #include "OgreHlmsUnlitDatablock.h"
@@ -16,6 +17,12 @@
 
 using namespace Colibri;
 
+/// Number of values in the parameter row of the data texture. See GraphChart::syncChart
+static uint32_t getNumGraphParams( size_t numColumns )
+{
+	return 19u + static_cast<uint32_t>( numColumns ) * 4u;
+}
+
 GraphChart::Params::Params() :
 	numLines( 5u ),
 	lineThickness( 0.01f ),
@@ -32,6 +39,7 @@ GraphChart::Params::Params() :
 GraphChart::GraphChart( ColibriManager *manager ) :
 	CustomShape( manager ),
 	m_textureData( 0 ),
+	m_entriesPerColumn( 0u ),
 	m_labelsDirty( true ),
 	m_autoMin( false ),
 	m_autoMax( false ),
@@ -56,7 +64,7 @@ void GraphChart::_initialize()
 	for( size_t i = 0; i < States::NumStates; ++i )
 	{
 		Ogre::HlmsDatablock *refDatablock =
-			hlmsManager->getDatablockNoDefault( m_stateInformation[i].materialName );
+			hlmsManager->getDatablockNoDefault( m_stateInformation[i]->materialName );
 
 		char tmpBuffer[64];
 		Ogre::LwString idStr( Ogre::LwString::FromEmptyPointer( tmpBuffer, sizeof( tmpBuffer ) ) );
@@ -67,7 +75,8 @@ void GraphChart::_initialize()
 		if( !datablock )
 			datablock = refDatablock->clone( newName );
 
-		m_stateInformation[i].materialName = datablock->getName();
+		getOverridableStateInformation( static_cast<States::States>( i ) ).materialName =
+			datablock->getName();
 
 		if( i == m_currentState )
 			setDatablock( datablock );
@@ -102,12 +111,12 @@ void GraphChart::_destroy()
 	std::set<Ogre::IdString> seenDatablocks;
 	for( size_t i = 0; i < States::NumStates; ++i )
 	{
-		if( seenDatablocks.count( m_stateInformation[i].materialName ) != 0u )
+		if( seenDatablocks.count( m_stateInformation[i]->materialName ) != 0u )
 		{
 			Ogre::HlmsDatablock *datablock =
-				hlmsManager->getDatablockNoDefault( m_stateInformation[i].materialName );
-			datablock->getCreator()->destroyDatablock( m_stateInformation[i].materialName );
-			seenDatablocks.insert( m_stateInformation[i].materialName );
+				hlmsManager->getDatablockNoDefault( m_stateInformation[i]->materialName );
+			datablock->getCreator()->destroyDatablock( m_stateInformation[i]->materialName );
+			seenDatablocks.insert( m_stateInformation[i]->materialName );
 		}
 	}
 
@@ -168,8 +177,14 @@ void GraphChart::setMaxValues( const uint32_t numColumns, const uint32_t maxEntr
 
 	m_labelsDirty = true;
 
-	if( m_textureData && m_textureData->getHeight() == numColumns &&
-		m_textureData->getWidth() == maxEntriesPerColumn )
+	m_entriesPerColumn = maxEntriesPerColumn;
+
+	// The last row holds the parameters, which may need more texels than the values
+	const uint32_t textureWidth = std::max( maxEntriesPerColumn, getNumGraphParams( numColumns ) );
+	const uint32_t textureHeight = numColumns + 1u;
+
+	if( m_textureData && m_textureData->getHeight() == textureHeight &&
+		m_textureData->getWidth() == textureWidth )
 	{
 		// We're done.
 		return;
@@ -193,8 +208,9 @@ void GraphChart::setMaxValues( const uint32_t numColumns, const uint32_t maxEntr
 			Ogre::TextureTypes::Type2D );
 	}
 
-	m_textureData->setResolution( maxEntriesPerColumn, numColumns );
-	m_textureData->setPixelFormat( Ogre::PFG_R16_UNORM );
+	m_textureData->setResolution( textureWidth, textureHeight );
+	// Float so that the colours in the parameters row aren't clamped to [0; 1] (HDR)
+	m_textureData->setPixelFormat( Ogre::PFG_R16_FLOAT );
 	m_textureData->scheduleTransitionTo( Ogre::GpuResidency::Resident );
 
 	Ogre::HlmsManager *hlmsManager = m_manager->getOgreHlmsManager();
@@ -203,7 +219,7 @@ void GraphChart::setMaxValues( const uint32_t numColumns, const uint32_t maxEntr
 	for( size_t i = 0; i < States::NumStates; ++i )
 	{
 		Ogre::HlmsDatablock *datablock =
-			hlmsManager->getDatablockNoDefault( m_stateInformation[i].materialName );
+			hlmsManager->getDatablockNoDefault( m_stateInformation[i]->materialName );
 
 		COLIBRI_ASSERT_HIGH( dynamic_cast<Ogre::HlmsUnlitDatablock *>( datablock ) );
 		Ogre::HlmsUnlitDatablock *unlitDatablock = static_cast<Ogre::HlmsUnlitDatablock *>( datablock );
@@ -213,9 +229,7 @@ void GraphChart::setMaxValues( const uint32_t numColumns, const uint32_t maxEntr
 //-------------------------------------------------------------------------
 uint32_t GraphChart::getEntriesPerColumn() const
 {
-	if( !m_textureData )
-		return 0u;
-	return m_textureData->getWidth();
+	return m_entriesPerColumn;
 }
 //-------------------------------------------------------------------------
 void GraphChart::setDataRange( bool autoMin, bool autoMax, float minValue, float maxValue,
@@ -324,14 +338,17 @@ void GraphChart::syncChart()
 {
 	Ogre::TextureGpuManager *textureManager = m_textureData->getTextureManager();
 	Ogre::StagingTexture *stagingTexture = textureManager->getStagingTexture(
-		m_textureData->getWidth(), m_textureData->getHeight(), 1u, 1u, Ogre::PFG_R16_UNORM, 100u );
+		m_textureData->getWidth(), m_textureData->getHeight(), 1u, 1u, Ogre::PFG_R16_FLOAT, 100u );
 
 	stagingTexture->startMapRegion();
 	Ogre::TextureBox textureBox = stagingTexture->mapRegion(
-		m_textureData->getWidth(), m_textureData->getHeight(), 1u, 1u, Ogre::PFG_R16_UNORM );
+		m_textureData->getWidth(), m_textureData->getHeight(), 1u, 1u, Ogre::PFG_R16_FLOAT );
 
-	COLIBRI_ASSERT_MEDIUM( m_textureData->getWidth() == getEntriesPerColumn() );
-	COLIBRI_ASSERT_MEDIUM( m_textureData->getHeight() == m_columns.size() );
+	const size_t numColumns = m_columns.size();
+	const size_t entriesPerColumn = m_entriesPerColumn;
+
+	COLIBRI_ASSERT_MEDIUM( m_textureData->getWidth() >= entriesPerColumn );
+	COLIBRI_ASSERT_MEDIUM( m_textureData->getHeight() == numColumns + 1u );
 
 	float minSample = m_minSample;
 	float maxSample = m_maxSample;
@@ -342,9 +359,9 @@ void GraphChart::syncChart()
 
 		if( autoMin || autoMax )
 		{
-			for( size_t y = 0u; y < textureBox.height; ++y )
+			for( size_t y = 0u; y < numColumns; ++y )
 			{
-				for( size_t x = 0u; x < textureBox.width; ++x )
+				for( size_t x = 0u; x < entriesPerColumn; ++x )
 				{
 					if( autoMin )
 						minSample = std::min( m_columns[y].values[x], minSample );
@@ -366,16 +383,69 @@ void GraphChart::syncChart()
 	const float sampleInterval =
 		( maxSample - minSample ) < 1e-6f ? 1.0f : ( 1.0f / ( maxSample - minSample ) );
 
-	for( size_t y = 0u; y < textureBox.height; ++y )
+	for( size_t y = 0u; y < numColumns; ++y )
 	{
 		uint16_t *RESTRICT_ALIAS dstData =
 			reinterpret_cast<uint16_t * RESTRICT_ALIAS>( textureBox.at( 0u, y, 0u ) );
-		for( size_t x = 0u; x < textureBox.width; ++x )
+		for( size_t x = 0u; x < entriesPerColumn; ++x )
 		{
 			float fValue =
 				Ogre::Math::saturate( ( m_columns[y].values[x] - minSample ) * sampleInterval );
-			dstData[x] = static_cast<uint16_t>( fValue * 65535.0f );
+			dstData[x] = Ogre::Bitwise::floatToHalf( fValue );
+		}
+		// Repeat the last value in the padding so that filtering at the edge doesn't bleed
+		const uint16_t lastValue = entriesPerColumn > 0u ? dstData[entriesPerColumn - 1u] : 0u;
+		for( size_t x = entriesPerColumn; x < textureBox.width; ++x )
+			dstData[x] = lastValue;
+	}
+
+	{
+		// Parameters row. Must match colibriGraphParam in ColibriGui_piece_ps.any:
+		//	[0; 4)	graphStartTL.xy & graphEndBR.xy
+		//	4		intervalLength
+		//	5		lineThickness
+		//	6		Fraction of the texture width used by values
+		//	[7; 11)		lineColour
+		//	[11; 15)	bgInnerColour
+		//	[15; 19)	bgOuterColour
+		//	[19 + i * 4; 23 + i * 4)	Colour of column i
+		float params[32];
+		std::vector<float> paramsVec;
+		const uint32_t numParams = getNumGraphParams( numColumns );
+		float *paramsPtr = params;
+		if( numParams > sizeof( params ) / sizeof( params[0] ) )
+		{
+			paramsVec.resize( numParams );
+			paramsPtr = &paramsVec[0];
+		}
+
+		const Ogre::Vector2 graphEndBR = m_params.graphInnerTopLeft + m_params.graphInnerSize;
+		paramsPtr[0] = m_params.graphInnerTopLeft.x;
+		paramsPtr[1] = m_params.graphInnerTopLeft.y;
+		paramsPtr[2] = graphEndBR.x;
+		paramsPtr[3] = graphEndBR.y;
+		paramsPtr[4] = 1.0f / float( m_params.numLines - 1u );
+		paramsPtr[5] = m_params.lineThickness;
+		paramsPtr[6] = float( entriesPerColumn ) / float( textureBox.width );
+		for( size_t i = 0u; i < 4u; ++i )
+		{
+			paramsPtr[7u + i] = m_params.lineColour[i];
+			paramsPtr[11u + i] = m_params.bgInnerColour[i];
+			paramsPtr[15u + i] = m_params.bgOuterColour[i];
+		}
+		for( size_t y = 0u; y < numColumns; ++y )
+		{
+			const Ogre::ColourValue &colour = m_columns[y].rectangle->getColour();
+			for( size_t i = 0u; i < 4u; ++i )
+				paramsPtr[19u + y * 4u + i] = colour[i];
 		}
+
+		uint16_t *RESTRICT_ALIAS dstData =
+			reinterpret_cast<uint16_t * RESTRICT_ALIAS>( textureBox.at( 0u, numColumns, 0u ) );
+		for( size_t x = 0u; x < numParams; ++x )
+			dstData[x] = Ogre::Bitwise::floatToHalf( paramsPtr[x] );
+		for( size_t x = numParams; x < textureBox.width; ++x )
+			dstData[x] = 0u;
 	}
 
 	stagingTexture->stopMapRegion();
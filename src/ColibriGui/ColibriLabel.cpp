@@ -2,6 +2,7 @@
 #include "ColibriGui/ColibriLabel.h"
 
 #include "ColibriGui/ColibriLabelBmp.h"
+#include "ColibriGui/ColibriSkinManager.h"
 #include "ColibriGui/Text/ColibriBmpFont.h"
 #include "ColibriGui/Text/ColibriShaperManager.h"
 #include "ColibriRenderable.inl"
@@ -70,14 +71,20 @@ namespace Colibri
 #if COLIBRIGUI_DEBUG >= COLIBRIGUI_DEBUG_MEDIUM
 			m_glyphsAligned[i] = true;
 #endif
+			m_breakOpportunitiesDirty[i] = true;
+			m_placedBounds[i] = Ogre::Vector2( -1.0f );
 		}
 
 		m_numVertices = 0;
 
 		setCustomParameter( 6373, Ogre::Vector4( 1.0f ) );
 
+		SkinManager *skinManager = m_manager->getSkinManager();
 		for( size_t i = 0; i < States::NumStates; ++i )
-			m_stateInformation[i].materialName = ColibriManager::c_defaultTextDatablockNames[i];
+		{
+			m_stateInformation[i] = skinManager->getDefaultStateInformation(
+				ColibriManager::c_defaultTextDatablockNames[i] );
+		}
 
 		Ogre::HlmsDatablock *datablock = manager->getDefaultTextDatablock()[States::Idle];
 		COLIBRI_ASSERT_MEDIUM(
@@ -95,6 +102,99 @@ namespace Colibri
 		m_rasterPrivateArea = 0;
 	}
 	//-------------------------------------------------------------------------
+	void Label::_cloneSettingsTo( Widget *_dst ) const
+	{
+		Renderable::_cloneSettingsTo( _dst );
+
+		COLIBRI_ASSERT_HIGH( dynamic_cast<Label *>( _dst ) );
+		Label *dst = static_cast<Label *>( _dst );
+
+		// dst may already be flagged dirty (e.g. Button::getLabel sets its alignment).
+		// That's fine: each state's dirty flags are overwritten below. But it must
+		// not own any glyph yet, or their ref counts would leak.
+#if COLIBRIGUI_DEBUG >= COLIBRIGUI_DEBUG_LOW
+		for( size_t i = 0; i < States::NumStates; ++i )
+		{
+			COLIBRI_ASSERT_LOW( dst->m_shapes[i].empty() &&
+								"dst must be a freshly created Label" );
+		}
+#endif
+
+		dst->m_clipTextToWidget = m_clipTextToWidget;
+		dst->m_shadowOutline = m_shadowOutline;
+		dst->m_shadowColour = m_shadowColour;
+		dst->m_shadowDisplace = m_shadowDisplace;
+		dst->m_defaultColour = m_defaultColour;
+		dst->m_backgroundSize = m_backgroundSize;
+		dst->m_defaultBackgroundColour = m_defaultBackgroundColour;
+		dst->m_defaultFontSize = m_defaultFontSize;
+		dst->m_defaultFont = m_defaultFont;
+		dst->m_lineHeightScale = m_lineHeightScale;
+		dst->m_lastLineHeightScale = m_lastLineHeightScale;
+		dst->m_linebreakMode = m_linebreakMode;
+		dst->m_horizAlignment = m_horizAlignment;
+		dst->m_vertAlignment = m_vertAlignment;
+		dst->m_vertReadingDir = m_vertReadingDir;
+		dst->m_usesBackground = m_usesBackground;
+
+		// Private Use Area glyphs need their own LabelBmp. Just reshape in that case.
+		const bool bReshapeAll = !m_privateAreaGlyphs.empty();
+
+		ShaperManager *shaperManager = m_manager->getShaperManager();
+
+		bool bGlyphsAdded = false;
+
+		for( size_t i = 0; i < States::NumStates; ++i )
+		{
+			dst->m_text[i] = m_text[i];
+			dst->m_richText[i] = m_richText[i];
+
+			if( m_glyphsDirty[i] || bReshapeAll )
+			{
+				dst->flagDirty( static_cast<States::States>( i ) );
+			}
+			else
+			{
+				dst->m_shapes[i] = m_shapes[i];
+				dst->m_glyphsDirty[i] = false;
+				dst->m_glyphsPlaced[i] = m_glyphsPlaced[i];
+#if COLIBRIGUI_DEBUG >= COLIBRIGUI_DEBUG_MEDIUM
+				dst->m_glyphsAligned[i] = m_glyphsAligned[i];
+#endif
+				dst->m_breakOpportunities[i] = m_breakOpportunities[i];
+				dst->m_hardLineHeights[i] = m_hardLineHeights[i];
+				dst->m_hardLineFirstGlyph[i] = m_hardLineFirstGlyph[i];
+				dst->m_hardLineStartUtf16[i] = m_hardLineStartUtf16[i];
+				dst->m_breakOpportunitiesDirty[i] = m_breakOpportunitiesDirty[i];
+				dst->m_placedBounds[i] = m_placedBounds[i];
+				dst->m_actualHorizAlignment[i] = m_actualHorizAlignment[i];
+				dst->m_actualVertReadingDir[i] = m_actualVertReadingDir[i];
+
+				ShapedGlyphVec::const_iterator itor = dst->m_shapes[i].begin();
+				ShapedGlyphVec::const_iterator endt = dst->m_shapes[i].end();
+
+				while( itor != endt )
+				{
+					shaperManager->addRefCount( itor->glyph );
+					++itor;
+				}
+
+				bGlyphsAdded |= !dst->m_shapes[i].empty();
+			}
+		}
+
+		// flagDirty resets it
+		dst->m_usesBackground = m_usesBackground;
+
+		if( bGlyphsAdded )
+			m_manager->_notifyNumGlyphsIsDirty();
+	}
+	//-------------------------------------------------------------------------
+	bool Label::_isInternalChild( const Widget *child ) const
+	{
+		return child == m_rasterPrivateArea;
+	}
+	//-------------------------------------------------------------------------
 	Label::PrivateAreaGlyphsVec *Label::createPrivateAreaGlyphs( States::States state )
 	{
 		std::map<States::States, PrivateAreaGlyphsVec>::iterator itor =
@@ -108,7 +208,7 @@ namespace Colibri
 			m_rasterPrivateArea = m_manager->createWidget<LabelBmp>( this );
 			m_rasterPrivateArea->m_rawMode = true;
 			m_rasterPrivateArea->setFont( shaperManager->getDefaultBmpFontForRasterIdx() );
-			m_rasterPrivateArea->setSize( m_size );
+			m_rasterPrivateArea->setSize( _size() );
 		}
 
 		auto insertedIt = m_privateAreaGlyphs.insert( { state, PrivateAreaGlyphsVec() } );
@@ -227,6 +327,20 @@ namespace Colibri
 		m_shadowDisplace = shadowDisplace;
 	}
 	//-------------------------------------------------------------------------
+	void Label::_getShadowDrawData( uint32_t outData[4] ) const
+	{
+		if( !m_shadowOutline )
+		{
+			memset( outData, 0, sizeof( uint32_t ) * 4u );
+			return;
+		}
+
+		outData[0] = ( m_shadowColour * m_colour ).getAsABGR();
+		memcpy( &outData[1], &m_shadowDisplace.x, sizeof( float ) );
+		memcpy( &outData[2], &m_shadowDisplace.y, sizeof( float ) );
+		outData[3] = 0u;
+	}
+	//-------------------------------------------------------------------------
 	void Label::setDefaultFontSize( FontSize defaultFontSize )
 	{
 		if( m_defaultFontSize != defaultFontSize )
@@ -264,6 +378,10 @@ namespace Colibri
 	{
 		m_lineHeightScale = lineHeightScale;
 		m_lastLineHeightScale = lastLineHeightScale;
+
+		// Will be applied the next time glyphs are placed. Don't skip it
+		for( size_t i = 0; i < States::NumStates; ++i )
+			m_placedBounds[i] = Ogre::Vector2( -1.0f );
 	}
 	//-------------------------------------------------------------------------
 	void Label::setTextColour( const Ogre::ColourValue &colour, size_t richTextTextIdx,
@@ -383,6 +501,12 @@ namespace Colibri
 #if COLIBRIGUI_DEBUG >= COLIBRIGUI_DEBUG_MEDIUM
 					m_glyphsAligned[state] = m_glyphsAligned[i];
 #endif
+					m_breakOpportunities[state] = m_breakOpportunities[i];
+					m_hardLineHeights[state] = m_hardLineHeights[i];
+					m_hardLineFirstGlyph[state] = m_hardLineFirstGlyph[i];
+					m_hardLineStartUtf16[state] = m_hardLineStartUtf16[i];
+					m_breakOpportunitiesDirty[state] = m_breakOpportunitiesDirty[i];
+					m_placedBounds[state] = m_placedBounds[i];
 					m_actualHorizAlignment[state] = m_actualHorizAlignment[i];
 					m_actualVertReadingDir[state] = m_actualVertReadingDir[i];
 
@@ -430,6 +554,8 @@ namespace Colibri
 
 		if( !reusableFound )
 		{
+			m_breakOpportunitiesDirty[state] = true;
+
 			PrivateAreaGlyphsVec *privateAreaGlyphs = getPrivateAreaGlyphs( state );
 			if( privateAreaGlyphs )
 				privateAreaGlyphs->clear();
@@ -520,8 +646,9 @@ namespace Colibri
 	//-------------------------------------------------------------------------
 	void Label::placeGlyphs( States::States state, bool performAlignment )
 	{
-		const Ogre::Vector2 bottomRight =
-			m_size * ( 2.0f * m_manager->getHalfWindowResolution() / m_manager->getCanvasSize() );
+		const Ogre::Vector2 bottomRight = getPlacementBounds();
+
+		updateBreakOpportunities( state );
 
 		Word nextWord;
 		memset( &nextWord, 0, sizeof( Word ) );
@@ -529,7 +656,8 @@ namespace Colibri
 		const float vertReadDirSign =
 			m_actualVertReadingDir[state] == VertReadingDir::ForceTTB ? -1.0f : 1.0f;
 
-		float largestHeight = findLineMaxHeight( m_shapes[state].begin(), state );
+		size_t lineIdx = 0u;
+		float largestHeight = getHardLineHeight( state, lineIdx );
 		if( m_actualVertReadingDir[state] == VertReadingDir::Disabled )
 			nextWord.endCaretPos.y += largestHeight;
 		else
@@ -537,8 +665,40 @@ namespace Colibri
 
 		bool multipleWordsInLine = false;
 
-		while( findNextWord( nextWord, state ) )
+		BreakOpportunityVec::const_iterator itBreak = m_breakOpportunities[state].begin();
+		BreakOpportunityVec::const_iterator enBreak = m_breakOpportunities[state].end();
+
+		while( itBreak != enBreak )
 		{
+			const BreakOpportunity &breakOpportunity = *itBreak;
+
+			nextWord.offset = breakOpportunity.offset;
+			nextWord.length = breakOpportunity.length;
+			nextWord.startCaretPos = nextWord.endCaretPos;
+			nextWord.endCaretPos += breakOpportunity.advance;
+			nextWord.lastAdvance = breakOpportunity.lastAdvance;
+			nextWord.lastCharWidth = breakOpportunity.lastCharWidth;
+
+			const ShapedGlyph &firstGlyph = m_shapes[state][breakOpportunity.offset];
+			if( firstGlyph.isTab )
+			{
+				// Tab stops depend on where the caret is, thus they can't be cached
+				if( m_actualVertReadingDir[state] == VertReadingDir::Disabled )
+				{
+					nextWord.endCaretPos.x =
+						ceilf( ( nextWord.startCaretPos.x + firstGlyph.advance.x * 0.25f ) /
+							   ( firstGlyph.advance.x * 2.0f ) ) *
+						( firstGlyph.advance.x * 2.0f );
+				}
+				else
+				{
+					nextWord.endCaretPos.y =
+						ceilf( ( nextWord.startCaretPos.y + firstGlyph.advance.y * 0.25f ) /
+							   ( firstGlyph.advance.y * 4.0f ) ) *
+						( firstGlyph.advance.y * 4.0f );
+				}
+			}
+
 			if( m_linebreakMode == LinebreakMode::WordWrap )
 			{
 				if( m_actualVertReadingDir[state] == VertReadingDir::Disabled )
@@ -607,14 +767,14 @@ namespace Colibri
 				}
 				else if( shapedGlyph.isTab )
 				{
-					// findNextWord already took care of this
+					// The tab stop was already calculated above
 					shapedGlyph.caretPos = caretPos;
 					caretPos += shapedGlyph.advance;
 				}
 				else /* if( shapedGlyph.isNewline )*/
 				{
 					shapedGlyph.caretPos = caretPos;
-					largestHeight = findLineMaxHeight( itor + 1u, state );
+					largestHeight = getHardLineHeight( state, ++lineIdx );
 
 					if( m_actualVertReadingDir[state] == VertReadingDir::Disabled )
 					{
@@ -640,9 +800,13 @@ namespace Colibri
 
 				++itor;
 			}
+
+			++itBreak;
 		}
 
 		m_glyphsPlaced[state] = true;
+		// Without alignment the result is not final (e.g. sizeToFit). Don't let it be reused
+		m_placedBounds[state] = performAlignment ? bottomRight : Ogre::Vector2( -1.0f );
 #if COLIBRIGUI_DEBUG >= COLIBRIGUI_DEBUG_MEDIUM
 		m_glyphsAligned[state] = false;
 #endif
@@ -683,7 +847,7 @@ namespace Colibri
 		float prevCaretY = 0;
 
 		const Ogre::Vector2 widgetBottomRight =
-			m_size * ( 2.0f * m_manager->getHalfWindowResolution() / m_manager->getCanvasSize() );
+			_size() * ( 2.0f * m_manager->getHalfWindowResolution() / m_manager->getCanvasSize() );
 
 		// To gather width & height
 		Ogre::Vector2 maxBottomRight( -std::numeric_limits<float>::max() );
@@ -794,7 +958,7 @@ namespace Colibri
 		float prevCaretX = 0;
 
 		const Ogre::Vector2 widgetBottomRight =
-			m_size * ( 2.0f * m_manager->getHalfWindowResolution() / m_manager->getCanvasSize() );
+			_size() * ( 2.0f * m_manager->getHalfWindowResolution() / m_manager->getCanvasSize() );
 
 		// To gather width & height
 		Ogre::Vector2 maxBottomRight( -std::numeric_limits<float>::max() );
@@ -973,98 +1137,100 @@ namespace Colibri
 #undef COLIBRI_ADD_VERTEX
 	}
 	//-------------------------------------------------------------------------
-	bool Label::findNextWord( Word &inOutWord, States::States state ) const
+	void Label::updateBreakOpportunities( States::States state )
 	{
-		COLIBRI_ASSERT_LOW( inOutWord.offset <= m_shapes[state].size() &&
-							inOutWord.offset + inOutWord.length <= m_shapes[state].size() );
+		if( !m_breakOpportunitiesDirty[state] )
+			return;
 
-		Word word = inOutWord;
+		BreakOpportunityVec &breakOpportunities = m_breakOpportunities[state];
+		std::vector<float> &hardLineHeights = m_hardLineHeights[state];
+		std::vector<uint32_t> &hardLineFirstGlyph = m_hardLineFirstGlyph[state];
+		std::vector<uint32_t> &hardLineStartUtf16 = m_hardLineStartUtf16[state];
+		breakOpportunities.clear();
+		hardLineHeights.clear();
+		hardLineFirstGlyph.clear();
+		hardLineStartUtf16.clear();
 
-		if( word.offset == m_shapes[state].size() ||
-			word.offset + word.length == m_shapes[state].size() )
-		{
-			word.length = 0;
-			word.lastAdvance = 0;
-			word.lastCharWidth = 0;
-			// word.endCaretPos		= Ogre::Vector2::ZERO;
-			return false;
-		}
+		hardLineFirstGlyph.push_back( 0u );
+		hardLineStartUtf16.push_back( 0u );
+		bool hasRtl = false;
 
-		word.offset = word.offset + word.length;
+		const bool isHorizontal = m_actualVertReadingDir[state] == VertReadingDir::Disabled;
 
-		ShapedGlyphVec::const_iterator itor = m_shapes[state].begin() + ptrdiff_t( word.offset );
-		ShapedGlyphVec::const_iterator endt = m_shapes[state].end();
+		float largestHeight = 0;
 
-		ShapedGlyph firstGlyph = *itor;
-		word.startCaretPos = word.endCaretPos;
-		word.endCaretPos += firstGlyph.advance;
-		word.lastAdvance = firstGlyph.advance;
-		if( m_actualVertReadingDir[state] == VertReadingDir::Disabled )
-			word.lastCharWidth = firstGlyph.glyph->width;
-		else
-			word.lastCharWidth = firstGlyph.glyph->height;
-		const bool isRtl = firstGlyph.isRtl;
-		++itor;
+		ShapedGlyphVec::const_iterator itor = m_shapes[state].begin();
+		ShapedGlyphVec::const_iterator endt = m_shapes[state].end();
 
-		if( !firstGlyph.isNewline && !firstGlyph.isWordBreaker )
-		{
-			while( itor != endt && !itor->isNewline && !itor->isWordBreaker && itor->isRtl == isRtl )
-			{
-				const ShapedGlyph &shapedGlyph = *itor;
-				word.endCaretPos += shapedGlyph.advance;
-				word.lastAdvance = shapedGlyph.advance;
-				if( m_actualVertReadingDir[state] == VertReadingDir::Disabled )
-					word.lastCharWidth = shapedGlyph.glyph->width;
-				else
-					word.lastCharWidth = shapedGlyph.glyph->height;
-				++itor;
-			}
-		}
-		else if( firstGlyph.isTab )
+		while( itor != endt )
 		{
-			if( m_actualVertReadingDir[state] == VertReadingDir::Disabled )
+			const ShapedGlyph &firstGlyph = *itor;
+
+			BreakOpportunity breakOpportunity;
+			breakOpportunity.offset = static_cast<uint32_t>( itor - m_shapes[state].begin() );
+			breakOpportunity.advance = firstGlyph.advance;
+			breakOpportunity.lastAdvance = firstGlyph.advance;
+			breakOpportunity.lastCharWidth =
+				isHorizontal ? firstGlyph.glyph->width : firstGlyph.glyph->height;
+			largestHeight = std::max( firstGlyph.glyph->newlineSize, largestHeight );
+			hasRtl |= firstGlyph.isRtl;
+			++itor;
+
+			if( firstGlyph.isNewline )
 			{
-				word.endCaretPos.x = ceilf( ( word.startCaretPos.x + firstGlyph.advance.x * 0.25f ) /
-											( firstGlyph.advance.x * 2.0f ) ) *
-									 ( firstGlyph.advance.x * 2.0f );
+				// The newline itself has its own height. It's already been considered
+				hardLineHeights.push_back( largestHeight );
+				largestHeight = 0;
+
+				hardLineFirstGlyph.push_back(
+					static_cast<uint32_t>( itor - m_shapes[state].begin() ) );
+				hardLineStartUtf16.push_back( firstGlyph.clusterStart + firstGlyph.clusterLength );
 			}
-			else
+			else if( !firstGlyph.isWordBreaker )
 			{
-				word.endCaretPos.y = ceilf( ( word.startCaretPos.y + firstGlyph.advance.y * 0.25f ) /
-											( firstGlyph.advance.y * 4.0f ) ) *
-									 ( firstGlyph.advance.y * 4.0f );
+				while( itor != endt && !itor->isNewline && !itor->isWordBreaker &&
+					   itor->isRtl == firstGlyph.isRtl )
+				{
+					const ShapedGlyph &shapedGlyph = *itor;
+					breakOpportunity.advance += shapedGlyph.advance;
+					breakOpportunity.lastAdvance = shapedGlyph.advance;
+					breakOpportunity.lastCharWidth =
+						isHorizontal ? shapedGlyph.glyph->width : shapedGlyph.glyph->height;
+					largestHeight = std::max( shapedGlyph.glyph->newlineSize, largestHeight );
+					++itor;
+				}
 			}
+
+			breakOpportunity.length =
+				static_cast<uint32_t>( itor - m_shapes[state].begin() ) - breakOpportunity.offset;
+			breakOpportunities.push_back( breakOpportunity );
 		}
 
-		word.length =
-			static_cast<size_t>( itor - ( m_shapes[state].begin() + ptrdiff_t( word.offset ) ) );
+		// Last line (not terminated by a newline)
+		hardLineHeights.push_back( largestHeight );
 
-		inOutWord = word;
+		if( hasRtl )
+		{
+			hardLineFirstGlyph.clear();
+			hardLineStartUtf16.clear();
+		}
 
-		return word.length != 0;
+		m_breakOpportunitiesDirty[state] = false;
 	}
 	//-------------------------------------------------------------------------
-	float Label::findLineMaxHeight( ShapedGlyphVec::const_iterator start, States::States state ) const
+	float Label::getHardLineHeight( States::States state, size_t lineIdx ) const
 	{
-		COLIBRI_ASSERT_LOW( start >= m_shapes[state].begin() && start <= m_shapes[state].end() );
-
-		float largestHeight = 0;
-
-		ShapedGlyphVec::const_iterator itor = start;
-		ShapedGlyphVec::const_iterator endt = m_shapes[state].end();
-		while( itor != endt && !itor->isNewline )
-		{
-			largestHeight = std::max( itor->glyph->newlineSize, largestHeight );
-			++itor;
-		}
+		COLIBRI_ASSERT_LOW( lineIdx < m_hardLineHeights[state].size() );
 
-		// The newline itself has its own height, make sure it's considered
-		if( itor != endt )
-			largestHeight = std::max( itor->glyph->newlineSize, largestHeight ) * m_lineHeightScale;
+		if( lineIdx + 1u < m_hardLineHeights[state].size() )
+			return m_hardLineHeights[state][lineIdx] * m_lineHeightScale;
 		else
-			largestHeight *= m_lastLineHeightScale;
-
-		return largestHeight;
+			return m_hardLineHeights[state][lineIdx] * m_lastLineHeightScale;
+	}
+	//-------------------------------------------------------------------------
+	Ogre::Vector2 Label::getPlacementBounds() const
+	{
+		return _size() * ( 2.0f * m_manager->getHalfWindowResolution() / m_manager->getCanvasSize() );
 	}
 	//-------------------------------------------------------------------------
 	GlyphVertex *Label::fillBackground( GlyphVertex *RESTRICT_ALIAS textVertBuffer,
@@ -1076,13 +1242,13 @@ namespace Colibri
 		const Ogre::Vector2 invSize = 1.0f / ( parentDerivedBR - parentDerivedTL );
 
 		// Snap position to pixels
-		Ogre::Vector2 derivedTopLeft = m_derivedTopLeft;
+		Ogre::Vector2 derivedTopLeft = _derivedTopLeft();
 		derivedTopLeft = ( derivedTopLeft + 1.0f ) * halfWindowRes;
 		derivedTopLeft.x = roundf( derivedTopLeft.x );
 		derivedTopLeft.y = roundf( derivedTopLeft.y );
 		derivedTopLeft = derivedTopLeft * invWindowRes - 1.0f;
 
-		const Matrix2x3 derivedRot = m_derivedOrientation;
+		const Matrix2x3 derivedRot = _derivedOrientation();
 		const float canvasAr = m_manager->getCanvasAspectRatio();
 		const float invCanvasAr = m_manager->getCanvasInvAspectRatio();
 
@@ -1217,13 +1383,14 @@ namespace Colibri
 
 		updateDerivedTransform( parentPos, parentRot );
 
-		m_culled = true;
+		_culled() = true;
 
 		m_numVertices = 0;
-		if( !m_parent->intersectsChild( this, parentCurrentScrollPos ) || m_hidden )
+		if( !m_parent->intersectsChild( this, parentCurrentScrollPos ) || m_hidden ||
+			m_manager->_isOccluded( _derivedTopLeft(), _derivedBottomRight() ) )
 			return;
 
-		m_culled = false;
+		_culled() = false;
 
 		if( !m_visualsEnabled )
 			return;
@@ -1231,26 +1398,33 @@ namespace Colibri
 		m_currVertexBufferOffset =
 			static_cast<uint32_t>( textVertBuffer - m_manager->_getTextVertexBufferBase() );
 
-		const uint32_t shadowColour = ( m_shadowColour * m_colour ).getAsABGR();
-
 		const Ogre::Vector2 halfWindowRes = m_manager->getHalfWindowResolution();
 		const Ogre::Vector2 invWindowRes = m_manager->getInvWindowResolution2x();
 
-		const Ogre::Vector2 shadowDisplacement = invWindowRes * m_shadowDisplace;
+		// The shadow is drawn by the pixel shader. Enlarge the quads so it fits.
+		// The shadow's colour & displacement are per draw. See _getShadowDrawData
+		Ogre::Vector2 shadowGrowTL( Ogre::Vector2::ZERO );
+		Ogre::Vector2 shadowGrowBR( Ogre::Vector2::ZERO );
+		if( m_shadowOutline )
+		{
+			const Ogre::Vector2 shadowDisplacement = invWindowRes * m_shadowDisplace;
+			shadowGrowTL.makeFloor( shadowDisplacement );
+			shadowGrowBR.makeCeil( shadowDisplacement );
+		}
 
 		Ogre::Vector2 invCanvasSize2x = m_manager->getInvCanvasSize2x();
 		Ogre::Vector2 parentDerivedTL =
-			m_parent->m_derivedTopLeft + m_parent->m_clipBorderTL * invCanvasSize2x;
+			m_parent->_derivedTopLeft() + m_parent->m_clipBorderTL * invCanvasSize2x;
 		Ogre::Vector2 parentDerivedBR =
-			m_parent->m_derivedBottomRight - m_parent->m_clipBorderBR * invCanvasSize2x;
-		parentDerivedTL.makeCeil( m_parent->m_accumMinClipTL );
-		parentDerivedBR.makeFloor( m_parent->m_accumMaxClipBR );
-		m_accumMinClipTL = parentDerivedTL;
-		m_accumMaxClipBR = parentDerivedBR;
+			m_parent->_derivedBottomRight() - m_parent->m_clipBorderBR * invCanvasSize2x;
+		parentDerivedTL.makeCeil( m_parent->_accumMinClipTL() );
+		parentDerivedBR.makeFloor( m_parent->_accumMaxClipBR() );
+		_accumMinClipTL() = parentDerivedTL;
+		_accumMaxClipBR() = parentDerivedBR;
 		if( m_clipTextToWidget )
 		{
-			parentDerivedTL.makeCeil( this->m_derivedTopLeft );
-			parentDerivedBR.makeFloor( this->m_derivedBottomRight );
+			parentDerivedTL.makeCeil( this->_derivedTopLeft() );
+			parentDerivedBR.makeFloor( this->_derivedBottomRight() );
 		}
 
 		const Ogre::Vector2 invSize = 1.0f / ( parentDerivedBR - parentDerivedTL );
@@ -1263,13 +1437,13 @@ namespace Colibri
 		}
 
 		// Snap position to pixels
-		Ogre::Vector2 derivedTopLeft = m_derivedTopLeft;
+		Ogre::Vector2 derivedTopLeft = _derivedTopLeft();
 		derivedTopLeft = ( derivedTopLeft + 1.0f ) * halfWindowRes;
 		derivedTopLeft.x = roundf( derivedTopLeft.x );
 		derivedTopLeft.y = roundf( derivedTopLeft.y );
 		derivedTopLeft = derivedTopLeft * invWindowRes - 1.0f;
 
-		const Matrix2x3 derivedRot = m_derivedOrientation;
+		const Matrix2x3 derivedRot = _derivedOrientation();
 		const float canvasAr = m_manager->getCanvasAspectRatio();
 		const float invCanvasAr = m_manager->getCanvasInvAspectRatio();
 
@@ -1300,19 +1474,6 @@ namespace Colibri
 				topLeft = derivedTopLeft + topLeft * invWindowRes;
 				bottomRight = derivedTopLeft + bottomRight * invWindowRes;
 
-				if( m_shadowOutline )
-				{
-					addQuad( textVertBuffer,                                           //
-							 topLeft + shadowDisplacement,                             //
-							 bottomRight + shadowDisplacement,                         //
-							 shapedGlyph.glyph->width, shapedGlyph.glyph->height,      //
-							 shadowColour, parentDerivedTL, parentDerivedBR, invSize,  //
-							 shapedGlyph.glyph->offsetStart,                           //
-							 canvasAr, invCanvasAr, derivedRot );
-					textVertBuffer += 6u;
-					m_numVertices += 6u;
-				}
-
 				const RichText &richText = m_richText[m_currentState][shapedGlyph.richTextIdx];
 
 				const uint32_t oldRgba32 = richText.rgba32;
@@ -1323,10 +1484,12 @@ namespace Colibri
 				newRgba32 |= ( ( ( ( oldRgba32 >> 16u ) & 0xFFu ) * colourRgba8[2] ) / 255u ) << 16u;
 				newRgba32 |= ( ( ( ( oldRgba32 >> 24u ) & 0xFFu ) * colourRgba8[3] ) / 255u ) << 24u;
 
-				addQuad( textVertBuffer, topLeft, bottomRight,                  //
-						 shapedGlyph.glyph->width, shapedGlyph.glyph->height,   //
+				addQuad( textVertBuffer,                                        //
+						 topLeft + shadowGrowTL, bottomRight + shadowGrowBR,    //
+						 shapedGlyph.glyph->atlasWidth,                         //
+						 shapedGlyph.glyph->atlasHeight,                        //
 						 newRgba32, parentDerivedTL, parentDerivedBR, invSize,  //
-						 shapedGlyph.glyph->offsetStart,                        //
+						 shapedGlyph.glyph->getVertexOffset(),                  //
 						 canvasAr, invCanvasAr, derivedRot );
 				textVertBuffer += 6u;
 
@@ -1338,8 +1501,8 @@ namespace Colibri
 
 		*_textVertBuffer = textVertBuffer;
 
-		const Ogre::Vector2 outerTopLeft = this->m_derivedTopLeft;
-		const Matrix2x3 &finalRot = this->m_derivedOrientation;
+		const Ogre::Vector2 outerTopLeft = this->_derivedTopLeft();
+		const Matrix2x3 finalRot = this->_derivedOrientation();
 		const Ogre::Vector2 outerTopLeftWithClipping = outerTopLeft + m_clipBorderTL * invCanvasSize2x;
 
 		WidgetVec::const_iterator itChild = m_children.begin();
@@ -1381,6 +1544,7 @@ namespace Colibri
 			m_manager->_addDirtyLabel( this );
 		m_glyphsDirty[state] = true;
 		m_glyphsPlaced[state] = false;
+		m_placedBounds[state] = Ogre::Vector2( -1.0f );
 #if COLIBRIGUI_DEBUG >= COLIBRIGUI_DEBUG_MEDIUM
 		m_glyphsAligned[state] = false;
 #endif
@@ -1395,8 +1559,6 @@ namespace Colibri
 
 		const size_t maxGlyphs = retVal;
 
-		if( m_shadowOutline )
-			retVal += maxGlyphs;
 		if( m_usesBackground )
 			retVal += maxGlyphs;
 
@@ -1428,6 +1590,212 @@ namespace Colibri
 		}
 	}
 	//-------------------------------------------------------------------------
+	bool Label::spliceText( States::States state, size_t utf16Start, size_t utf16Length,
+							const char *newText )
+	{
+		if( m_glyphsDirty[state] || m_richText[state].size() != 1u ||
+			m_vertReadingDir != VertReadingDir::Disabled )
+		{
+			return false;
+		}
+
+		const PrivateAreaGlyphsVec *privateAreaGlyphs = getPrivateAreaGlyphs( state );
+		if( privateAreaGlyphs && !privateAreaGlyphs->empty() )
+			return false;
+
+		updateBreakOpportunities( state );
+
+		const std::vector<uint32_t> &lineFirstGlyph = m_hardLineFirstGlyph[state];
+		const std::vector<uint32_t> &lineStartUtf16 = m_hardLineStartUtf16[state];
+		if( lineStartUtf16.empty() )
+			return false;
+
+		UnicodeString uStr( UnicodeString::fromUTF8( m_text[state] ) );
+		const size_t textLength = static_cast<size_t>( uStr.length() );
+		utf16Start = std::min( utf16Start, textLength );
+		utf16Length = std::min( utf16Length, textLength - utf16Start );
+
+		// Find the lines touched by the edit. Editing at the very start of a line doesn't affect
+		// the previous one, but removing a newline joins its line with the next one.
+		const size_t numLines = lineStartUtf16.size();
+		const size_t firstLine = static_cast<size_t>(
+			std::upper_bound( lineStartUtf16.begin(), lineStartUtf16.end(), utf16Start ) -
+			lineStartUtf16.begin() - 1 );
+		const size_t lastLine = static_cast<size_t>(
+			std::upper_bound( lineStartUtf16.begin(), lineStartUtf16.end(),
+							  utf16Start + utf16Length ) -
+			lineStartUtf16.begin() - 1 );
+
+		const size_t segmentStart = lineStartUtf16[firstLine];
+		const size_t segmentEnd = lastLine + 1u < numLines ? lineStartUtf16[lastLine + 1u] : textLength;
+		const size_t glyphStart = lineFirstGlyph[firstLine];
+		const size_t glyphEnd =
+			lastLine + 1u < numLines ? lineFirstGlyph[lastLine + 1u] : m_shapes[state].size();
+
+		UnicodeString insertStr( UnicodeString::fromUTF8( newText ) );
+		UnicodeString segment( uStr, static_cast<int32_t>( segmentStart ),
+							   static_cast<int32_t>( segmentEnd - segmentStart ) );
+		segment.replace( static_cast<int32_t>( utf16Start - segmentStart ),
+						 static_cast<int32_t>( utf16Length ), insertStr );
+
+		std::string segmentUtf8;
+		segment.toUTF8String( segmentUtf8 );
+
+		// Shape the new lines on their own. Each line is a paragraph for the bidi algorithm,
+		// thus they don't depend on the rest of the text.
+		ShaperManager *shaperManager = m_manager->getShaperManager();
+
+		RichText richText = m_richText[state][0];
+		richText.offset = 0u;
+		richText.length = static_cast<uint32_t>( segmentUtf8.size() );
+
+		ShapedGlyphVec newShapes;
+		bool bHasPrivateUse = false;
+		const TextHorizAlignment::TextHorizAlignment actualDir =
+			shaperManager->renderString( segmentUtf8.c_str(), richText, 0u, m_vertReadingDir,
+										 newShapes, bHasPrivateUse );
+
+		bool canSplice = !bHasPrivateUse || !shaperManager->getDefaultBmpFontForRaster();
+		{
+			ShapedGlyphVec::const_iterator itor = newShapes.begin();
+			ShapedGlyphVec::const_iterator endt = newShapes.end();
+
+			while( itor != endt && canSplice )
+			{
+				canSplice = !itor->isRtl;
+				++itor;
+			}
+		}
+
+		if( !canSplice )
+		{
+			ShapedGlyphVec::const_iterator itor = newShapes.begin();
+			ShapedGlyphVec::const_iterator endt = newShapes.end();
+
+			while( itor != endt )
+			{
+				shaperManager->releaseGlyph( itor->glyph );
+				++itor;
+			}
+			return false;
+		}
+
+		const std::string oldText = m_text[state];
+
+		// Splice the new glyphs in place of the old ones
+		ShapedGlyphVec &shapes = m_shapes[state];
+		const size_t prevNumGlyphs = shapes.size();
+		{
+			ShapedGlyphVec::const_iterator itor = shapes.begin() + ptrdiff_t( glyphStart );
+			ShapedGlyphVec::const_iterator endt = shapes.begin() + ptrdiff_t( glyphEnd );
+
+			while( itor != endt )
+			{
+				shaperManager->releaseGlyph( itor->glyph );
+				++itor;
+			}
+		}
+
+		{
+			ShapedGlyphVec::iterator itor = newShapes.begin();
+			ShapedGlyphVec::iterator endt = newShapes.end();
+
+			while( itor != endt )
+			{
+				itor->clusterStart += static_cast<uint32_t>( segmentStart );
+				++itor;
+			}
+		}
+
+		shapes.erase( shapes.begin() + ptrdiff_t( glyphStart ), shapes.begin() + ptrdiff_t( glyphEnd ) );
+		shapes.insert( shapes.begin() + ptrdiff_t( glyphStart ), newShapes.begin(), newShapes.end() );
+
+		// Glyphs after the edit keep their shapes, but their clusters moved
+		const uint32_t oldSegmentLength = static_cast<uint32_t>( segmentEnd - segmentStart );
+		const uint32_t newSegmentLength = static_cast<uint32_t>( segment.length() );
+		{
+			ShapedGlyphVec::iterator itor = shapes.begin() + ptrdiff_t( glyphStart + newShapes.size() );
+			ShapedGlyphVec::iterator endt = shapes.end();
+
+			while( itor != endt )
+			{
+				itor->clusterStart = itor->clusterStart - oldSegmentLength + newSegmentLength;
+				++itor;
+			}
+		}
+
+		uStr.replace( static_cast<int32_t>( utf16Start ), static_cast<int32_t>( utf16Length ),
+					  insertStr );
+		m_text[state].clear();
+		uStr.toUTF8String( m_text[state] );
+
+		RichText &stateRichText = m_richText[state][0];
+		stateRichText.offset = 0u;
+		stateRichText.length = static_cast<uint32_t>( m_text[state].size() );
+		stateRichText.glyphStart = 0u;
+		stateRichText.glyphEnd = static_cast<uint32_t>( shapes.size() );
+
+		if( firstLine == 0u && m_horizAlignment == TextHorizAlignment::Natural )
+		{
+			// The first line decides the natural alignment (see updateGlyphs)
+			if( actualDir == TextHorizAlignment::Mixed )
+				m_actualHorizAlignment[state] = shaperManager->getDefaultTextDirection();
+			else
+				m_actualHorizAlignment[state] = actualDir;
+		}
+
+		m_breakOpportunitiesDirty[state] = true;
+		placeGlyphs( state );
+
+		// Other states showing the same text will copy our glyphs (see updateGlyphs)
+		for( size_t i = 0; i < States::NumStates; ++i )
+		{
+			if( i != state && m_text[i] == oldText )
+			{
+				m_text[i] = m_text[state];
+				if( m_richText[i].size() == 1u )
+				{
+					m_richText[i][0].offset = 0u;
+					m_richText[i][0].length = stateRichText.length;
+				}
+				else
+					m_richText[i] = m_richText[state];
+				flagDirty( static_cast<States::States>( i ) );
+			}
+		}
+
+		if( shapes.size() > prevNumGlyphs )
+			m_manager->_notifyNumGlyphsIsDirty();
+
+		return true;
+	}
+	//-------------------------------------------------------------------------
+	void Label::replaceText( size_t utf16Start, size_t utf16Length, const char *newText )
+	{
+		if( spliceText( m_currentState, utf16Start, utf16Length, newText ) )
+			return;
+
+		UnicodeString uStr( UnicodeString::fromUTF8( m_text[m_currentState] ) );
+		const size_t textLength = static_cast<size_t>( uStr.length() );
+		utf16Start = std::min( utf16Start, textLength );
+		utf16Length = std::min( utf16Length, textLength - utf16Start );
+
+		uStr.replace( static_cast<int32_t>( utf16Start ), static_cast<int32_t>( utf16Length ),
+					  UnicodeString::fromUTF8( newText ) );
+
+		std::string result;
+		uStr.toUTF8String( result );
+
+		// Like spliceText, only states that have the same text as the current one are affected.
+		// Copy the old text first, since setText( ..., m_currentState ) overwrites it.
+		const std::string oldText = m_text[m_currentState];
+		for( size_t i = 0; i < States::NumStates; ++i )
+		{
+			if( m_text[i] == oldText )
+				setText( result, static_cast<States::States>( i ) );
+		}
+	}
+	//-------------------------------------------------------------------------
 	const std::string &Label::getText( States::States state )
 	{
 		if( state == States::NumStates )
@@ -1498,7 +1866,7 @@ namespace Colibri
 	{
 		COLIBRI_ASSERT_MEDIUM( !isAnyStateDirty() );
 
-		Ogre::Vector2 localTopLeft = m_position;
+		Ogre::Vector2 localTopLeft = _position();
 
 		const Ogre::Vector2 canvasSize = m_manager->getCanvasSize();
 		const Ogre::Vector2 invWindowRes = 0.5f * m_manager->getInvWindowResolution2x();
@@ -1628,10 +1996,10 @@ namespace Colibri
 			return;
 
 		// Replace the glyphs forced to the Top-Left so we can gather the width & height
-		const float oldWidth = m_size.x;
-		m_size.x = maxAllowedWidth;
+		const float oldWidth = _size().x;
+		_size().x = maxAllowedWidth;
 		placeGlyphs( baseState, false );
-		m_size.x = oldWidth;
+		_size().x = oldWidth;
 
 		// Gather width & height
 		Ogre::Vector2 maxBottomRight( -std::numeric_limits<float>::max() );
@@ -1667,10 +2035,10 @@ namespace Colibri
 		const Ogre::Vector2 canvasSize = m_manager->getCanvasSize();
 		const Ogre::Vector2 invWindowRes = 0.5f * m_manager->getInvWindowResolution2x();
 
-		Ogre::Vector2 oldSize = m_size;
-		m_size = maxWidthHeight * invWindowRes * canvasSize;
-		m_size.x = std::ceil( m_size.x );
-		m_size.y = std::ceil( m_size.y );
+		Ogre::Vector2 oldSize = _size();
+		_size() = maxWidthHeight * invWindowRes * canvasSize;
+		_size().x = std::ceil( _size().x );
+		_size().y = std::ceil( _size().y );
 
 		// Align the glyphs so horizontal & vertical alignment are respected
 		alignGlyphs( baseState );
@@ -1687,10 +2055,10 @@ namespace Colibri
 		case TextHorizAlignment::Left:
 			break;
 		case TextHorizAlignment::Center:
-			m_position.x = ( m_position.x + oldSize.x - m_size.x ) * 0.5f;
+			_position().x = ( _position().x + oldSize.x - _size().x ) * 0.5f;
 			break;
 		case TextHorizAlignment::Right:
-			m_position.x = m_position.x + oldSize.x - m_size.x;
+			_position().x = _position().x + oldSize.x - _size().x;
 			break;
 		}
 		switch( newVertPos )
@@ -1699,18 +2067,18 @@ namespace Colibri
 		case TextVertAlignment::Top:
 			break;
 		case TextVertAlignment::Center:
-			m_position.y = ( m_position.y + oldSize.y - m_size.y ) * 0.5f;
+			_position().y = ( _position().y + oldSize.y - _size().y ) * 0.5f;
 			break;
 		case TextVertAlignment::Bottom:
-			m_position.y = m_position.y + oldSize.y - m_size.y;
+			_position().y = _position().y + oldSize.y - _size().y;
 			break;
 		}
 
-		m_minSize = m_size;
+		m_minSize = _size();
 
 		if( m_rasterPrivateArea )
 		{
-			m_rasterPrivateArea->setSize( m_size );
+			m_rasterPrivateArea->setSize( _size() );
 			populateRasterPrivateArea();
 		}
 	}
@@ -1720,13 +2088,18 @@ namespace Colibri
 		if( ( dirtyReason & ( TransformDirtyParentCaller | TransformDirtyScale ) ) ==
 			TransformDirtyScale )
 		{
-			// Align the glyphs so horizontal & vertical alignment are respected
-			if( !m_glyphsDirty[m_currentState] && m_glyphsPlaced[m_currentState] )
+			// Align the glyphs so horizontal & vertical alignment are respected.
+			// Nothing to do if the bounds didn't actually change.
+			const Ogre::Vector2 placementBounds = getPlacementBounds();
+			if( !m_glyphsDirty[m_currentState] && m_glyphsPlaced[m_currentState] &&
+				m_placedBounds[m_currentState] != placementBounds )
+			{
 				placeGlyphs( m_currentState );
+			}
 
 			for( size_t i = 0; i < States::NumStates; ++i )
 			{
-				if( i != m_currentState )
+				if( i != m_currentState && m_placedBounds[i] != placementBounds )
 					m_glyphsPlaced[i] = false;
 			}
 		}
@@ -1734,7 +2107,7 @@ namespace Colibri
 		if( dirtyReason & TransformDirtyScale )
 		{
 			if( m_rasterPrivateArea )
-				m_rasterPrivateArea->setSize( m_size );
+				m_rasterPrivateArea->setSize( _size() );
 		}
 
 		Renderable::setTransformDirty( dirtyReason );
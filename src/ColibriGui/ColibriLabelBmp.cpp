@@ -1,6 +1,7 @@
 
 #include "ColibriGui/ColibriLabelBmp.h"
 
+#include "ColibriGui/ColibriSkinManager.h"
 #include "ColibriGui/Text/ColibriBmpFont.h"
 #include "ColibriGui/Text/ColibriShaperManager.h"
 
@@ -40,10 +41,10 @@ namespace Colibri
 
 		TODO_allowMultipleDatablocksForEachState;
 
-		const Ogre::String *datablockName = datablock->getNameStr();
-		COLIBRI_ASSERT_LOW( datablockName );
+		StateInformation const *stateInfo =
+			m_manager->getSkinManager()->getDefaultStateInformation( datablock->getName() );
 		for( size_t i = 0; i < States::NumStates; ++i )
-			m_stateInformation[i].materialName = *datablockName;
+			m_stateInformation[i] = stateInfo;
 	}
 	//-------------------------------------------------------------------------
 	void LabelBmp::setShadowOutline( bool enable, Ogre::ColourValue shadowColour,
@@ -67,10 +68,10 @@ namespace Colibri
 			COLIBRI_ASSERT_LOW( datablock );
 			setDatablock( datablock );
 
-			const Ogre::String *datablockName = datablock->getNameStr();
-			COLIBRI_ASSERT_LOW( datablockName );
+			StateInformation const *stateInfo =
+				m_manager->getSkinManager()->getDefaultStateInformation( datablock->getName() );
 			for( size_t i = 0; i < States::NumStates; ++i )
-				m_stateInformation[i].materialName = *datablockName;
+				m_stateInformation[i] = stateInfo;
 
 			if( !m_rawMode )
 				flagDirty();
@@ -103,13 +104,14 @@ namespace Colibri
 
 		updateDerivedTransform( parentPos, parentRot );
 
-		m_culled = true;
+		_culled() = true;
 
 		m_numVertices = 0;
-		if( !m_parent->intersectsChild( this, parentCurrentScrollPos ) || m_hidden )
+		if( !m_parent->intersectsChild( this, parentCurrentScrollPos ) || m_hidden ||
+			m_manager->_isOccluded( _derivedTopLeft(), _derivedBottomRight() ) )
 			return;
 
-		m_culled = false;
+		_culled() = false;
 
 		if( !m_visualsEnabled )
 			return;
@@ -136,29 +138,29 @@ namespace Colibri
 
 		Ogre::Vector2 invCanvasSize2x = m_manager->getInvCanvasSize2x();
 		Ogre::Vector2 parentDerivedTL =
-			m_parent->m_derivedTopLeft + m_parent->m_clipBorderTL * invCanvasSize2x;
+			m_parent->_derivedTopLeft() + m_parent->m_clipBorderTL * invCanvasSize2x;
 		Ogre::Vector2 parentDerivedBR =
-			m_parent->m_derivedBottomRight - m_parent->m_clipBorderBR * invCanvasSize2x;
-		parentDerivedTL.makeCeil( m_parent->m_accumMinClipTL );
-		parentDerivedBR.makeFloor( m_parent->m_accumMaxClipBR );
-		m_accumMinClipTL = parentDerivedTL;
-		m_accumMaxClipBR = parentDerivedBR;
+			m_parent->_derivedBottomRight() - m_parent->m_clipBorderBR * invCanvasSize2x;
+		parentDerivedTL.makeCeil( m_parent->_accumMinClipTL() );
+		parentDerivedBR.makeFloor( m_parent->_accumMaxClipBR() );
+		_accumMinClipTL() = parentDerivedTL;
+		_accumMaxClipBR() = parentDerivedBR;
 		if( m_clipTextToWidget )
 		{
-			parentDerivedTL.makeCeil( this->m_derivedTopLeft );
-			parentDerivedBR.makeFloor( this->m_derivedBottomRight );
+			parentDerivedTL.makeCeil( this->_derivedTopLeft() );
+			parentDerivedBR.makeFloor( this->_derivedBottomRight() );
 		}
 
 		const Ogre::Vector2 invSize = 1.0f / ( parentDerivedBR - parentDerivedTL );
 
 		// Snap position to pixels
-		Ogre::Vector2 derivedTopLeft = m_derivedTopLeft;
+		Ogre::Vector2 derivedTopLeft = _derivedTopLeft();
 		derivedTopLeft = ( derivedTopLeft + 1.0f ) * halfWindowRes;
 		derivedTopLeft.x = roundf( derivedTopLeft.x );
 		derivedTopLeft.y = roundf( derivedTopLeft.y );
 		derivedTopLeft = derivedTopLeft * invWindowRes - 1.0f;
 
-		const Matrix2x3 derivedRot = m_derivedOrientation;
+		const Matrix2x3 derivedRot = _derivedOrientation();
 		const float canvasAr = m_manager->getCanvasAspectRatio();
 		const float invCanvasAr = m_manager->getCanvasInvAspectRatio();
 
@@ -252,8 +254,8 @@ namespace Colibri
 
 		*_vertexBuffer = vertexBuffer;
 
-		const Ogre::Vector2 outerTopLeft = this->m_derivedTopLeft;
-		const Matrix2x3 &finalRot = this->m_derivedOrientation;
+		const Ogre::Vector2 outerTopLeft = this->_derivedTopLeft();
+		const Matrix2x3 finalRot = this->_derivedOrientation();
 		const Ogre::Vector2 outerTopLeftWithClipping = outerTopLeft + m_clipBorderTL * invCanvasSize2x;
 
 		WidgetVec::const_iterator itChild = m_children.begin();
@@ -386,10 +388,10 @@ namespace Colibri
 		const Ogre::Vector2 canvasSize = m_manager->getCanvasSize();
 		const Ogre::Vector2 invWindowRes = 0.5f * m_manager->getInvWindowResolution2x();
 
-		m_size = maxSize * invWindowRes * canvasSize;
-		m_size.x = std::ceil( m_size.x );
-		m_size.y = std::ceil( m_size.y );
-		m_minSize = m_size;
+		_size() = maxSize * invWindowRes * canvasSize;
+		_size().x = std::ceil( _size().x );
+		_size().y = std::ceil( _size().y );
+		m_minSize = _size();
 	}
 	//-------------------------------------------------------------------------
 	void LabelBmp::setState( States::States state, bool smartHighlight )
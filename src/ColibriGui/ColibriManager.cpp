@@ -1,6 +1,7 @@
 
 #include "ColibriGui/ColibriManager.h"
 
+#include "ColibriGui/ColibriGraphChart.h"
 #include "ColibriGui/ColibriLabel.h"
 #include "ColibriGui/ColibriLabelBmp.h"
 #include "ColibriGui/ColibriSkinManager.h"
@@ -17,6 +18,8 @@
 #include "Math/Array/OgreObjectMemoryManager.h"
 #include "OgreHlmsManager.h"
 #include "OgreHlms.h"
+#include "OgreLwString.h"
+#include "OgreRenderQueue.h"
 #include "OgreRoot.h"
 #include "CommandBuffer/OgreCommandBuffer.h"
 #include "CommandBuffer/OgreCbDrawCall.h"
@@ -86,7 +89,14 @@ namespace Colibri
 		m_skinManager( 0 ),
 		m_shaperManager( 0 ),
 		m_vertexBufferBase( 0 ),
-		m_textVertexBufferBase( 0 )
+		m_textVertexBufferBase( 0 ),
+		m_prewarmWindow( 0 ),
+		m_prewarmPending( false ),
+		m_batchBreakStatsEnabled( false ),
+		m_overdrawStatsDownscale( 0u ),
+		m_firstActiveOccluder( 0u ),
+		m_lastFillValid( false ),
+		m_lastFrameIdxFilled( 0u )
 #if COLIBRIGUI_DEBUG >= COLIBRIGUI_DEBUG_MEDIUM
 		,
 		m_fillBuffersStarted( false ),
@@ -95,6 +105,7 @@ namespace Colibri
 	{
 		memset( m_defaultTextDatablock, 0, sizeof(m_defaultTextDatablock) );
 		memset( m_defaultSkins, 0, sizeof(m_defaultSkins) );
+		memset( m_passVaos, 0, sizeof( m_passVaos ) );
 
 		setLogListener( logListener );
 		setColibriListener( colibriListener );
@@ -110,11 +121,18 @@ namespace Colibri
 	//-------------------------------------------------------------------------
 	ColibriManager::~ColibriManager()
 	{
+		if( m_prewarmWindow )
+		{
+			destroyWindow( m_prewarmWindow );
+			m_prewarmWindow = 0;
+		}
+
 		if( isPrimary() )
 		{
 			delete m_shaperManager;
 			m_shaperManager = 0;
 
+			m_skinManager->_destroySkinAtlases();
 			setOgre( 0, 0, 0 );
 			delete m_skinManager;
 			m_skinManager = 0;
@@ -139,8 +157,8 @@ namespace Colibri
 		m_sceneManager = primaryManager->m_sceneManager;
 
 		m_objectMemoryManager = primaryManager->m_objectMemoryManager;
-		m_vao = Ogre::ColibriOgreRenderable::createVao( 6u * 9u, m_vaoManager, m_multipass );
-		m_textVao = Ogre::ColibriOgreRenderable::createTextVao( 6u * 16u, m_vaoManager, m_multipass );
+		m_vao = Ogre::ColibriOgreRenderable::createVao( 6u * 9u, m_vaoManager );
+		m_textVao = Ogre::ColibriOgreRenderable::createTextVao( 6u * 16u, m_vaoManager );
 		m_commandBuffer = primaryManager->m_commandBuffer;
 
 		for( size_t i = 0u; i < SkinWidgetTypes::NumSkinWidgetTypes; ++i )
@@ -192,6 +210,8 @@ namespace Colibri
 			m_vaoManager->destroyIndirectBuffer( indirectBuffer );
 		}
 		m_indirectBuffer.clear();
+		destroyMultipassVaos();
+		m_lastFillValid = false;
 		if( m_vao )
 		{
 			Ogre::ColibriOgreRenderable::destroyVao( m_vao, m_vaoManager );
@@ -212,8 +232,8 @@ namespace Colibri
 		if( vaoManager )
 		{
 			m_objectMemoryManager = new Ogre::ObjectMemoryManager();
-			m_vao = Ogre::ColibriOgreRenderable::createVao( 6u * 9u, vaoManager, m_multipass );
-			m_textVao = Ogre::ColibriOgreRenderable::createTextVao( 6u * 16u, vaoManager, m_multipass );
+			m_vao = Ogre::ColibriOgreRenderable::createVao( 6u * 9u, vaoManager );
+			m_textVao = Ogre::ColibriOgreRenderable::createTextVao( 6u * 16u, vaoManager );
 			m_commandBuffer = new Ogre::CommandBuffer();
 			m_commandBuffer->setCurrentRenderSystem( m_sceneManager->getDestinationRenderSystem() );
 
@@ -388,6 +408,7 @@ namespace Colibri
 		m_halfWindowResolution = windowResolution / 2.0f;
 		m_invWindowResolution2x = 2.0f / windowResolution;
 		m_canvasAspectRatio = canvasSize.x / canvasSize.y;
+		m_lastFillValid = false;
 		m_canvasInvAspectRatio = canvasSize.y / canvasSize.x;
 
 		for( Window *window : m_windows )
@@ -396,6 +417,14 @@ namespace Colibri
 		m_colibriListener->notifyCanvasOrResolutionUpdated();
 	}
 	//-------------------------------------------------------------------------
+	void ColibriManager::_notifySkinsChanged()
+	{
+		m_lastFillValid = false;
+
+		for( Window *window : m_windows )
+			window->_notifySkinsChanged();
+	}
+	//-------------------------------------------------------------------------
 	void ColibriManager::updateWidgetsFocusedByCursor()
 	{
 		updateAllDerivedTransforms();
@@ -772,8 +801,7 @@ namespace Colibri
 		if( !m_widgetTransformsDirty )
 			return;
 
-		for( Window *window : m_windows )
-			window->_updateDerivedTransformOnly( -Ogre::Vector2::UNIT_SCALE, Matrix2x3::IDENTITY );
+		m_transformStore.updateAllDerivedTransforms( getInvCanvasSize2x(), getCanvasInvAspectRatio() );
 
 		m_widgetTransformsDirty = false;
 	}
@@ -1184,8 +1212,7 @@ namespace Colibri
 				const Ogre::uint32 newVertexCount =
 					std::max( requiredVertexCount, currVertexCount + ( currVertexCount >> 1u ) );
 				Ogre::ColibriOgreRenderable::destroyVao( m_vao, m_vaoManager );
-				m_vao =
-					Ogre::ColibriOgreRenderable::createVao( newVertexCount, m_vaoManager, m_multipass );
+				m_vao = Ogre::ColibriOgreRenderable::createVao( newVertexCount, m_vaoManager );
 
 				anyVaoChanged = true;
 			}
@@ -1202,8 +1229,8 @@ namespace Colibri
 				const Ogre::uint32 newVertexCount =
 					std::max( requiredVertexCount, currVertexCount + ( currVertexCount >> 1u ) );
 				Ogre::ColibriOgreRenderable::destroyVao( m_textVao, m_vaoManager );
-				m_textVao = Ogre::ColibriOgreRenderable::createTextVao( newVertexCount, m_vaoManager,
-																		m_multipass );
+				m_textVao =
+					Ogre::ColibriOgreRenderable::createTextVao( newVertexCount, m_vaoManager );
 				anyVaoChanged = true;
 			}
 		}
@@ -1215,24 +1242,52 @@ namespace Colibri
 		}
 	}
 	//-----------------------------------------------------------------------------------
-	UiVertex *ColibriManager::getMultipassVertexBuffer( size_t numElements, size_t textNumElements )
+	void ColibriManager::getMultipassVaos( size_t passIdx,
+										   Ogre::VertexArrayObject *outVaos[colibri_nonnull 2] )
 	{
-		const size_t totalBytesNeeded =
-			numElements * sizeof( UiVertex ) + textNumElements * sizeof( GlyphVertex );
-		if( totalBytesNeeded > m_multipassTmpBuffer.size() )
-			m_multipassTmpBuffer.resize( totalBytesNeeded );
-		return reinterpret_cast<UiVertex *>( m_multipassTmpBuffer.data() );
+		// The first pass of the frame uses the same Vaos as the widgets
+		if( passIdx == 0u )
+			return;
+
+		const size_t slot = passIdx - 1u;
+		for( size_t i = 0u; i < 2u; ++i )
+		{
+			std::vector<Ogre::VertexArrayObject *> &vaos = m_multipassVaos[i];
+			const Ogre::uint32 numElements =
+				static_cast<Ogre::uint32>( outVaos[i]->getBaseVertexBuffer()->getNumElements() );
+
+			if( slot >= vaos.size() )
+				vaos.resize( slot + 1u, 0 );
+
+			if( vaos[slot] && vaos[slot]->getBaseVertexBuffer()->getNumElements() < numElements )
+			{
+				// Too small. checkVertexBufferCapacity grew the main one since it was created
+				Ogre::ColibriOgreRenderable::destroyVao( vaos[slot], m_vaoManager );
+				vaos[slot] = 0;
+			}
+
+			if( !vaos[slot] )
+			{
+				vaos[slot] =
+					i == 0u ? Ogre::ColibriOgreRenderable::createVao( numElements, m_vaoManager )
+							: Ogre::ColibriOgreRenderable::createTextVao( numElements, m_vaoManager );
+			}
+
+			outVaos[i] = vaos[slot];
+		}
 	}
 	//-----------------------------------------------------------------------------------
-	GlyphVertex *ColibriManager::getMultipassTextVertexBuffer( size_t numElements,
-															   size_t textNumElements )
+	void ColibriManager::destroyMultipassVaos()
 	{
-		const size_t totalBytesNeeded =
-			numElements * sizeof( UiVertex ) + textNumElements * sizeof( GlyphVertex );
-		if( totalBytesNeeded > m_multipassTmpBuffer.size() )
-			m_multipassTmpBuffer.resize( totalBytesNeeded );
-		return reinterpret_cast<GlyphVertex *>( m_multipassTmpBuffer.data() +
-												numElements * sizeof( UiVertex ) );
+		for( size_t i = 0u; i < 2u; ++i )
+		{
+			for( Ogre::VertexArrayObject *vao : m_multipassVaos[i] )
+			{
+				if( vao )
+					Ogre::ColibriOgreRenderable::destroyVao( vao, m_vaoManager );
+			}
+			m_multipassVaos[i].clear();
+		}
 	}
 	//-------------------------------------------------------------------------
 	template <typename T>
@@ -1282,13 +1337,13 @@ namespace Colibri
 					if( widget2->_isKeyboardNavigableForAutoset() )
 					{
 						const Ogre::Vector2 cornerToCorner[4] = {
-							widget2->m_position - widget->m_position,
+							widget2->_position() - widget->_position(),
 
-							Ogre::Vector2( widget2->getRight(), widget2->m_position.y ) -
-								Ogre::Vector2( widget->getRight(), widget->m_position.y ),
+							Ogre::Vector2( widget2->getRight(), widget2->_position().y ) -
+								Ogre::Vector2( widget->getRight(), widget->_position().y ),
 
-							Ogre::Vector2( widget2->m_position.x, widget2->getBottom() ) -
-								Ogre::Vector2( widget->m_position.x, widget->getBottom() ),
+							Ogre::Vector2( widget2->_position().x, widget2->getBottom() ) -
+								Ogre::Vector2( widget->_position().x, widget->getBottom() ),
 
 							Ogre::Vector2( widget2->getRight(), widget2->getBottom() ) -
 								Ogre::Vector2( widget->getRight(), widget->getBottom() ),
@@ -1582,12 +1637,20 @@ namespace Colibri
 	//-------------------------------------------------------------------------
 	void ColibriManager::update( float timeSinceLast )
 	{
+		m_lastFillValid = false;
+
 		if( m_lastFrameIdxUpdated != m_vaoManager->getFrameCount() )
 		{
 			m_currIndirectBuffer = 0u;
 			m_lastFrameIdxUpdated = m_vaoManager->getFrameCount();
 		}
 
+		if( m_prewarmWindow && !m_prewarmPending )
+		{
+			destroyWindow( m_prewarmWindow );
+			m_prewarmWindow = 0;
+		}
+
 		updateAllDerivedTransforms();
 
 		//_setTextSpecialKey must be called before autosetNavigation
@@ -1679,62 +1742,70 @@ namespace Colibri
 		m_fillBuffersStarted = true;
 #endif
 
-		Ogre::VertexBufferPacked *vertexBuffer = m_vao->getBaseVertexBuffer();
-		Ogre::VertexBufferPacked *vertexBufferText = m_textVao->getBaseVertexBuffer();
+		m_passVaos[0] = m_vao;
+		m_passVaos[1] = m_textVao;
+		// m_currIndirectBuffer is also the number of passes already rendered this frame
+		if( m_multipass )
+			getMultipassVaos( m_currIndirectBuffer, m_passVaos );
 
-		UiVertex *vertex = 0;
-		if( !m_multipass )
-		{
-			vertex =
-				reinterpret_cast<UiVertex *>( vertexBuffer->map( 0, vertexBuffer->getNumElements() ) );
-		}
-		else
-		{
-			vertex = getMultipassVertexBuffer( vertexBuffer->getNumElements(),
-											   vertexBufferText->getNumElements() );
-		}
+		Ogre::VertexBufferPacked *vertexBuffer = m_passVaos[0]->getBaseVertexBuffer();
+		Ogre::VertexBufferPacked *vertexBufferText = m_passVaos[1]->getBaseVertexBuffer();
+
+		UiVertex *vertex =
+			reinterpret_cast<UiVertex *>( vertexBuffer->map( 0, vertexBuffer->getNumElements() ) );
 
 		const UiVertex *startOffset = vertex;
 		m_vertexBufferBase = vertex;
 
-		GlyphVertex *vertexText = 0;
-		if( !m_multipass )
-		{
-			vertexText = reinterpret_cast<GlyphVertex *>(
-				vertexBufferText->map( 0, vertexBufferText->getNumElements() ) );
-		}
-		else
-		{
-			vertexText = getMultipassTextVertexBuffer( vertexBuffer->getNumElements(),
-													   vertexBufferText->getNumElements() );
-		}
+		GlyphVertex *vertexText = reinterpret_cast<GlyphVertex *>(
+			vertexBufferText->map( 0, vertexBufferText->getNumElements() ) );
 
 		const GlyphVertex *startOffsetText = vertexText;
 		m_textVertexBufferBase = vertexText;
 
-		for( Window *window : m_windows )
+		gatherOccluders();
+
+		if( m_overdrawStatsDownscale != 0u )
+		{
+			const Ogre::Vector2 windowResolution = m_halfWindowResolution * 2.0f;
+			m_overdrawStats.clear(
+				std::max( uint32_t( windowResolution.x ) / m_overdrawStatsDownscale, 1u ),
+				std::max( uint32_t( windowResolution.y ) / m_overdrawStatsDownscale, 1u ) );
+		}
+
+		const size_t numWindows = m_windows.size();
+		for( size_t i = 0u; i < numWindows; ++i )
 		{
-			window->_fillBuffersAndCommands( &vertex, &vertexText, -Ogre::Vector2::UNIT_SCALE,
-											 Ogre::Vector2::ZERO, Matrix2x3::IDENTITY );
+			// Only the opaque windows drawn after this one can hide it
+			while( m_firstActiveOccluder < m_occluders.size() &&
+				   m_occluders[m_firstActiveOccluder].windowIdx <= i )
+			{
+				++m_firstActiveOccluder;
+			}
+
+			m_windows[i]->_fillBuffersAndCommands( &vertex, &vertexText, -Ogre::Vector2::UNIT_SCALE,
+												   Ogre::Vector2::ZERO, Matrix2x3::IDENTITY );
+
+			if( m_overdrawStatsDownscale != 0u )
+				m_overdrawStats.addWindow( m_windows[i], startOffset, startOffsetText );
 		}
 
+		if( m_overdrawStatsDownscale != 0u )
+			m_overdrawStats.finish();
+
+		m_occluders.clear();
+		m_firstActiveOccluder = 0u;
+
 		const size_t elementsWritten = size_t( vertex - startOffset );
 		const size_t elementsWrittenText = size_t( vertexText - startOffsetText );
 		COLIBRI_ASSERT( elementsWritten <= vertexBuffer->getNumElements() );
 		COLIBRI_ASSERT( elementsWrittenText <= vertexBufferText->getNumElements() );
 
-		if( !m_multipass )
-		{
-			vertexBuffer->unmap( Ogre::UO_KEEP_PERSISTENT, 0u, elementsWritten );
-			vertexBufferText->unmap( Ogre::UO_KEEP_PERSISTENT, 0u, elementsWrittenText );
-		}
-		else
-		{
-			if( elementsWritten > 0u )
-				vertexBuffer->upload( startOffset, 0u, elementsWritten );
-			if( elementsWrittenText > 0u )
-				vertexBufferText->upload( startOffsetText, 0u, elementsWrittenText );
-		}
+		vertexBuffer->unmap( Ogre::UO_KEEP_PERSISTENT, 0u, elementsWritten );
+		vertexBufferText->unmap( Ogre::UO_KEEP_PERSISTENT, 0u, elementsWrittenText );
+
+		m_lastFillValid = true;
+		m_lastFrameIdxFilled = m_vaoManager->getFrameCount();
 
 		m_vertexBufferBase = 0;
 		m_textVertexBufferBase = 0;
@@ -1750,6 +1821,167 @@ namespace Colibri
 		hlmsColibri->prepareRenderCommands();
 	}
 	//-------------------------------------------------------------------------
+	bool ColibriManager::isLastFillReusable() const
+	{
+		// The dynamic buffers we wrote to are only valid during the frame they were mapped
+		return m_lastFillValid && m_lastFrameIdxFilled == m_vaoManager->getFrameCount();
+	}
+	//-------------------------------------------------------------------------
+	void ColibriManager::gatherOccluders()
+	{
+		m_occluders.clear();
+		m_firstActiveOccluder = 0u;
+
+		const Ogre::Vector4 identityOrientation( 1.0f, 0.0f, 0.0f, 1.0f );
+
+		// The last window can't hide anything
+		const size_t numWindows = m_windows.size();
+		for( size_t i = 0u; i + 1u < numWindows; ++i )
+		{
+			Window *window = m_windows[i];
+			if( window->isOpaque() && !window->isHidden() &&
+				window->_orientation() == identityOrientation )
+			{
+				// The derived transform is otherwise only refreshed once the window gets
+				// filled. If it moved since last frame we'd occlude using the old rect.
+				// Same arguments the window will get in prepareRenderCommands.
+				window->updateDerivedTransform( -Ogre::Vector2::UNIT_SCALE, Matrix2x3::IDENTITY );
+
+				Occluder occluder;
+				occluder.topLeft = window->_derivedTopLeft();
+				occluder.bottomRight = window->_derivedBottomRight();
+				occluder.windowIdx = i;
+				m_occluders.push_back( occluder );
+			}
+		}
+	}
+	//-------------------------------------------------------------------------
+	void ColibriManager::prewarmMaterials( uint32_t maxGraphChartColumns )
+	{
+		if( m_prewarmWindow )
+		{
+			// Already waiting for render()
+			return;
+		}
+
+		// These widgets are never visible. We only need them to have the same
+		// Hlms hashes real widgets would have
+		m_prewarmWindow = createWindow( 0 );
+		m_prewarmWindow->setHidden( true );
+
+		createWidget<Label>( m_prewarmWindow );
+		createWidget<CustomShape>( m_prewarmWindow );
+
+		for( uint32_t i = 1u; i <= maxGraphChartColumns; ++i )
+		{
+			GraphChart *graphChart = createWidget<GraphChart>( m_prewarmWindow );
+			graphChart->setMaxValues( i, 1u );
+			graphChart->build( graphChart->getParams() );
+		}
+
+		m_prewarmPending = true;
+	}
+	//-------------------------------------------------------------------------
+	void ColibriManager::prewarmPendingMaterials( ApiEncapsulatedObjects &apiObjects )
+	{
+		m_prewarmPending = false;
+
+		Ogre::HlmsManager *hlmsManager = m_root->getHlmsManager();
+		Ogre::HlmsColibri *hlms = apiObjects.hlms;
+
+		const Ogre::uint32 numCreatedBefore = hlms->getNumShaderCacheEntriesCreated();
+		size_t numMaterials = 0u;
+
+		const Ogre::HlmsCache *lastCache = &c_dummyCache;
+
+		// Gather the materials each widget type can use. The window itself is used for skins.
+		std::vector<std::pair<Renderable *, Ogre::IdString> > entries;
+		{
+			const SkinInfoMap &skins = m_skinManager->getSkins();
+			SkinInfoMap::const_iterator itor = skins.begin();
+			SkinInfoMap::const_iterator endt = skins.end();
+
+			while( itor != endt )
+			{
+				entries.push_back( std::pair<Renderable *, Ogre::IdString>(
+					m_prewarmWindow, itor->second.stateInfo.materialName ) );
+				++itor;
+			}
+		}
+
+		WidgetVec::const_iterator itor = m_prewarmWindow->getChildren().begin();
+		WidgetVec::const_iterator endt = m_prewarmWindow->getChildren().end();
+
+		while( itor != endt )
+		{
+			COLIBRI_ASSERT_HIGH( dynamic_cast<Renderable *>( *itor ) );
+			Renderable *renderable = static_cast<Renderable *>( *itor );
+			for( size_t i = 0u; i < States::NumStates; ++i )
+			{
+				entries.push_back( std::pair<Renderable *, Ogre::IdString>(
+					renderable,
+					renderable->getStateInformation( static_cast<States::States>( i ) ).materialName ) );
+			}
+			if( renderable->getWidgetRenderType() == WidgetRenderType::CustomShape )
+			{
+				// Used by GraphChart's legend
+				entries.push_back( std::pair<Renderable *, Ogre::IdString>(
+					renderable, "ColibriDefaultBlankDatablock" ) );
+			}
+			++itor;
+		}
+
+		std::sort( entries.begin(), entries.end() );
+		entries.erase( std::unique( entries.begin(), entries.end() ), entries.end() );
+
+		std::vector<std::pair<Renderable *, Ogre::IdString> >::const_iterator itEntry = entries.begin();
+		std::vector<std::pair<Renderable *, Ogre::IdString> >::const_iterator enEntry = entries.end();
+
+		while( itEntry != enEntry )
+		{
+			Renderable *renderable = itEntry->first;
+			Ogre::HlmsDatablock *datablock = hlmsManager->getDatablockNoDefault( itEntry->second );
+			if( datablock && datablock->getCreator() == hlms )
+			{
+				renderable->setDatablock( datablock );
+
+				Ogre::QueuedRenderable queuedRenderable( 0u, renderable, renderable );
+				lastCache = hlms->getMaterial( lastCache, *apiObjects.passCache, queuedRenderable, false
+#if OGRE_VERSION >= OGRE_MAKE_VERSION( 4, 0, 0 )
+											   ,
+											   nullptr
+#endif
+				);
+				++numMaterials;
+			}
+			++itEntry;
+		}
+
+		char tmpBuffer[256];
+		Ogre::LwString logMsg( Ogre::LwString::FromEmptyPointer( tmpBuffer, sizeof( tmpBuffer ) ) );
+		logMsg.a( "[ColibriManager::prewarmMaterials]: Prewarmed ", (uint32_t)numMaterials,
+				  " materials. Shader permutations created: ",
+				  hlms->getNumShaderCacheEntriesCreated() - numCreatedBefore );
+		m_logListener->log( logMsg.c_str(), LogSeverity::Info );
+	}
+	//-------------------------------------------------------------------------
+	void ColibriManager::setBatchBreakStatsEnabled( bool bEnabled )
+	{
+		m_batchBreakStatsEnabled = bEnabled;
+		m_batchBreakStats.clear();
+	}
+	//-------------------------------------------------------------------------
+	void ColibriManager::logBatchBreakStats() const { m_batchBreakStats.log( m_logListener ); }
+	//-------------------------------------------------------------------------
+	void ColibriManager::setOverdrawStatsEnabled( bool bEnabled, uint32_t downscale )
+	{
+		COLIBRI_ASSERT_LOW( downscale > 0u );
+		m_overdrawStatsDownscale = bEnabled ? downscale : 0u;
+		m_overdrawStats.clear( 0u, 0u );
+	}
+	//-------------------------------------------------------------------------
+	void ColibriManager::logOverdrawStats() const { m_overdrawStats.log( m_logListener ); }
+	//-------------------------------------------------------------------------
 	void ColibriManager::render()
 	{
 #if COLIBRIGUI_DEBUG >= COLIBRIGUI_DEBUG_MEDIUM
@@ -1787,6 +2019,7 @@ namespace Colibri
 		}
 		apiObjects.startIndirectDraw = apiObjects.indirectDraw;
 		apiObjects.lastDatablock = 0;
+		memset( apiObjects.lastTextShadow, 0, sizeof( apiObjects.lastTextShadow ) );
 		apiObjects.baseInstanceAndIndirectBuffers = 0;
 		if( m_vaoManager->supportsIndirectBuffers() )
 			apiObjects.baseInstanceAndIndirectBuffers = 2;
@@ -1795,9 +2028,22 @@ namespace Colibri
 		apiObjects.drawCmd = 0;
 		apiObjects.drawCountPtr = 0;
 		apiObjects.primCount = 0;
-		apiObjects.basePrimCount[0] = (uint32_t)m_vao->getBaseVertexBuffer()->_getFinalBufferStart();
-		apiObjects.basePrimCount[1] = (uint32_t)m_textVao->getBaseVertexBuffer()->_getFinalBufferStart();
+		apiObjects.vaos[0] = m_passVaos[0];
+		apiObjects.vaos[1] = m_passVaos[1];
+		apiObjects.basePrimCount[0] =
+			(uint32_t)m_passVaos[0]->getBaseVertexBuffer()->_getFinalBufferStart();
+		apiObjects.basePrimCount[1] =
+			(uint32_t)m_passVaos[1]->getBaseVertexBuffer()->_getFinalBufferStart();
 		apiObjects.nextFirstVertex = 0;
+		apiObjects.batchBreakStats = 0;
+		if( m_batchBreakStatsEnabled )
+		{
+			m_batchBreakStats.clear();
+			apiObjects.batchBreakStats = &m_batchBreakStats;
+		}
+
+		if( m_prewarmPending )
+			prewarmPendingMaterials( apiObjects );
 
 		m_breadthFirst[0].clear();
 		m_breadthFirst[1].clear();
@@ -1815,6 +2061,9 @@ namespace Colibri
 			// issued a CbDrawStrip, so take it back. Otherwise we'd have to
 			// save what our last cmd was.
 			apiObjects.indirectDraw -= sizeof( Ogre::CbDrawStrip );
+
+			if( colibri_unlikely( apiObjects.batchBreakStats != 0 ) )
+				apiObjects.batchBreakStats->removeLastRecord();
 		}
 
 		if( m_vaoManager->supportsIndirectBuffers() )
@@ -0,0 +1,311 @@
+#include "ColibriGui/ColibriOverdrawStats.h"
+
+#include "ColibriGui/ColibriManager.h"
+#include "ColibriGui/ColibriRenderable.h"
+#include "ColibriGui/ColibriWindow.h"
+
+#include "OgreImage2.h"
+#include "OgreLwString.h"
+
+#include <algorithm>
+#include <limits>
+#include <math.h>
+#include <string.h>
+
+namespace Colibri
+{
+	static const uint8_t c_heatmapColours[][4] = {
+		{ 0u, 0u, 0u, 255u },      // Not shaded
+		{ 0u, 0u, 192u, 255u },    // 1
+		{ 0u, 192u, 0u, 255u },    // 2
+		{ 255u, 255u, 0u, 255u },  // 3
+		{ 255u, 128u, 0u, 255u },  // 4
+		{ 255u, 0u, 0u, 255u },    // 5
+		{ 255u, 0u, 255u, 255u },  // 6 or more
+	};
+	static const size_t c_numHeatmapColours = sizeof( c_heatmapColours ) / sizeof( c_heatmapColours[0] );
+
+	/// Narrows the range [tMin; tMax] to the part where the clip distance, linearly
+	/// interpolated from distA (at t = 0) to distB (at t = 1), is not negative
+	static void clipRange( float distA, float distB, float &tMin, float &tMax )
+	{
+		if( distA >= 0.0f && distB >= 0.0f )
+			return;
+
+		if( distA < 0.0f && distB < 0.0f )
+		{
+			tMax = -1.0f;
+			return;
+		}
+
+		const float t = distA / ( distA - distB );
+		if( distA < 0.0f )
+			tMin = std::max( tMin, t );
+		else
+			tMax = std::min( tMax, t );
+	}
+	//-------------------------------------------------------------------------
+	/// Converts a range in NDC to a range of pixel centers [outBegin; outEnd)
+	static void ndcToPixelRange( float ndcMin, float ndcMax, uint32_t resolution, uint32_t &outBegin,
+								 uint32_t &outEnd )
+	{
+		const float fResolution = static_cast<float>( resolution );
+		const float pixelMin = ( ndcMin * 0.5f + 0.5f ) * fResolution;
+		const float pixelMax = ( ndcMax * 0.5f + 0.5f ) * fResolution;
+
+		outBegin = static_cast<uint32_t>(
+			std::min( std::max( ceilf( pixelMin - 0.5f ), 0.0f ), fResolution ) );
+		outEnd = static_cast<uint32_t>(
+			std::min( std::max( ceilf( pixelMax - 0.5f ), 0.0f ), fResolution ) );
+	}
+	//-------------------------------------------------------------------------
+	OverdrawStats::OverdrawStats() :
+		width( 0u ),
+		height( 0u ),
+		numShadedPixels( 0u ),
+		numCoveredPixels( 0u ),
+		maxOverdraw( 0u )
+	{
+	}
+	//-------------------------------------------------------------------------
+	void OverdrawStats::clear( uint32_t newWidth, uint32_t newHeight )
+	{
+		width = newWidth;
+		height = newHeight;
+		counters.clear();
+		counters.resize( size_t( width ) * size_t( height ), 0u );
+		numShadedPixels = 0u;
+		numCoveredPixels = 0u;
+		maxOverdraw = 0u;
+		windows.clear();
+	}
+	//-------------------------------------------------------------------------
+	template <typename T>
+	void OverdrawStats::addQuads( const T *vertices, size_t numVertices, size_t verticesPerQuad,
+								  WindowOverdraw &windowOverdraw )
+	{
+		const T *endVertex = vertices + ( numVertices - numVertices % verticesPerQuad );
+
+		while( vertices != endVertex )
+		{
+			// Find the vertices at each extreme. For axis-aligned quads, Left & Right clip
+			// distances only change along x; and Top & Bottom only along y.
+			size_t minX = 0u, maxX = 0u, minY = 0u, maxY = 0u;
+			for( size_t i = 1u; i < verticesPerQuad; ++i )
+			{
+				if( vertices[i].x < vertices[minX].x )
+					minX = i;
+				if( vertices[i].x > vertices[maxX].x )
+					maxX = i;
+				if( vertices[i].y < vertices[minY].y )
+					minY = i;
+				if( vertices[i].y > vertices[maxY].y )
+					maxY = i;
+			}
+
+			float tMinX = 0.0f, tMaxX = 1.0f;
+			clipRange( vertices[minX].clipDistance[Borders::Left],
+					   vertices[maxX].clipDistance[Borders::Left], tMinX, tMaxX );
+			clipRange( vertices[minX].clipDistance[Borders::Right],
+					   vertices[maxX].clipDistance[Borders::Right], tMinX, tMaxX );
+
+			float tMinY = 0.0f, tMaxY = 1.0f;
+			clipRange( vertices[minY].clipDistance[Borders::Top],
+					   vertices[maxY].clipDistance[Borders::Top], tMinY, tMaxY );
+			clipRange( vertices[minY].clipDistance[Borders::Bottom],
+					   vertices[maxY].clipDistance[Borders::Bottom], tMinY, tMaxY );
+
+			++windowOverdraw.numQuads;
+
+			if( tMinX < tMaxX && tMinY < tMaxY )
+			{
+				const float sizeX = vertices[maxX].x - vertices[minX].x;
+				const float sizeY = vertices[maxY].y - vertices[minY].y;
+
+				uint32_t beginX, endX;
+				ndcToPixelRange( vertices[minX].x + sizeX * tMinX, vertices[minX].x + sizeX * tMaxX,
+								 width, beginX, endX );
+
+				// Vertices have +y pointing up, while our rows go top to bottom
+				uint32_t beginY, endY;
+				ndcToPixelRange( -( vertices[minY].y + sizeY * tMaxY ),
+								 -( vertices[minY].y + sizeY * tMinY ), height, beginY, endY );
+
+				for( uint32_t y = beginY; y < endY; ++y )
+				{
+					uint16_t *row = &counters[size_t( y ) * width];
+					for( uint32_t x = beginX; x < endX; ++x )
+					{
+						if( row[x] != std::numeric_limits<uint16_t>::max() )
+							++row[x];
+					}
+				}
+
+				if( beginX < endX && beginY < endY )
+				{
+					windowOverdraw.numShadedPixels +=
+						uint64_t( endX - beginX ) * uint64_t( endY - beginY );
+				}
+			}
+
+			vertices += verticesPerQuad;
+		}
+	}
+	//-------------------------------------------------------------------------
+	void OverdrawStats::addWidget( const Widget *widget, size_t windowIdx,
+								   const UiVertex *vertexBufferBase,
+								   const GlyphVertex *textVertexBufferBase )
+	{
+		if( widget->_isCulled() )
+			return;
+
+		if( widget->isRenderable() && widget->isVisualsEnabled() )
+		{
+			const Renderable *renderable = static_cast<const Renderable *>( widget );
+
+			const size_t numVertices = renderable->_getNumVertices();
+			const size_t vertexOffset = renderable->_getVertexBufferOffset();
+
+			switch( widget->getWidgetRenderType() )
+			{
+			case WidgetRenderType::Normal:
+				addQuads( vertexBufferBase + vertexOffset, numVertices, 6u, windows[windowIdx] );
+				break;
+			case WidgetRenderType::Label:
+				addQuads( textVertexBufferBase + vertexOffset, numVertices, 6u, windows[windowIdx] );
+				break;
+			case WidgetRenderType::CustomShape:
+			{
+				// Triangles are usually laid out in pairs forming quads (e.g. GraphChart).
+				// A single triangle would be counted twice if we used each one's bounding rect
+				const size_t numPairedVertices = numVertices - numVertices % 6u;
+				addQuads( vertexBufferBase + vertexOffset, numPairedVertices, 6u,
+						  windows[windowIdx] );
+				addQuads( vertexBufferBase + vertexOffset + numPairedVertices,
+						  numVertices - numPairedVertices, 3u, windows[windowIdx] );
+				break;
+			}
+			}
+		}
+
+		WidgetVec::const_iterator itor = widget->getChildren().begin();
+		WidgetVec::const_iterator endt = widget->getChildren().end();
+
+		while( itor != endt )
+		{
+			const Widget *child = *itor;
+			if( child->isWindow() )
+			{
+				addWindow( static_cast<const Window *>( child ), vertexBufferBase,
+						   textVertexBufferBase );
+			}
+			else
+			{
+				addWidget( child, windowIdx, vertexBufferBase, textVertexBufferBase );
+			}
+			++itor;
+		}
+	}
+	//-------------------------------------------------------------------------
+	void OverdrawStats::addWindow( const Window *window, const UiVertex *vertexBufferBase,
+								   const GlyphVertex *textVertexBufferBase )
+	{
+		if( window->_isCulled() )
+			return;
+
+		WindowOverdraw windowOverdraw;
+		windowOverdraw.window = window;
+		windowOverdraw.debugName = window->_getDebugName();
+		windowOverdraw.numShadedPixels = 0u;
+		windowOverdraw.numQuads = 0u;
+		windows.push_back( windowOverdraw );
+
+		addWidget( window, windows.size() - 1u, vertexBufferBase, textVertexBufferBase );
+	}
+	//-------------------------------------------------------------------------
+	void OverdrawStats::finish()
+	{
+		numShadedPixels = 0u;
+		numCoveredPixels = 0u;
+		maxOverdraw = 0u;
+
+		std::vector<uint16_t>::const_iterator itor = counters.begin();
+		std::vector<uint16_t>::const_iterator endt = counters.end();
+
+		while( itor != endt )
+		{
+			numShadedPixels += *itor;
+			if( *itor != 0u )
+				++numCoveredPixels;
+			maxOverdraw = std::max( maxOverdraw, *itor );
+			++itor;
+		}
+	}
+	//-------------------------------------------------------------------------
+	float OverdrawStats::getAverageOverdraw() const
+	{
+		if( counters.empty() )
+			return 0.0f;
+		return float( double( numShadedPixels ) / double( counters.size() ) );
+	}
+	//-------------------------------------------------------------------------
+	float OverdrawStats::getAverageOverdrawOfCovered() const
+	{
+		if( numCoveredPixels == 0u )
+			return 0.0f;
+		return float( double( numShadedPixels ) / double( numCoveredPixels ) );
+	}
+	//-------------------------------------------------------------------------
+	void OverdrawStats::log( LogListener *logListener ) const
+	{
+		char tmpBuffer[512];
+		Ogre::LwString msg( Ogre::LwString::FromEmptyPointer( tmpBuffer, sizeof( tmpBuffer ) ) );
+
+		const float screenPixels = float( std::max<size_t>( counters.size(), 1u ) );
+
+		msg.a( "[OverdrawStats]: ", width, "x", height, " shaded ",
+			   (uint32_t)numShadedPixels, " pixels. Screen covered: ",
+			   Ogre::LwString::Float( float( numCoveredPixels ) * 100.0f / screenPixels, 1 ),
+			   "%. Average overdraw: ", Ogre::LwString::Float( getAverageOverdraw(), 2 ),
+			   " (covered only: ", Ogre::LwString::Float( getAverageOverdrawOfCovered(), 2 ),
+			   "). Max: ", maxOverdraw );
+		logListener->log( msg.c_str(), LogSeverity::Info );
+
+		std::vector<WindowOverdraw>::const_iterator itor = windows.begin();
+		std::vector<WindowOverdraw>::const_iterator endt = windows.end();
+
+		while( itor != endt )
+		{
+			msg.clear();
+			msg.a( "[OverdrawStats]:   Window #", (uint32_t)( itor - windows.begin() ), " '",
+				   itor->debugName.c_str(), "': ", (uint32_t)itor->numShadedPixels,
+				   " pixels (", Ogre::LwString::Float( float( itor->numShadedPixels ) / screenPixels, 2 ),
+				   " screens) in ", itor->numQuads, " quads" );
+			logListener->log( msg.c_str(), LogSeverity::Info );
+			++itor;
+		}
+	}
+	//-------------------------------------------------------------------------
+	void OverdrawStats::saveHeatmap( const std::string &fullpath ) const
+	{
+		Ogre::Image2 image;
+		image.createEmptyImage( std::max( width, 1u ), std::max( height, 1u ), 1u,
+								Ogre::TextureTypes::Type2D, Ogre::PFG_RGBA8_UNORM );
+
+		Ogre::TextureBox box = image.getData( 0u );
+
+		for( uint32_t y = 0u; y < height; ++y )
+		{
+			uint8_t *dstRow = reinterpret_cast<uint8_t *>( box.at( 0u, y, 0u ) );
+			const uint16_t *srcRow = &counters[size_t( y ) * width];
+
+			for( uint32_t x = 0u; x < width; ++x )
+			{
+				const size_t colourIdx = std::min<size_t>( srcRow[x], c_numHeatmapColours - 1u );
+				memcpy( dstRow + x * 4u, c_heatmapColours[colourIdx], 4u );
+			}
+		}
+
+		image.save( fullpath, 0u, 1u );
+	}
+}  // namespace Colibri
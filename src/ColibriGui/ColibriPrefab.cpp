@@ -0,0 +1,127 @@
+#include "ColibriGui/ColibriPrefab.h"
+
+#include "ColibriGui/ColibriButton.h"
+#include "ColibriGui/ColibriLabel.h"
+#include "ColibriGui/ColibriManager.h"
+
+#include "OgreLwString.h"
+
+#include <typeinfo>
+
+namespace Colibri
+{
+	Prefab::Prefab() : m_manager( 0 ) {}
+	//-------------------------------------------------------------------------
+	bool Prefab::isSupported( const Widget *widget ) const
+	{
+		// We need the exact type, as a derived class may hold
+		// data that Widget::_cloneSettingsTo doesn't know about
+		const std::type_info &type = typeid( *widget );
+		if( type == typeid( Widget ) || type == typeid( Renderable ) || type == typeid( Label ) ||
+			type == typeid( Button ) )
+		{
+			return true;
+		}
+
+		LogListener *log = m_manager->getLogListener();
+		char tmpBuffer[512];
+		Ogre::LwString errorMsg( Ogre::LwString::FromEmptyPointer( tmpBuffer, sizeof( tmpBuffer ) ) );
+
+		errorMsg.clear();
+		errorMsg.a( "[Prefab::capture] Widget '", widget->_getDebugName().c_str(),
+					"' has a type that can't be cloned. It and its children will be skipped." );
+		log->log( errorMsg.c_str(), LogSeverity::Warning );
+
+		return false;
+	}
+	//-------------------------------------------------------------------------
+	Widget *Prefab::createSameType( const Widget *source, Widget *parent ) const
+	{
+		const std::type_info &type = typeid( *source );
+		if( type == typeid( Label ) )
+			return m_manager->createWidget<Label>( parent );
+		else if( type == typeid( Button ) )
+			return m_manager->createWidget<Button>( parent );
+		else if( type == typeid( Renderable ) )
+			return m_manager->createWidget<Renderable>( parent );
+
+		COLIBRI_ASSERT_MEDIUM( type == typeid( Widget ) );
+		return m_manager->createWidget<Widget>( parent );
+	}
+	//-------------------------------------------------------------------------
+	void Prefab::captureChildren( const Widget *widget, size_t widgetIdx )
+	{
+		// Windows are always at the end, thus we can stop at m_numWidgets
+		const size_t numWidgets = widget->m_numWidgets;
+		for( size_t i = 0u; i < numWidgets; ++i )
+		{
+			const Widget *child = widget->m_children[i];
+			if( !widget->_isInternalChild( child ) && isSupported( child ) )
+			{
+				const size_t childIdx = m_nodes.size();
+				Node node;
+				node.source = child;
+				node.parentIdx = widgetIdx;
+				m_nodes.push_back( node );
+				captureChildren( child, childIdx );
+			}
+		}
+	}
+	//-------------------------------------------------------------------------
+	void Prefab::capture( const Widget *root )
+	{
+		COLIBRI_ASSERT( !root->isWindow() && "Windows can't be captured by a Prefab!" );
+
+		m_manager = root->m_manager;
+		m_nodes.clear();
+
+		if( !isSupported( root ) )
+			return;
+
+		Node node;
+		node.source = root;
+		node.parentIdx = 0u;
+		m_nodes.push_back( node );
+		captureChildren( root, 0u );
+	}
+	//-------------------------------------------------------------------------
+	Widget *colibri_nullable Prefab::instantiate( Widget *parent )
+	{
+		WidgetVec roots;
+		instantiate( parent, 1u, roots );
+		return roots.empty() ? 0 : roots.back();
+	}
+	//-------------------------------------------------------------------------
+	void Prefab::instantiate( Widget *parent, size_t numInstances, WidgetVec &outRoots )
+	{
+		if( m_nodes.empty() )
+			return;
+
+		outRoots.reserve( outRoots.size() + numInstances );
+		parent->m_children.reserve( parent->m_children.size() + numInstances );
+
+		// Node i of the current instance is created[i]. Since parents always go
+		// before their children, created[parentIdx] is always available.
+		WidgetVec created;
+		created.resize( m_nodes.size() );
+
+		const size_t numNodes = m_nodes.size();
+
+		for( size_t i = 0u; i < numInstances; ++i )
+		{
+			created[0] = createSameType( m_nodes[0].source, parent );
+			m_nodes[0].source->_cloneSettingsTo( created[0] );
+			// The template is often kept hidden. Instances shouldn't inherit that.
+			created[0]->setHidden( false );
+
+			for( size_t j = 1u; j < numNodes; ++j )
+			{
+				const Node &node = m_nodes[j];
+				created[j] = createSameType( node.source, created[node.parentIdx] );
+				node.source->_cloneSettingsTo( created[j] );
+			}
+
+			outRoots.push_back( created[0] );
+		}
+	}
+}  // namespace Colibri
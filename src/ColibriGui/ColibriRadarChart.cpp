@@ -366,11 +366,11 @@ void RadarChart::updateLabelsPosition()
 	for( size_t i = 0; i < numDataSeries; ++i )
 	{
 		const Ogre::Vector2 ndcPos = rotate( spoke, rot * static_cast<Ogre::Real>( i ) ) * proportion;
-		Ogre::Vector2 canvasPos = ( ndcPos * 0.5f + 0.5f ) * m_size;
+		Ogre::Vector2 canvasPos = ( ndcPos * 0.5f + 0.5f ) * _size();
 
 		canvasPos = canvasPos - m_labels[i]->getSize() * 0.5f;
 		canvasPos.makeCeil( Ogre::Vector2::ZERO );
-		canvasPos.makeFloor( m_size - m_labels[i]->getSize() );
+		canvasPos.makeFloor( _size() - m_labels[i]->getSize() );
 
 		m_labels[i]->setTopLeft( canvasPos );
 	}
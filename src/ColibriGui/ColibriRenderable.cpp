@@ -11,7 +11,11 @@
 #include "OgreRenderQueue.h"
 #include "OgreHlms.h"
 #include "OgreHlmsDatablock.h"
+#include "OgreHlmsManager.h"
+#include "OgreHlmsUnlitDatablock.h"
 
+#include "ColibriGui/ColibriBatchBreakStats.h"
+#include "ColibriGui/ColibriLabel.h"
 #include "ColibriGui/ColibriWindow.h"
 #include "ColibriGui/ColibriManager.h"
 #include "ColibriGui/ColibriSkinManager.h"
@@ -22,6 +26,8 @@
 
 #include "ColibriRenderable.inl"
 
+#include <string.h>
+
 namespace Colibri
 {
 	Renderable::Renderable( ColibriManager *manager ) :
@@ -29,6 +35,7 @@ namespace Colibri
 		ColibriOgreRenderable( Ogre::Id::generateNewId<Ogre::ColibriOgreRenderable>(),
 							   manager->getOgreObjectMemoryManager(), manager->getOgreSceneManager(), 0u,
 							   manager ),
+		m_stateInfoOverride( 0 ),
 		m_overrideSkinColour( false ),
 		m_colour( Ogre::ColourValue::White ),
 		m_numVertices( 6u * 9u ),
@@ -37,9 +44,33 @@ namespace Colibri
 		m_ignoreParentClipBorder( false )
 	{
 		m_zOrder = _wrapZOrderInternalId( 0 );
-		memset( m_stateInformation, 0, sizeof( m_stateInformation ) );
+
+		StateInformation const *defaultStateInfo =
+			manager->getSkinManager()->getDefaultStateInformation( Ogre::IdString() );
 		for( size_t i = 0u; i < States::NumStates; ++i )
-			m_stateInformation[i].defaultColour = Ogre::ColourValue::White;
+			m_stateInformation[i] = defaultStateInfo;
+	}
+	//-------------------------------------------------------------------------
+	Renderable::~Renderable()
+	{
+		delete[] m_stateInfoOverride;
+		m_stateInfoOverride = 0;
+	}
+	//-------------------------------------------------------------------------
+	StateInformation &Renderable::getOverridableStateInformation( States::States state )
+	{
+		COLIBRI_ASSERT_LOW( state < States::NumStates );
+
+		if( !m_stateInfoOverride )
+			m_stateInfoOverride = new StateInformation[States::NumStates];
+
+		if( m_stateInformation[state] != &m_stateInfoOverride[state] )
+		{
+			m_stateInfoOverride[state] = *m_stateInformation[state];
+			m_stateInformation[state] = &m_stateInfoOverride[state];
+		}
+
+		return m_stateInfoOverride[state];
 	}
 	//-------------------------------------------------------------------------
 	void Renderable::_notifyCanvasChanged()
@@ -48,9 +79,71 @@ namespace Colibri
 		Widget::_notifyCanvasChanged();
 	}
 	//-------------------------------------------------------------------------
+	void Renderable::_notifySkinsChanged()
+	{
+		setDatablockFromSkin( m_stateInformation[m_currentState]->materialName );
+
+		if( !m_overrideSkinColour )
+			m_colour = m_stateInformation[m_currentState]->defaultColour;
+
+		setClipBordersMatchSkin();
+		Widget::_notifySkinsChanged();
+	}
+	//-------------------------------------------------------------------------
 	void Renderable::stateChanged( States::States newState )
 	{
-		setDatablock( m_stateInformation[newState].materialName );
+		setDatablockFromSkin( m_stateInformation[newState]->materialName );
+	}
+	//-------------------------------------------------------------------------
+	bool Renderable::areDatablocksInterchangeable( const Ogre::HlmsDatablock *a,
+												   const Ogre::HlmsDatablock *b, bool bIgnoreSlot0 )
+	{
+		if( a->getCreator() != b->getCreator() || a->getCreator()->getType() != Ogre::HLMS_UNLIT ||
+			a->getMacroblock() != b->getMacroblock() || a->getBlendblock() != b->getBlendblock() ||
+			a->getAlphaTest() != b->getAlphaTest() ||
+			a->getAlphaTestThreshold() != b->getAlphaTestThreshold() )
+		{
+			return false;
+		}
+
+		const Ogre::HlmsUnlitDatablock *unlitA = static_cast<const Ogre::HlmsUnlitDatablock *>( a );
+		const Ogre::HlmsUnlitDatablock *unlitB = static_cast<const Ogre::HlmsUnlitDatablock *>( b );
+
+		if( unlitA->hasColour() != unlitB->hasColour() ||
+			( unlitA->hasColour() && unlitA->getColour() != unlitB->getColour() ) )
+		{
+			return false;
+		}
+
+		for( Ogre::uint8 i = 0u; i < Ogre::NUM_UNLIT_TEXTURE_TYPES; ++i )
+		{
+			if( ( unlitA->getTexture( i ) != unlitB->getTexture( i ) && ( i != 0u || !bIgnoreSlot0 ) ) ||
+				unlitA->getSamplerblock( i ) != unlitB->getSamplerblock( i ) ||
+				unlitA->getTextureUvSource( i ) != unlitB->getTextureUvSource( i ) ||
+				unlitA->getBlendMode( i ) != unlitB->getBlendMode( i ) ||
+				unlitA->getEnableAnimationMatrix( i ) != unlitB->getEnableAnimationMatrix( i ) )
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+	//-------------------------------------------------------------------------
+	void Renderable::setDatablockFromSkin( Ogre::IdString materialName )
+	{
+		if( mHlmsDatablock )
+		{
+			if( mHlmsDatablock->getName() == materialName )
+				return;
+
+			const Ogre::HlmsDatablock *datablock =
+				m_manager->getOgreHlmsManager()->getDatablockNoDefault( materialName );
+			if( datablock && areDatablocksInterchangeable( mHlmsDatablock, datablock ) )
+				return;
+		}
+
+		setDatablock( materialName );
 	}
 	//-------------------------------------------------------------------------
 	void Renderable::setVisualsEnabled( bool bEnabled )
@@ -69,7 +162,7 @@ namespace Colibri
 		if( overrideSkinColour )
 			m_colour = colour;
 		else
-			m_colour = m_stateInformation[m_currentState].defaultColour;
+			m_colour = m_stateInformation[m_currentState]->defaultColour;
 	}
 	//-------------------------------------------------------------------------
 	const Ogre::ColourValue &Renderable::getColour() const { return m_colour; }
@@ -87,19 +180,19 @@ namespace Colibri
 			if( forState == States::NumStates )
 			{
 				for( size_t i=0; i<States::NumStates; ++i )
-					m_stateInformation[i] = itor->second.stateInfo;
-				setDatablock( m_stateInformation[0].materialName );
+					m_stateInformation[i] = &itor->second.stateInfo;
+				setDatablockFromSkin( m_stateInformation[0]->materialName );
 			}
 			else
 			{
-				m_stateInformation[forState] = itor->second.stateInfo;
+				m_stateInformation[forState] = &itor->second.stateInfo;
 				if( forState == m_currentState )
-					setDatablock( m_stateInformation[forState].materialName );
+					setDatablockFromSkin( m_stateInformation[forState]->materialName );
 			}
 		}
 
 		if( !m_overrideSkinColour )
-			m_colour = m_stateInformation[m_currentState].defaultColour;
+			m_colour = m_stateInformation[m_currentState]->defaultColour;
 
 		setClipBordersMatchSkin();
 	}
@@ -115,9 +208,9 @@ namespace Colibri
 				const SkinInfo *skin = skinManager->findSkin( *pack, static_cast<States::States>( i ) );
 				if( skin )
 				{
-					m_stateInformation[i] = skin->stateInfo;
+					m_stateInformation[i] = &skin->stateInfo;
 					if( i == m_currentState )
-						setDatablock( m_stateInformation[i].materialName );
+						setDatablockFromSkin( m_stateInformation[i]->materialName );
 				}
 			}
 		}
@@ -132,12 +225,12 @@ namespace Colibri
 			if( m_currentState == States::HighlightedButtonAndCursor ||
 				m_currentState == States::HighlightedCursor )
 			{
-				setDatablock( m_stateInformation[m_currentState].materialName );
+				setDatablockFromSkin( m_stateInformation[m_currentState]->materialName );
 			}
 		}
 
 		if( !m_overrideSkinColour )
-			m_colour = m_stateInformation[m_currentState].defaultColour;
+			m_colour = m_stateInformation[m_currentState]->defaultColour;
 
 		setClipBordersMatchSkin();
 	}
@@ -149,14 +242,17 @@ namespace Colibri
 		{
 			for( size_t i = 0u; i < States::NumStates; ++i )
 			{
+				StateInformation &stateInfo =
+					getOverridableStateInformation( static_cast<States::States>( i ) );
 				for( size_t j = 0u; j < Borders::NumBorders; ++j )
-					m_stateInformation[i].borderSize[j] = borderSize[j];
+					stateInfo.borderSize[j] = borderSize[j];
 			}
 		}
 		else
 		{
+			StateInformation &stateInfo = getOverridableStateInformation( forState );
 			for( size_t j = 0u; j < Borders::NumBorders; ++j )
-				m_stateInformation[forState].borderSize[j] = borderSize[j];
+				stateInfo.borderSize[j] = borderSize[j];
 		}
 
 		if( bClipBordersMatchSkin )
@@ -170,9 +266,9 @@ namespace Colibri
 		{
 			if( skinInfos[i] )
 			{
-				m_stateInformation[i] = skinInfos[i]->stateInfo;
+				m_stateInformation[i] = &skinInfos[i]->stateInfo;
 				if( i == m_currentState )
-					setDatablock( m_stateInformation[i].materialName );
+					setDatablockFromSkin( m_stateInformation[i]->materialName );
 			}
 		}
 
@@ -186,25 +282,78 @@ namespace Colibri
 			if( m_currentState == States::HighlightedButtonAndCursor ||
 				m_currentState == States::HighlightedCursor )
 			{
-				setDatablock( m_stateInformation[m_currentState].materialName );
+				setDatablockFromSkin( m_stateInformation[m_currentState]->materialName );
 			}
 		}
 
 		if( !m_overrideSkinColour )
-			m_colour = m_stateInformation[m_currentState].defaultColour;
+			m_colour = m_stateInformation[m_currentState]->defaultColour;
 
 		setClipBordersMatchSkin();
 	}
 	//-------------------------------------------------------------------------
+	void Renderable::setStateInformation( const StateInformation &stateInfo, States::States forState )
+	{
+		if( forState == States::NumStates )
+		{
+			for( size_t i = 0u; i < States::NumStates; ++i )
+				getOverridableStateInformation( static_cast<States::States>( i ) ) = stateInfo;
+		}
+		else
+		{
+			getOverridableStateInformation( forState ) = stateInfo;
+		}
+
+		if( forState == States::NumStates || forState == m_currentState )
+			setDatablockFromSkin( m_stateInformation[m_currentState]->materialName );
+
+		if( !m_overrideSkinColour )
+			m_colour = m_stateInformation[m_currentState]->defaultColour;
+
+		setClipBordersMatchSkin();
+	}
+	//-------------------------------------------------------------------------
+	void Renderable::_cloneSettingsTo( Widget *_dst ) const
+	{
+		Widget::_cloneSettingsTo( _dst );
+
+		COLIBRI_ASSERT_HIGH( dynamic_cast<Renderable *>( _dst ) );
+		Renderable *dst = static_cast<Renderable *>( _dst );
+
+		for( size_t i = 0; i < States::NumStates; ++i )
+		{
+			if( m_stateInfoOverride && m_stateInformation[i] >= m_stateInfoOverride &&
+				m_stateInformation[i] < m_stateInfoOverride + States::NumStates )
+			{
+				// Overrides are owned by us. dst needs its own copy.
+				dst->getOverridableStateInformation( static_cast<States::States>( i ) ) =
+					*m_stateInformation[i];
+			}
+			else
+			{
+				dst->m_stateInformation[i] = m_stateInformation[i];
+			}
+		}
+
+		dst->m_overrideSkinColour = m_overrideSkinColour;
+		dst->m_colour = m_colour;
+		dst->m_visualsEnabled = m_visualsEnabled;
+		dst->m_ignoreParentClipBorder = m_ignoreParentClipBorder;
+
+		// mHlmsDatablock already matches (or is interchangeable with)
+		// m_stateInformation[m_currentState].materialName, no need to look it up again by name
+		if( dst->getDatablock() != getDatablock() )
+			dst->setDatablock( getDatablock() );
+	}
+	//-------------------------------------------------------------------------
 	void Renderable::setState( States::States state, bool smartHighlight )
 	{
 		Widget::setState( state, smartHighlight );
 
 		if( !m_overrideSkinColour )
-			m_colour = m_stateInformation[m_currentState].defaultColour;
+			m_colour = m_stateInformation[m_currentState]->defaultColour;
 
-		if( mHlmsDatablock->getName() != m_stateInformation[m_currentState].materialName )
-			setDatablock( m_stateInformation[m_currentState].materialName );
+		setDatablockFromSkin( m_stateInformation[m_currentState]->materialName );
 
 		setClipBordersMatchSkin();
 	}
@@ -216,7 +365,7 @@ namespace Colibri
 	//-------------------------------------------------------------------------
 	void Renderable::setClipBordersMatchSkin( States::States state )
 	{
-		const StateInformation &stateInfo = m_stateInformation[state];
+		const StateInformation &stateInfo = *m_stateInformation[state];
 
 		const Ogre::Vector2 &pixelToCanvas = m_manager->getCanvasSize() * m_manager->getPixelSize();
 
@@ -236,7 +385,7 @@ namespace Colibri
 	//-------------------------------------------------------------------------
 	void Renderable::_addCommands( ApiEncapsulatedObjects &apiObject, bool collectingBreadthFirst )
 	{
-		if( m_culled )
+		if( _culled() )
 			return;
 
 		if( m_visualsEnabled )
@@ -248,7 +397,15 @@ namespace Colibri
 			QueuedRenderable queuedRenderable( 0u, this, this );
 
 			uint32 lastHlmsCacheHash = apiObject.lastHlmsCache->hash;
-			VertexArrayObject *vao = mVaoPerLod[0].back();
+			const uint32 prevVaoName = apiObject.lastVaoName;
+			const bool bFirstDraw = apiObject.drawCmd == 0;
+
+			const WidgetRenderType::WidgetRenderType widgetRenderType = getWidgetRenderType();
+			const bool bIsLabel = widgetRenderType == WidgetRenderType::Label;
+			const size_t widgetType = bIsLabel ? 1u : 0u;
+
+			// Not necessarily mVaoPerLod[0].back(). In multipass, each pass has its own
+			VertexArrayObject *vao = apiObject.vaos[widgetType];
 			const HlmsCache *hlmsCache = apiObject.hlms->getMaterial(
 				apiObject.lastHlmsCache, *apiObject.passCache, queuedRenderable, false
 #if OGRE_VERSION >= OGRE_MAKE_VERSION( 4, 0, 0 )
@@ -266,16 +423,17 @@ namespace Colibri
 				apiObject.lastVaoName = 0;
 			}
 
-			const WidgetRenderType::WidgetRenderType widgetRenderType = getWidgetRenderType();
-			const bool bIsLabel = widgetRenderType == WidgetRenderType::Label;
-			const size_t widgetType = bIsLabel ? 1u : 0u;
-
 			const uint32 firstVertex = m_currVertexBufferOffset + apiObject.basePrimCount[widgetType];
 
+			uint32_t textShadow[4] = { 0u, 0u, 0u, 0u };
+			if( bIsLabel )
+				static_cast<const Label *>( this )->_getShadowDrawData( textShadow );
+
 			uint32 baseInstance = apiObject.hlms->fillBuffersForColibri(
 									  hlmsCache, queuedRenderable, false,
 									  firstVertex,
-									  lastHlmsCacheHash, apiObject.commandBuffer );
+									  lastHlmsCacheHash, apiObject.commandBuffer,
+									  bIsLabel ? textShadow : 0 );
 
 			// Note: CustomShapes can't be chained from/to anything because they break the assumption
 			// each widget is 54 vertices; not even two CustomShapes can be instanced together.
@@ -301,6 +459,9 @@ namespace Colibri
 					// issued a CbDrawStrip, so take it back. Otherwise we'd have to
 					// save what our last cmd was.
 					apiObject.indirectDraw -= sizeof( CbDrawStrip );
+
+					if( colibri_unlikely( apiObject.batchBreakStats != 0 ) )
+						apiObject.batchBreakStats->removeLastRecord();
 				}
 
 				{
@@ -320,6 +481,8 @@ namespace Colibri
 				apiObject.drawCmd = drawCall;
 				apiObject.primCount = 0;
 				apiObject.lastDatablock = mHlmsDatablock;
+				if( bIsLabel )
+					memcpy( apiObject.lastTextShadow, textShadow, sizeof( textShadow ) );
 
 				apiObject.drawCountPtr = reinterpret_cast<CbDrawStrip*>( apiObject.indirectDraw );
 				apiObject.drawCountPtr->primCount		= 0;
@@ -327,8 +490,24 @@ namespace Colibri
 				apiObject.drawCountPtr->firstVertexIndex= firstVertex;
 				apiObject.drawCountPtr->baseInstance	= baseInstance;
 				apiObject.indirectDraw += sizeof( CbDrawStrip );
+
+				if( colibri_unlikely( apiObject.batchBreakStats != 0 ) )
+				{
+					BatchBreakReason::BatchBreakReason reason;
+					if( bFirstDraw )
+						reason = BatchBreakReason::FirstDraw;
+					else if( lastHlmsCacheHash != hlmsCache->hash )
+						reason = BatchBreakReason::HlmsCacheChange;
+					else if( prevVaoName != vao->getVaoName() )
+						reason = BatchBreakReason::VaoChange;
+					else
+						reason = BatchBreakReason::TextureChange;
+					apiObject.batchBreakStats->addRecord( reason, true, this );
+				}
 			}
-			else if( bIsLabel && apiObject.lastDatablock != mHlmsDatablock )
+			else if( bIsLabel &&
+					 ( apiObject.lastDatablock != mHlmsDatablock ||
+					   memcmp( apiObject.lastTextShadow, textShadow, sizeof( textShadow ) ) != 0 ) )
 			{
 				if( apiObject.drawCountPtr && apiObject.drawCountPtr->primCount == 0u )
 				{
@@ -338,14 +517,19 @@ namespace Colibri
 					// issued a CbDrawStrip, so take it back. Otherwise we'd have to
 					// save what our last cmd was.
 					apiObject.indirectDraw -= sizeof( CbDrawStrip );
+
+					if( colibri_unlikely( apiObject.batchBreakStats != 0 ) )
+						apiObject.batchBreakStats->removeLastRecord();
 				}
 
 				//Text has arbitrary number of of vertices, thus we can't properly calculate the drawId
-				//and therefore the material ID unless we issue a start a new draw.
+				//and therefore the material ID (nor the shadow) unless we issue a start a new draw.
 				CbDrawCallStrip *drawCall = static_cast<CbDrawCallStrip*>( apiObject.drawCmd );
 				++drawCall->numDraws;
 				apiObject.primCount = 0;
+				const bool bDatablockChanged = apiObject.lastDatablock != mHlmsDatablock;
 				apiObject.lastDatablock = mHlmsDatablock;
+				memcpy( apiObject.lastTextShadow, textShadow, sizeof( textShadow ) );
 
 				apiObject.drawCountPtr = reinterpret_cast<CbDrawStrip*>( apiObject.indirectDraw );
 				apiObject.drawCountPtr->primCount		= 0;
@@ -353,6 +537,14 @@ namespace Colibri
 				apiObject.drawCountPtr->firstVertexIndex= firstVertex;
 				apiObject.drawCountPtr->baseInstance	= baseInstance;
 				apiObject.indirectDraw += sizeof( CbDrawStrip );
+
+				if( colibri_unlikely( apiObject.batchBreakStats != 0 ) )
+				{
+					apiObject.batchBreakStats->addRecord( bDatablockChanged
+															  ? BatchBreakReason::LabelDatablockChange
+															  : BatchBreakReason::LabelShadowChange,
+														  false, this );
+				}
 			}
 			else if( apiObject.nextFirstVertex != firstVertex ||
 					 widgetRenderType == WidgetRenderType::CustomShape )
@@ -365,6 +557,9 @@ namespace Colibri
 					// issued a CbDrawStrip, so take it back. Otherwise we'd have to
 					// save what our last cmd was.
 					apiObject.indirectDraw -= sizeof( CbDrawStrip );
+
+					if( colibri_unlikely( apiObject.batchBreakStats != 0 ) )
+						apiObject.batchBreakStats->removeLastRecord();
 				}
 
 				//If we're here, we're most likely rendering using breadth first.
@@ -374,6 +569,8 @@ namespace Colibri
 				++drawCall->numDraws;
 				apiObject.primCount = 0;
 				apiObject.lastDatablock = mHlmsDatablock;
+				if( bIsLabel )
+					memcpy( apiObject.lastTextShadow, textShadow, sizeof( textShadow ) );
 
 				apiObject.drawCountPtr = reinterpret_cast<CbDrawStrip*>( apiObject.indirectDraw );
 				apiObject.drawCountPtr->primCount		= 0;
@@ -381,6 +578,15 @@ namespace Colibri
 				apiObject.drawCountPtr->firstVertexIndex= firstVertex;
 				apiObject.drawCountPtr->baseInstance	= baseInstance;
 				apiObject.indirectDraw += sizeof( CbDrawStrip );
+
+				if( colibri_unlikely( apiObject.batchBreakStats != 0 ) )
+				{
+					apiObject.batchBreakStats->addRecord(
+						widgetRenderType == WidgetRenderType::CustomShape
+							? BatchBreakReason::CustomShape
+							: BatchBreakReason::VertexDiscontinuity,
+						false, this );
+				}
 			}
 
 			apiObject.primCount += m_numVertices;
@@ -396,7 +602,7 @@ namespace Colibri
 	{
 		if( state == States::NumStates )
 			state = m_currentState;
-		return m_stateInformation[state];
+		return *m_stateInformation[state];
 	}
 	//-------------------------------------------------------------------------
 	void Renderable::_fillBuffersAndCommands( UiVertex * colibri_nonnull * colibri_nonnull
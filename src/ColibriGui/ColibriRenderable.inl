@@ -107,7 +107,7 @@ namespace Colibri
 
 		updateDerivedTransform( parentPos, parentRot );
 
-		m_culled = true;
+		_culled() = true;
 
 		if( forWindows )
 		{
@@ -120,7 +120,11 @@ namespace Colibri
 				return;
 		}
 
-		m_culled = false;
+		// Fully hidden behind an opaque window. See Window::setOpaque
+		if( m_manager->_isOccluded( _derivedTopLeft(), _derivedBottomRight() ) )
+			return;
+
+		_culled() = false;
 
 		Ogre::Vector2 parentDerivedTL;
 		Ogre::Vector2 parentDerivedBR;
@@ -132,13 +136,13 @@ namespace Colibri
 			parentDerivedTL = -1.0f;
 			parentDerivedBR = 1.0f;
 
-			m_accumMinClipTL = -1.0f;
-			m_accumMaxClipBR = 1.0f;
+			_accumMinClipTL() = -1.0f;
+			_accumMaxClipBR() = 1.0f;
 		}
 		else
 		{
-			parentDerivedTL = m_parent->m_derivedTopLeft;
-			parentDerivedBR = m_parent->m_derivedBottomRight;
+			parentDerivedTL = m_parent->_derivedTopLeft();
+			parentDerivedBR = m_parent->_derivedBottomRight();
 
 			if( !m_ignoreParentClipBorder )
 			{
@@ -146,13 +150,13 @@ namespace Colibri
 				parentDerivedBR -= m_parent->m_clipBorderBR * invCanvasSize2x;
 			}
 
-			parentDerivedTL.makeCeil( m_parent->m_accumMinClipTL );
-			parentDerivedBR.makeFloor( m_parent->m_accumMaxClipBR );
-			m_accumMinClipTL = parentDerivedTL;
-			m_accumMaxClipBR = parentDerivedBR;
+			parentDerivedTL.makeCeil( m_parent->_accumMinClipTL() );
+			parentDerivedBR.makeFloor( m_parent->_accumMaxClipBR() );
+			_accumMinClipTL() = parentDerivedTL;
+			_accumMaxClipBR() = parentDerivedBR;
 		}
 
-		const Ogre::Vector2 outerTopLeft = this->m_derivedTopLeft;
+		const Ogre::Vector2 outerTopLeft = this->_derivedTopLeft();
 
 		if( m_visualsEnabled )
 		{
@@ -167,9 +171,9 @@ namespace Colibri
 
 			const Ogre::Vector2 invSize = 1.0f / (parentDerivedBR - parentDerivedTL);
 
-			const Ogre::Vector2 outerBottomRight	= this->m_derivedBottomRight;
+			const Ogre::Vector2 outerBottomRight	= this->_derivedBottomRight();
 
-			const StateInformation stateInfo = m_stateInformation[m_currentState];
+			const StateInformation &stateInfo = *m_stateInformation[m_currentState];
 
 			const Ogre::Vector2 &pixelSize2x = m_manager->getPixelSize2x();
 
@@ -193,21 +197,21 @@ namespace Colibri
 					 outerTopLeft, innerTopLeft,                             //
 					 stateInfo.uvTopLeftBottomRight[0],                      //
 					 rgbaColour, parentDerivedTL, parentDerivedBR, invSize,  //
-					 canvasAr, invCanvasAr, this->m_derivedOrientation );
+					 canvasAr, invCanvasAr, this->_derivedOrientation() );
 			vertexBuffer += 6u;
 			addQuad( vertexBuffer,                                           //
 					 Ogre::Vector2( innerTopLeft.x, outerTopLeft.y ),        //
 					 Ogre::Vector2( innerBottomRight.x, innerTopLeft.y ),    //
 					 stateInfo.uvTopLeftBottomRight[1],                      //
 					 rgbaColour, parentDerivedTL, parentDerivedBR, invSize,  //
-					 canvasAr, invCanvasAr, this->m_derivedOrientation );
+					 canvasAr, invCanvasAr, this->_derivedOrientation() );
 			vertexBuffer += 6u;
 			addQuad( vertexBuffer,                                           //
 					 Ogre::Vector2( innerBottomRight.x, outerTopLeft.y ),    //
 					 Ogre::Vector2( outerBottomRight.x, innerTopLeft.y ),    //
 					 stateInfo.uvTopLeftBottomRight[2],                      //
 					 rgbaColour, parentDerivedTL, parentDerivedBR, invSize,  //
-					 canvasAr, invCanvasAr, this->m_derivedOrientation );
+					 canvasAr, invCanvasAr, this->_derivedOrientation() );
 			vertexBuffer += 6u;
 			// 2nd row
 			addQuad( vertexBuffer,                                           //
@@ -215,21 +219,21 @@ namespace Colibri
 					 Ogre::Vector2( innerTopLeft.x, innerBottomRight.y ),    //
 					 stateInfo.uvTopLeftBottomRight[3],                      //
 					 rgbaColour, parentDerivedTL, parentDerivedBR, invSize,  //
-					 canvasAr, invCanvasAr, this->m_derivedOrientation );
+					 canvasAr, invCanvasAr, this->_derivedOrientation() );
 			vertexBuffer += 6u;
 			addQuad( vertexBuffer,                                             //
 					 Ogre::Vector2( innerTopLeft.x, innerTopLeft.y ),          //
 					 Ogre::Vector2( innerBottomRight.x, innerBottomRight.y ),  //
 					 stateInfo.uvTopLeftBottomRight[4],                        //
 					 rgbaColour, parentDerivedTL, parentDerivedBR, invSize,    //
-					 canvasAr, invCanvasAr, this->m_derivedOrientation );
+					 canvasAr, invCanvasAr, this->_derivedOrientation() );
 			vertexBuffer += 6u;
 			addQuad( vertexBuffer,                                             //
 					 Ogre::Vector2( innerBottomRight.x, innerTopLeft.y ),      //
 					 Ogre::Vector2( outerBottomRight.x, innerBottomRight.y ),  //
 					 stateInfo.uvTopLeftBottomRight[5],                        //
 					 rgbaColour, parentDerivedTL, parentDerivedBR, invSize,    //
-					 canvasAr, invCanvasAr, this->m_derivedOrientation );
+					 canvasAr, invCanvasAr, this->_derivedOrientation() );
 			vertexBuffer += 6u;
 			// 3rd row
 			addQuad( vertexBuffer,                                           //
@@ -237,27 +241,27 @@ namespace Colibri
 					 Ogre::Vector2( innerTopLeft.x, outerBottomRight.y ),    //
 					 stateInfo.uvTopLeftBottomRight[6],                      //
 					 rgbaColour, parentDerivedTL, parentDerivedBR, invSize,  //
-					 canvasAr, invCanvasAr, this->m_derivedOrientation );
+					 canvasAr, invCanvasAr, this->_derivedOrientation() );
 			vertexBuffer += 6u;
 			addQuad( vertexBuffer,                                             //
 					 Ogre::Vector2( innerTopLeft.x, innerBottomRight.y ),      //
 					 Ogre::Vector2( innerBottomRight.x, outerBottomRight.y ),  //
 					 stateInfo.uvTopLeftBottomRight[7],                        //
 					 rgbaColour, parentDerivedTL, parentDerivedBR, invSize,    //
-					 canvasAr, invCanvasAr, this->m_derivedOrientation );
+					 canvasAr, invCanvasAr, this->_derivedOrientation() );
 			vertexBuffer += 6u;
 			addQuad( vertexBuffer,                                             //
 					 Ogre::Vector2( innerBottomRight.x, innerBottomRight.y ),  //
 					 Ogre::Vector2( outerBottomRight.x, outerBottomRight.y ),  //
 					 stateInfo.uvTopLeftBottomRight[8],                        //
 					 rgbaColour, parentDerivedTL, parentDerivedBR, invSize,    //
-					 canvasAr, invCanvasAr, this->m_derivedOrientation );
+					 canvasAr, invCanvasAr, this->_derivedOrientation() );
 			vertexBuffer += 6u;
 
 			*_vertexBuffer = vertexBuffer;
 		}
 
-		const Matrix2x3 &finalRot = this->m_derivedOrientation;
+		const Matrix2x3 finalRot = this->_derivedOrientation();
 		WidgetVec::const_iterator itor = m_children.begin();
 		WidgetVec::const_iterator end  = m_children.end();
 
@@ -3,8 +3,19 @@
 #include "ColibriGui/ColibriManager.h"
 
 #include "ColibriGui/ColibriProgressbar.h"
+#include "ColibriGui/ColibriRenderable.h"
 
+#include "OgreBitwise.h"
+#include "OgreHlmsManager.h"
+#include "OgreHlmsUnlitDatablock.h"
+#include "OgreId.h"
 #include "OgreLwString.h"
+#include "OgrePixelFormatGpuUtils.h"
+#include "OgreRenderSystem.h"
+#include "OgreStagingTexture.h"
+#include "OgreTextureBox.h"
+#include "OgreTextureGpu.h"
+#include "OgreTextureGpuManager.h"
 
 #if defined( __GNUC__ ) && !defined( __clang__ )
 #	pragma GCC diagnostic push
@@ -27,13 +38,37 @@
 #include "sds/sds_fstream.h"
 #include "sds/sds_fstreamApk.h"
 
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <string.h>
+
 namespace Colibri
 {
 	SkinManager::SkinManager( ColibriManager *colibriManager ) :
-		m_colibriManager( colibriManager )
+		m_colibriManager( colibriManager ),
+		m_packSkinsIntoAtlas( false ),
+		m_skinAtlasMaxResolution( 4096u )
 	{
 	}
 	//-------------------------------------------------------------------------
+	StateInformation const *SkinManager::getDefaultStateInformation( Ogre::IdString materialName )
+	{
+		StateInformationMap::const_iterator itor = m_defaultStateInfos.find( materialName );
+		if( itor == m_defaultStateInfos.end() )
+		{
+			StateInformation stateInfo;
+			memset( &stateInfo, 0, sizeof( stateInfo ) );
+			stateInfo.defaultColour = Ogre::ColourValue::White;
+			stateInfo.materialName = materialName;
+			itor = m_defaultStateInfos.insert( std::pair<Ogre::IdString, StateInformation>(
+												   materialName, stateInfo ) )
+					   .first;
+		}
+
+		return &itor->second;
+	}
+	//-------------------------------------------------------------------------
 	inline Ogre::Vector2 SkinManager::getVector2Array( const rapidjson::Value &jsonArray )
 	{
 		Ogre::Vector2 retVal( Ogre::Vector2::ZERO );
@@ -163,12 +198,14 @@ namespace Colibri
 		stateInfo.uvTopLeftBottomRight[idx].w = topLeft.y + widthHeight.y;
 	}
 	//-------------------------------------------------------------------------
-	void SkinManager::loadSkins( const rapidjson::Value &skinsValue, const char *filename )
+	bool SkinManager::loadSkins( const rapidjson::Value &skinsValue, const char *filename )
 	{
 		LogListener *log = m_colibriManager->getLogListener();
 		char tmpBuffer[512];
 		Ogre::LwString errorMsg( Ogre::LwString::FromEmptyPointer( tmpBuffer, sizeof(tmpBuffer) ) );
 
+		bool skinsReloaded = false;
+
 		rapidjson::Value::ConstMemberIterator itor = skinsValue.MemberBegin();
 		rapidjson::Value::ConstMemberIterator end  = skinsValue.MemberEnd();
 
@@ -421,12 +458,25 @@ namespace Colibri
 				}
 				else
 				{
-					m_skins[skinInfo.name] = skinInfo;
+					// Assign in place. Renderables point to the existing entry,
+					// thus its address must remain stable.
+					SkinInfoMap::iterator itSkin = m_skins.find( skinInfo.name );
+					if( itSkin != m_skins.end() )
+					{
+						itSkin->second = skinInfo;
+						skinsReloaded = true;
+					}
+					else
+					{
+						m_skins[skinInfo.name] = skinInfo;
+					}
 				}
 			}
 
 			++itor;
 		}
+
+		return skinsReloaded;
 	}
 	//-------------------------------------------------------------------------
 	void SkinManager::loadSkinPacks( const rapidjson::Value &packsValue,
@@ -774,10 +824,12 @@ namespace Colibri
 
 		rapidjson::Value::ConstMemberIterator itTmp;
 
+		bool skinsReloaded = false;
+
 		itTmp = d.FindMember( "skins" );
 		{
 			if( itTmp != d.MemberEnd() && itTmp->value.IsObject() )
-				loadSkins( itTmp->value, filename );
+				skinsReloaded = loadSkins( itTmp->value, filename );
 
 			rapidjson::Value::ConstMemberIterator itTmp2 = d.FindMember( "skin_packs" );
 			if( itTmp2 != d.MemberEnd() && itTmp2->value.IsObject() )
@@ -787,5 +839,425 @@ namespace Colibri
 		itTmp = d.FindMember( "default_skin_packs" );
 		if( itTmp != d.MemberEnd() && itTmp->value.IsObject() )
 			loadDefaultSkinPacks( itTmp->value, filename );
+
+		bool widgetsNotified = false;
+		if( m_packSkinsIntoAtlas )
+			widgetsNotified = buildSkinAtlas( m_skinAtlasMaxResolution );
+
+		// Live widgets may be using the skins we've just overwritten
+		// (e.g. different material or colour). Refresh them.
+		if( skinsReloaded && !widgetsNotified )
+			m_colibriManager->_notifySkinsChanged();
+	}
+	//-------------------------------------------------------------------------
+	void SkinManager::setPackSkinsIntoAtlas( bool bPack, uint32_t maxResolution )
+	{
+		m_packSkinsIntoAtlas = bPack;
+		m_skinAtlasMaxResolution = maxResolution;
+	}
+	//-------------------------------------------------------------------------
+	namespace
+	{
+		struct AtlasSource
+		{
+			Ogre::TextureGpu *texture;
+			uint32_t x;
+			uint32_t y;
+		};
+
+		struct AtlasSourceTallerFirst
+		{
+			const std::vector<AtlasSource> &sources;
+			AtlasSourceTallerFirst( const std::vector<AtlasSource> &_sources ) : sources( _sources ) {}
+			bool operator()( size_t a, size_t b ) const
+			{
+				const uint32_t heightA = sources[a].texture->getHeight();
+				const uint32_t heightB = sources[b].texture->getHeight();
+				if( heightA != heightB )
+					return heightA > heightB;
+				return sources[a].texture->getWidth() > sources[b].texture->getWidth();
+			}
+		};
+
+		void copyRegion( Ogre::TextureGpu *src, Ogre::TextureGpu *dst, uint32_t srcX, uint32_t srcY,
+						 uint32_t width, uint32_t height, uint32_t dstX, uint32_t dstY )
+		{
+			Ogre::TextureBox srcBox = src->getEmptyBox( 0u );
+			srcBox.x = srcX;
+			srcBox.y = srcY;
+			srcBox.width = width;
+			srcBox.height = height;
+			Ogre::TextureBox dstBox = srcBox;
+			dstBox.x = dstX;
+			dstBox.y = dstY;
+			src->copyTo( dst, dstBox, 0u, srcBox, 0u );
+		}
+
+		/// Copies the texture into the atlas at (dstX, dstY) and replicates its edges outward
+		/// into the padding around it; like a clamping sampler would. Otherwise filtering
+		/// at the borders of the skins would blend with whatever lies next to it.
+		/// Compressed formats can only be copied in blocks, thus their edge blocks are
+		/// replicated instead.
+		void copyIntoAtlas( Ogre::TextureGpu *texture, Ogre::TextureGpu *atlas, uint32_t dstX,
+							uint32_t dstY, uint32_t padding )
+		{
+			const uint32_t width = texture->getWidth();
+			const uint32_t height = texture->getHeight();
+			const uint32_t blockSize =
+				Ogre::PixelFormatGpuUtils::isCompressed( texture->getPixelFormat() ) ? 4u : 1u;
+
+			copyRegion( texture, atlas, 0u, 0u, width, height, dstX, dstY );
+
+			// [0] = left / top, [1] = right / bottom
+			const uint32_t srcEdgeX[2] = { 0u, width - blockSize };
+			const uint32_t srcEdgeY[2] = { 0u, height - blockSize };
+			const uint32_t dstPadX[2] = { dstX - padding, dstX + width };
+			const uint32_t dstPadY[2] = { dstY - padding, dstY + height };
+
+			for( size_t side = 0u; side < 2u; ++side )
+			{
+				for( uint32_t i = 0u; i < padding; i += blockSize )
+				{
+					copyRegion( texture, atlas, srcEdgeX[side], 0u, blockSize, height,
+								dstPadX[side] + i, dstY );
+					copyRegion( texture, atlas, 0u, srcEdgeY[side], width, blockSize, dstX,
+								dstPadY[side] + i );
+				}
+			}
+
+			for( size_t sideY = 0u; sideY < 2u; ++sideY )
+			{
+				for( size_t sideX = 0u; sideX < 2u; ++sideX )
+				{
+					for( uint32_t y = 0u; y < padding; y += blockSize )
+					{
+						for( uint32_t x = 0u; x < padding; x += blockSize )
+						{
+							copyRegion( texture, atlas, srcEdgeX[sideX], srcEdgeY[sideY], blockSize,
+										blockSize, dstPadX[sideX] + x, dstPadY[sideY] + y );
+						}
+					}
+				}
+			}
+		}
+
+	}  // namespace
+
+	bool SkinManager::buildSkinAtlas( uint32_t maxResolution )
+	{
+		LogListener *log = m_colibriManager->getLogListener();
+		char tmpBuffer[512];
+		Ogre::LwString errorMsg( Ogre::LwString::FromEmptyPointer( tmpBuffer, sizeof( tmpBuffer ) ) );
+
+		Ogre::HlmsManager *hlmsManager = m_colibriManager->getOgreHlmsManager();
+
+		// Gather the materials that can be merged, and the textures they use
+		typedef std::map<Ogre::IdString, size_t> MaterialToSourceMap;
+		MaterialToSourceMap materialToSource;
+		std::set<Ogre::IdString> rejectedMaterials;
+		std::vector<AtlasSource> sources;
+		Ogre::HlmsUnlitDatablock *refDatablock = 0;
+
+		SkinInfoMap::const_iterator itor = m_skins.begin();
+		SkinInfoMap::const_iterator endt = m_skins.end();
+
+		while( itor != endt )
+		{
+			const Ogre::IdString materialName = itor->second.stateInfo.materialName;
+
+			if( materialToSource.find( materialName ) == materialToSource.end() &&
+				rejectedMaterials.find( materialName ) == rejectedMaterials.end() )
+			{
+				Ogre::HlmsDatablock *datablock = hlmsManager->getDatablockNoDefault( materialName );
+
+				Ogre::HlmsUnlitDatablock *unlitDatablock = 0;
+				Ogre::TextureGpu *texture = 0;
+				if( datablock && datablock->getCreator()->getType() == Ogre::HLMS_UNLIT )
+				{
+					unlitDatablock = static_cast<Ogre::HlmsUnlitDatablock *>( datablock );
+					texture = unlitDatablock->getTexture( 0u );
+				}
+
+				if( texture )
+				{
+					// We need the resolution, format and number of mipmaps
+					if( texture->getResidencyStatus() != Ogre::GpuResidency::Resident )
+						texture->scheduleTransitionTo( Ogre::GpuResidency::Resident );
+					texture->waitForData();
+				}
+
+				// UVs are remapped by us, thus they can't be animated by the material.
+				// The atlas has no mipmaps (each level would bleed into its neighbours),
+				// thus mipmapped textures would lose theirs.
+				bool isCompatible = texture &&
+									texture->getTextureType() == Ogre::TextureTypes::Type2D &&
+									texture->getNumMipmaps() == 1u &&
+									!unlitDatablock->getEnableAnimationMatrix( 0u );
+				if( isCompatible &&
+					Ogre::PixelFormatGpuUtils::isCompressed( texture->getPixelFormat() ) )
+				{
+					// Must be copied in whole blocks
+					isCompatible = ( texture->getWidth() % 4u ) == 0u &&
+								   ( texture->getHeight() % 4u ) == 0u;
+				}
+				if( isCompatible && refDatablock )
+				{
+					isCompatible =
+						Renderable::areDatablocksInterchangeable( unlitDatablock, refDatablock, true ) &&
+						texture->getPixelFormat() == sources.front().texture->getPixelFormat();
+				}
+
+				if( isCompatible )
+				{
+					if( !refDatablock )
+						refDatablock = unlitDatablock;
+
+					size_t sourceIdx = 0u;
+					while( sourceIdx < sources.size() && sources[sourceIdx].texture != texture )
+						++sourceIdx;
+
+					if( sourceIdx == sources.size() )
+					{
+						AtlasSource source;
+						source.texture = texture;
+						source.x = 0u;
+						source.y = 0u;
+						sources.push_back( source );
+					}
+
+					materialToSource[materialName] = sourceIdx;
+				}
+				else
+				{
+					rejectedMaterials.insert( materialName );
+					if( texture )
+					{
+						errorMsg.clear();
+						errorMsg.a( "[SkinManager::buildSkinAtlas]: Material of skin ",
+									itor->second.name.c_str(),
+									" is not compatible with the atlas. It won't be packed" );
+						log->log( errorMsg.c_str(), LogSeverity::Warning );
+					}
+				}
+			}
+
+			++itor;
+		}
+
+		if( materialToSource.size() <= 1u )
+			return false;  // Nothing to gain
+
+		// Shelf packing, tallest first. Offsets are kept multiple of 4 so that
+		// compressed formats can be copied, and textures are padded on every side
+		// against bleeding (see copyIntoAtlas).
+		const uint32_t padding = 4u;
+
+		std::vector<size_t> sortedSources;
+		sortedSources.reserve( sources.size() );
+		uint32_t maxSourceWidth = 0u;
+		uint64_t totalArea = 0u;
+		for( size_t i = 0u; i < sources.size(); ++i )
+		{
+			sortedSources.push_back( i );
+			const uint32_t width = Ogre::alignToNextMultiple( sources[i].texture->getWidth() + padding * 2u, 4u );
+			const uint32_t height = Ogre::alignToNextMultiple( sources[i].texture->getHeight() + padding * 2u, 4u );
+			maxSourceWidth = std::max( maxSourceWidth, width );
+			totalArea += uint64_t( width ) * uint64_t( height );
+		}
+		std::sort( sortedSources.begin(), sortedSources.end(), AtlasSourceTallerFirst( sources ) );
+
+		uint32_t atlasWidth = Ogre::Bitwise::firstPO2From( std::max(
+			maxSourceWidth, static_cast<uint32_t>( std::ceil( std::sqrt( double( totalArea ) ) ) ) ) );
+		atlasWidth = std::min( atlasWidth, maxResolution );
+
+		uint32_t currX = 0u;
+		uint32_t currY = 0u;
+		uint32_t shelfHeight = 0u;
+
+		std::vector<size_t>::const_iterator itSource = sortedSources.begin();
+		std::vector<size_t>::const_iterator enSource = sortedSources.end();
+
+		while( itSource != enSource )
+		{
+			AtlasSource &source = sources[*itSource];
+			const uint32_t width = Ogre::alignToNextMultiple( source.texture->getWidth() + padding * 2u, 4u );
+			const uint32_t height = Ogre::alignToNextMultiple( source.texture->getHeight() + padding * 2u, 4u );
+
+			if( currX + width > atlasWidth && currX != 0u )
+			{
+				currX = 0u;
+				currY += shelfHeight;
+				shelfHeight = 0u;
+			}
+
+			source.x = currX + padding;
+			source.y = currY + padding;
+			currX += width;
+			shelfHeight = std::max( shelfHeight, height );
+
+			++itSource;
+		}
+
+		const uint32_t atlasHeight = Ogre::Bitwise::firstPO2From( currY + shelfHeight );
+
+		if( maxSourceWidth > atlasWidth || atlasHeight > maxResolution )
+		{
+			errorMsg.clear();
+			errorMsg.a( "[SkinManager::buildSkinAtlas]: Skin textures don't fit in a ", maxResolution,
+						"x", maxResolution, " atlas. Skins were left untouched" );
+			log->log( errorMsg.c_str(), LogSeverity::Error );
+			return false;
+		}
+
+		// Create the atlas and copy every texture into it
+		Ogre::TextureGpuManager *textureManager =
+			hlmsManager->getRenderSystem()->getTextureGpuManager();
+
+		const uint32_t atlasId = Ogre::Id::generateNewId<SkinManager>();
+
+		errorMsg.clear();
+		errorMsg.a( "ColibriSkinAtlas", atlasId );
+		const std::string atlasName = errorMsg.c_str();
+
+		Ogre::TextureGpu *atlas = textureManager->createTexture(
+			atlasName, Ogre::GpuPageOutStrategy::Discard, Ogre::TextureFlags::ManualTexture,
+			Ogre::TextureTypes::Type2D );
+		atlas->setResolution( atlasWidth, atlasHeight );
+		atlas->setPixelFormat( sources.front().texture->getPixelFormat() );
+		atlas->setNumMipmaps( 1u );
+		atlas->scheduleTransitionTo( Ogre::GpuResidency::Resident );
+
+		{
+			// Clear the whole atlas first. The space left unused by the packing
+			// would contain garbage otherwise
+			Ogre::StagingTexture *stagingTexture = textureManager->getStagingTexture(
+				atlasWidth, atlasHeight, 1u, 1u, atlas->getPixelFormat() );
+			stagingTexture->startMapRegion();
+			Ogre::TextureBox textureBox = stagingTexture->mapRegion( atlasWidth, atlasHeight, 1u, 1u,
+																	 atlas->getPixelFormat() );
+			memset( textureBox.data, 0, textureBox.bytesPerImage );
+			stagingTexture->stopMapRegion();
+			stagingTexture->upload( textureBox, atlas, 0u );
+			textureManager->removeStagingTexture( stagingTexture );
+
+#if OGRE_VERSION >= OGRE_MAKE_VERSION( 2, 3, 0 )
+			// The copies below overlap with the upload. OgreNext doesn't place barriers
+			// between copies to the same texture (see GraphChart::syncChart)
+			hlmsManager->getRenderSystem()->endCopyEncoder();
+#endif
+		}
+
+		std::vector<AtlasSource>::const_iterator itCopy = sources.begin();
+		std::vector<AtlasSource>::const_iterator enCopy = sources.end();
+
+		while( itCopy != enCopy )
+		{
+			copyIntoAtlas( itCopy->texture, atlas, itCopy->x, itCopy->y, padding );
+			++itCopy;
+		}
+
+		Ogre::HlmsUnlitDatablock *atlasDatablock =
+			static_cast<Ogre::HlmsUnlitDatablock *>( refDatablock->clone( atlasName ) );
+		atlasDatablock->setTexture( 0u, atlas );
+
+		m_skinAtlasTextures.push_back( atlas );
+		m_skinAtlasDatablocks.push_back( atlasName );
+
+		// Remap the skins into the atlas
+		const Ogre::Vector2 invAtlasRes( 1.0f / static_cast<float>( atlasWidth ),
+										 1.0f / static_cast<float>( atlasHeight ) );
+
+		SkinInfoMap::iterator itSkin = m_skins.begin();
+		SkinInfoMap::iterator enSkin = m_skins.end();
+
+		while( itSkin != enSkin )
+		{
+			StateInformation &stateInfo = itSkin->second.stateInfo;
+			MaterialToSourceMap::const_iterator itMat = materialToSource.find( stateInfo.materialName );
+			if( itMat != materialToSource.end() )
+			{
+				const AtlasSource &source = sources[itMat->second];
+				const Ogre::Vector2 scale(
+					static_cast<float>( source.texture->getWidth() ) * invAtlasRes.x,
+					static_cast<float>( source.texture->getHeight() ) * invAtlasRes.y );
+				const Ogre::Vector2 offset( static_cast<float>( source.x ) * invAtlasRes.x,
+											static_cast<float>( source.y ) * invAtlasRes.y );
+
+				for( size_t i = 0u; i < GridLocations::NumGridLocations; ++i )
+				{
+					Ogre::Vector4 &uv = stateInfo.uvTopLeftBottomRight[i];
+					uv.x = uv.x * scale.x + offset.x;
+					uv.y = uv.y * scale.y + offset.y;
+					uv.z = uv.z * scale.x + offset.x;
+					uv.w = uv.w * scale.y + offset.y;
+				}
+
+				stateInfo.materialName = atlasName;
+				itSkin->second.materialName = atlasName;
+			}
+
+			++itSkin;
+		}
+
+		// Live widgets keep pointing to the skins we just modified, but still use the old
+		// datablocks. They'd sample the old texture with the atlas' UVs
+		m_colibriManager->_notifySkinsChanged();
+
+		errorMsg.clear();
+		errorMsg.a( "[SkinManager::buildSkinAtlas]: Packed ", (uint32_t)sources.size(),
+					" textures from ", (uint32_t)materialToSource.size(), " materials into ",
+					atlasName.c_str() );
+		errorMsg.a( " (", atlasWidth, "x", atlasHeight, ")" );
+		log->log( errorMsg.c_str(), LogSeverity::Info );
+
+		return true;
+	}
+	//-------------------------------------------------------------------------
+	Ogre::TextureGpu *colibri_nullable SkinManager::getSkinAtlasTexture() const
+	{
+		return m_skinAtlasTextures.empty() ? 0 : m_skinAtlasTextures.back();
+	}
+	//-------------------------------------------------------------------------
+	void SkinManager::_destroySkinAtlases()
+	{
+		if( m_skinAtlasTextures.empty() )
+			return;
+
+		if( !m_colibriManager->getOgreRoot() )
+		{
+			// setOgre( 0, 0, 0 ) was already called. Ogre destroys the
+			// textures and datablocks on its own when shutting down
+			m_skinAtlasDatablocks.clear();
+			m_skinAtlasTextures.clear();
+			return;
+		}
+
+		Ogre::HlmsManager *hlmsManager = m_colibriManager->getOgreHlmsManager();
+
+		std::vector<Ogre::IdString>::const_iterator itor = m_skinAtlasDatablocks.begin();
+		std::vector<Ogre::IdString>::const_iterator endt = m_skinAtlasDatablocks.end();
+
+		while( itor != endt )
+		{
+			Ogre::HlmsDatablock *datablock = hlmsManager->getDatablockNoDefault( *itor );
+			if( datablock )
+				datablock->getCreator()->destroyDatablock( *itor );
+			++itor;
+		}
+
+		Ogre::TextureGpuManager *textureManager =
+			hlmsManager->getRenderSystem()->getTextureGpuManager();
+
+		std::vector<Ogre::TextureGpu *>::const_iterator itTex = m_skinAtlasTextures.begin();
+		std::vector<Ogre::TextureGpu *>::const_iterator enTex = m_skinAtlasTextures.end();
+
+		while( itTex != enTex )
+		{
+			textureManager->destroyTexture( *itTex );
+			++itTex;
+		}
+
+		m_skinAtlasDatablocks.clear();
+		m_skinAtlasTextures.clear();
 	}
 }
@@ -216,7 +216,7 @@ namespace Colibri
 		const Ogre::Vector2 handleTopLeft = m_layers[1]->getLocalTopLeft();
 		const Ogre::Vector2 handleBottomRight = m_layers[1]->getLocalBottomRight();
 		if( ( handleTopLeft.x < 0.0f || handleTopLeft.y < 0.0f ||  //
-			  handleBottomRight.x > m_size.x || handleBottomRight.y > m_size.y ) )
+			  handleBottomRight.x > _size().x || handleBottomRight.y > _size().y ) )
 		{
 			static bool sWarnedOnce = false;
 			if( !sWarnedOnce )
@@ -281,7 +281,7 @@ namespace Colibri
 
 				const float sliderWidth =
 					getSliderLine()->getDerivedBottomRight().x - getSliderLine()->getDerivedTopLeft().x;
-				const float mouseRelativeX = pos.x - m_derivedTopLeft.x;
+				const float mouseRelativeX = pos.x - _derivedTopLeft().x;
 				float posX = mouseRelativeX / sliderWidth;
 				if( rightToLeft )
 					posX = 1.0f - posX;
@@ -305,7 +305,7 @@ namespace Colibri
 			{
 				const float sliderHeight =
 					getSliderLine()->getDerivedBottomRight().y - getSliderLine()->getDerivedTopLeft().y;
-				const float mouseRelativeY = pos.y - m_derivedTopLeft.y;
+				const float mouseRelativeY = pos.y - _derivedTopLeft().y;
 				float posY = 1.0f - mouseRelativeY / sliderHeight;
 
 				if( cursorBegin && getSliderHandle()->intersects( pos ) )
@@ -83,7 +83,7 @@ namespace Colibri
 		if( m_label )
 		{
 			const float remainingSize = std::max(
-				0.0f, m_size.x - outSizes[SW_Decrement] - outSizes[SW_Increment] -
+				0.0f, _size().x - outSizes[SW_Decrement] - outSizes[SW_Increment] -
 						  outSizes[SW_OptionLabel] - m_arrowMargin * 2.0f - m_label->m_margin.x );
 			outSizes[SW_Label] = std::min( m_sizeLabel, remainingSize );
 			outSizes[SW_Space] = remainingSize - outSizes[SW_Label];
@@ -91,7 +91,7 @@ namespace Colibri
 		else
 		{
 			const float remainingSize =
-				std::max( 0.0f, m_size.x - outSizes[SW_Decrement] - outSizes[SW_Increment] -
+				std::max( 0.0f, _size().x - outSizes[SW_Decrement] - outSizes[SW_Increment] -
 									m_arrowMargin * 2.0f );
 
 			outSizes[SW_OptionLabel] = std::max( outSizes[SW_OptionLabel], remainingSize );
@@ -398,7 +398,7 @@ namespace Colibri
 	//-------------------------------------------------------------------------
 	void Spinner::sizeToFit()
 	{
-		m_size = Ogre::Vector2::ZERO;
+		_size() = Ogre::Vector2::ZERO;
 
 		float sizeLabel, sizeOptionLabel, height;
 		calculateSizes( sizeLabel, sizeOptionLabel, height );
@@ -0,0 +1,500 @@
+
+#include "ColibriGui/ColibriTextView.h"
+
+#include "ColibriGui/ColibriLabel.h"
+#include "ColibriGui/ColibriManager.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace Colibri
+{
+	static const size_t c_noDirtyParagraphs = std::numeric_limits<size_t>::max();
+	/// When the first paragraph goes beyond this offset, all paragraphs are moved back up
+	/// to keep precision (see TextView::rebaseParagraphs)
+	static const float c_rebaseThreshold = 65536.0f;
+
+	TextView::TextView( ColibriManager *manager ) :
+		Widget( manager ),
+		m_contentBottom( 0.0f ),
+		m_currentScroll( Ogre::Vector2::ZERO ),
+		m_paragraphSpacing( 0.0f ),
+		m_wrappedWidth( 0.0f ),
+		m_firstDirtyParagraph( c_noDirtyParagraphs ),
+		m_rewrapPending( false ),
+		m_autoScrollToBottom( true ),
+		m_maxParagraphs( 0u ),
+		m_defaultFontSize( manager->getDefaultFontSize26d6() ),
+		m_defaultFont( 0u ),
+		m_defaultColour( Ogre::ColourValue::White ),
+		m_visibleBegin( 0u ),
+		m_visibleEnd( 0u )
+	{
+	}
+	//-------------------------------------------------------------------------
+	void TextView::_initialize()
+	{
+		m_wrappedWidth = getSizeAfterClipping().x;
+		m_manager->_addUpdateWidget( this );
+		Widget::_initialize();
+	}
+	//-------------------------------------------------------------------------
+	void TextView::_destroy()
+	{
+		m_manager->_removeUpdateWidget( this );
+
+		// Our paragraphs are destroyed as regular children
+		Widget::_destroy();
+
+		m_paragraphs.clear();
+		m_paragraphTops.clear();
+		m_visibleBegin = 0u;
+		m_visibleEnd = 0u;
+	}
+	//-------------------------------------------------------------------------
+	bool TextView::_isInternalChild( const Widget * /*child*/ ) const
+	{
+		// All of our children are paragraphs we created
+		return true;
+	}
+	//-------------------------------------------------------------------------
+	void TextView::wrapParagraph( Label *paragraph )
+	{
+		// A width of 0 means we haven't been given a size yet. Don't wrap every word.
+		// We will wrap again once setSize is called.
+		const float maxWidth =
+			m_wrappedWidth > 0.0f ? m_wrappedWidth : std::numeric_limits<float>::max();
+		paragraph->sizeToFit( maxWidth );
+	}
+	//-------------------------------------------------------------------------
+	void TextView::cullVisibleParagraphs()
+	{
+		const size_t visibleEnd = std::min( m_visibleEnd, m_paragraphs.size() );
+		for( size_t i = m_visibleBegin; i < visibleEnd; ++i )
+			m_paragraphs[i]->_culled() = true;
+
+		m_visibleBegin = 0u;
+		m_visibleEnd = 0u;
+	}
+	//-------------------------------------------------------------------------
+	void TextView::getVisibleParagraphs( size_t &outBegin, size_t &outEnd ) const
+	{
+		const float viewTop = m_currentScroll.y;
+		const float viewBottom = viewTop + getSizeAfterClipping().y;
+
+		// The last paragraph starting at or above viewTop is the first visible one
+		std::vector<float>::const_iterator itor =
+			std::upper_bound( m_paragraphTops.begin(), m_paragraphTops.end(), viewTop );
+		if( itor != m_paragraphTops.begin() )
+			--itor;
+		outBegin = static_cast<size_t>( itor - m_paragraphTops.begin() );
+
+		// The first paragraph starting at or below viewBottom is not visible
+		itor = std::lower_bound( itor, m_paragraphTops.end(), viewBottom );
+		outEnd = static_cast<size_t>( itor - m_paragraphTops.begin() );
+	}
+	//-------------------------------------------------------------------------
+	float TextView::getMinScroll() const
+	{
+		return m_paragraphTops.empty() ? 0.0f : m_paragraphTops.front();
+	}
+	//-------------------------------------------------------------------------
+	void TextView::clampScroll( bool toBottom )
+	{
+		const float minScroll = getMinScroll();
+		const float maxScroll = minScroll + getMaxScroll();
+
+		const float newScroll =
+			toBottom ? maxScroll : Ogre::Math::Clamp( m_currentScroll.y, minScroll, maxScroll );
+
+		if( newScroll != m_currentScroll.y )
+		{
+			m_currentScroll.y = newScroll;
+			syncTransformClipping();
+			m_manager->_setWidgetTransformsDirty();
+		}
+	}
+	//-------------------------------------------------------------------------
+	void TextView::rebaseParagraphs()
+	{
+		const float offset = getMinScroll();
+
+		const size_t numParagraphs = m_paragraphs.size();
+		for( size_t i = 0u; i < numParagraphs; ++i )
+		{
+			m_paragraphTops[i] -= offset;
+			m_paragraphs[i]->setTopLeft( Ogre::Vector2( 0.0f, m_paragraphTops[i] ) );
+		}
+
+		m_contentBottom -= offset;
+		m_currentScroll.y -= offset;
+		syncTransformClipping();
+	}
+	//-------------------------------------------------------------------------
+	size_t TextView::appendParagraph( const std::string &text )
+	{
+		const bool wasAtBottom = isAtBottom();
+
+		Label *paragraph = m_manager->createWidget<Label>( this );
+		// Until _fillBuffersAndCommands finds it to be visible
+		paragraph->_culled() = true;
+		paragraph->setDefaultFontSize( m_defaultFontSize );
+		paragraph->setDefaultFont( m_defaultFont );
+		paragraph->setTextColour( m_defaultColour );
+		paragraph->setText( text.empty() ? std::string( " " ) : text );
+
+		size_t idx = m_paragraphs.size();
+		m_paragraphs.push_back( paragraph );
+
+		if( !m_rewrapPending )
+			wrapParagraph( paragraph );
+
+		if( m_firstDirtyParagraph == c_noDirtyParagraphs && !m_rewrapPending )
+		{
+			// Layout is up to date. Place it right away, only this paragraph is affected
+			const float top = idx == 0u ? m_contentBottom : m_contentBottom + m_paragraphSpacing;
+			m_paragraphTops.push_back( top );
+			paragraph->setTopLeft( Ogre::Vector2( 0.0f, top ) );
+			m_contentBottom = top + paragraph->getSize().y;
+		}
+		else
+		{
+			// Keep m_paragraphTops sorted until updateLayout places it
+			m_paragraphTops.push_back( m_contentBottom );
+			m_firstDirtyParagraph = std::min( m_firstDirtyParagraph, idx );
+		}
+
+		if( m_maxParagraphs != 0u && m_paragraphs.size() > m_maxParagraphs )
+		{
+			const size_t numToRemove = m_paragraphs.size() - m_maxParagraphs;
+			removeParagraphs( 0u, numToRemove );
+			idx -= numToRemove;
+		}
+
+		clampScroll( wasAtBottom && m_autoScrollToBottom );
+
+		return idx;
+	}
+	//-------------------------------------------------------------------------
+	void TextView::setParagraphText( size_t idx, const std::string &text )
+	{
+		COLIBRI_ASSERT_LOW( idx < m_paragraphs.size() );
+
+		Label *paragraph = m_paragraphs[idx];
+		const float oldHeight = paragraph->getSize().y;
+
+		paragraph->setText( text.empty() ? std::string( " " ) : text );
+
+		if( !m_rewrapPending )
+		{
+			wrapParagraph( paragraph );
+			if( paragraph->getSize().y != oldHeight )
+				m_firstDirtyParagraph = std::min( m_firstDirtyParagraph, idx + 1u );
+		}
+	}
+	//-------------------------------------------------------------------------
+	const std::string &TextView::getParagraphText( size_t idx ) const
+	{
+		COLIBRI_ASSERT_LOW( idx < m_paragraphs.size() );
+		return m_paragraphs[idx]->getText();
+	}
+	//-------------------------------------------------------------------------
+	Label *TextView::getParagraphLabel( size_t idx )
+	{
+		COLIBRI_ASSERT_LOW( idx < m_paragraphs.size() );
+		return m_paragraphs[idx];
+	}
+	//-------------------------------------------------------------------------
+	void TextView::removeParagraphs( size_t first, size_t count )
+	{
+		COLIBRI_ASSERT_LOW( first <= m_paragraphs.size() );
+
+		count = std::min( count, m_paragraphs.size() - first );
+		if( count == 0u )
+			return;
+
+		const bool wasAtBottom = isAtBottom();
+
+		// Indices are about to shift
+		cullVisibleParagraphs();
+
+		const ptrdiff_t firstIdx = static_cast<ptrdiff_t>( first );
+		const ptrdiff_t lastIdx = static_cast<ptrdiff_t>( first + count );
+
+		for( size_t i = first; i < first + count; ++i )
+			m_manager->destroyWidget( m_paragraphs[i] );
+
+		m_paragraphs.erase( m_paragraphs.begin() + firstIdx, m_paragraphs.begin() + lastIdx );
+		m_paragraphTops.erase( m_paragraphTops.begin() + firstIdx,
+							   m_paragraphTops.begin() + lastIdx );
+
+		if( m_paragraphs.empty() )
+		{
+			m_contentBottom = 0.0f;
+			m_firstDirtyParagraph = c_noDirtyParagraphs;
+		}
+		else
+		{
+			if( m_firstDirtyParagraph != c_noDirtyParagraphs )
+			{
+				if( m_firstDirtyParagraph >= first + count )
+					m_firstDirtyParagraph -= count;
+				else if( m_firstDirtyParagraph > first )
+					m_firstDirtyParagraph = first;
+			}
+
+			// When removing from the front, the remaining paragraphs stay where they are.
+			// The top of the new first paragraph simply becomes the start of the content.
+			if( first != 0u )
+				m_firstDirtyParagraph = std::min( m_firstDirtyParagraph, first );
+			else if( getMinScroll() > c_rebaseThreshold )
+				rebaseParagraphs();
+		}
+
+		clampScroll( wasAtBottom && m_autoScrollToBottom );
+	}
+	//-------------------------------------------------------------------------
+	void TextView::clear()
+	{
+		removeParagraphs( 0u, m_paragraphs.size() );
+	}
+	//-------------------------------------------------------------------------
+	void TextView::setText( const std::string &text )
+	{
+		clear();
+
+		size_t start = 0u;
+		while( true )
+		{
+			const size_t end = text.find( '\n', start );
+			appendParagraph( text.substr( start, end - start ) );
+			if( end == std::string::npos )
+				break;
+			start = end + 1u;
+		}
+	}
+	//-------------------------------------------------------------------------
+	void TextView::setMaxParagraphs( size_t maxParagraphs )
+	{
+		m_maxParagraphs = maxParagraphs;
+		if( m_maxParagraphs != 0u && m_paragraphs.size() > m_maxParagraphs )
+			removeParagraphs( 0u, m_paragraphs.size() - m_maxParagraphs );
+	}
+	//-------------------------------------------------------------------------
+	void TextView::setParagraphSpacing( float spacing )
+	{
+		if( m_paragraphSpacing != spacing )
+		{
+			m_paragraphSpacing = spacing;
+			m_firstDirtyParagraph = 0u;
+		}
+	}
+	//-------------------------------------------------------------------------
+	void TextView::setDefaultFontSize( FontSize defaultFontSize )
+	{
+		if( m_defaultFontSize != defaultFontSize )
+		{
+			m_defaultFontSize = defaultFontSize;
+
+			std::vector<Label *>::const_iterator itor = m_paragraphs.begin();
+			std::vector<Label *>::const_iterator endt = m_paragraphs.end();
+
+			while( itor != endt )
+			{
+				( *itor )->setDefaultFontSize( defaultFontSize );
+				++itor;
+			}
+
+			m_rewrapPending = true;
+		}
+	}
+	//-------------------------------------------------------------------------
+	void TextView::setDefaultFont( uint16_t defaultFont )
+	{
+		if( m_defaultFont != defaultFont )
+		{
+			m_defaultFont = defaultFont;
+
+			std::vector<Label *>::const_iterator itor = m_paragraphs.begin();
+			std::vector<Label *>::const_iterator endt = m_paragraphs.end();
+
+			while( itor != endt )
+			{
+				( *itor )->setDefaultFont( defaultFont );
+				++itor;
+			}
+
+			m_rewrapPending = true;
+		}
+	}
+	//-------------------------------------------------------------------------
+	void TextView::setTextColour( const Ogre::ColourValue &colour )
+	{
+		m_defaultColour = colour;
+
+		std::vector<Label *>::const_iterator itor = m_paragraphs.begin();
+		std::vector<Label *>::const_iterator endt = m_paragraphs.end();
+
+		while( itor != endt )
+		{
+			( *itor )->setTextColour( colour );
+			++itor;
+		}
+	}
+	//-------------------------------------------------------------------------
+	void TextView::setScroll( float scroll )
+	{
+		const float newScroll = getMinScroll() + Ogre::Math::Clamp( scroll, 0.0f, getMaxScroll() );
+		if( newScroll != m_currentScroll.y )
+		{
+			m_currentScroll.y = newScroll;
+			syncTransformClipping();
+			m_manager->_setWidgetTransformsDirty();
+		}
+	}
+	//-------------------------------------------------------------------------
+	float TextView::getScroll() const
+	{
+		return m_currentScroll.y - getMinScroll();
+	}
+	//-------------------------------------------------------------------------
+	float TextView::getMaxScroll() const
+	{
+		return std::max( 0.0f, getContentHeight() - getSizeAfterClipping().y );
+	}
+	//-------------------------------------------------------------------------
+	void TextView::scrollToBottom()
+	{
+		clampScroll( true );
+	}
+	//-------------------------------------------------------------------------
+	bool TextView::isAtBottom() const
+	{
+		return getScroll() >= getMaxScroll() - 0.5f;
+	}
+	//-------------------------------------------------------------------------
+	float TextView::getContentHeight() const
+	{
+		return m_contentBottom - getMinScroll();
+	}
+	//-------------------------------------------------------------------------
+	void TextView::updateLayout()
+	{
+		if( !m_rewrapPending && m_firstDirtyParagraph == c_noDirtyParagraphs )
+			return;
+
+		const bool wasAtBottom = isAtBottom();
+
+		if( m_rewrapPending )
+		{
+			// Labels cache their break opportunities, thus this does not reshape anything
+			// unless the font or its size changed.
+			m_wrappedWidth = getSizeAfterClipping().x;
+
+			std::vector<Label *>::const_iterator itor = m_paragraphs.begin();
+			std::vector<Label *>::const_iterator endt = m_paragraphs.end();
+
+			while( itor != endt )
+			{
+				wrapParagraph( *itor );
+				++itor;
+			}
+
+			m_rewrapPending = false;
+			m_firstDirtyParagraph = 0u;
+		}
+
+		const size_t numParagraphs = m_paragraphs.size();
+
+		// The first paragraph keeps its top (see removeParagraphs). The rest are stacked below
+		for( size_t i = std::max<size_t>( m_firstDirtyParagraph, 1u ); i < numParagraphs; ++i )
+		{
+			m_paragraphTops[i] =
+				m_paragraphTops[i - 1u] + m_paragraphs[i - 1u]->getSize().y + m_paragraphSpacing;
+			m_paragraphs[i]->setTopLeft( Ogre::Vector2( 0.0f, m_paragraphTops[i] ) );
+		}
+
+		if( numParagraphs == 0u )
+			m_contentBottom = 0.0f;
+		else
+			m_contentBottom = m_paragraphTops.back() + m_paragraphs.back()->getSize().y;
+
+		m_firstDirtyParagraph = c_noDirtyParagraphs;
+
+		clampScroll( wasAtBottom && m_autoScrollToBottom );
+	}
+	//-------------------------------------------------------------------------
+	const Ogre::Vector2 &TextView::getCurrentScroll() const
+	{
+		return m_currentScroll;
+	}
+	//-------------------------------------------------------------------------
+	void TextView::setTransformDirty( uint32_t dirtyReason )
+	{
+		if( ( dirtyReason & ( TransformDirtyParentCaller | TransformDirtyScale ) ) ==
+			TransformDirtyScale )
+		{
+			if( getSizeAfterClipping().x != m_wrappedWidth )
+				m_rewrapPending = true;
+			else
+			{
+				// Only the height may have changed. Scroll needs to be clamped again
+				m_firstDirtyParagraph = std::min( m_firstDirtyParagraph, m_paragraphs.size() );
+			}
+		}
+
+		Widget::setTransformDirty( dirtyReason );
+	}
+	//-------------------------------------------------------------------------
+	void TextView::_update( float timeSinceLast )
+	{
+		updateLayout();
+	}
+	//-------------------------------------------------------------------------
+	void TextView::_fillBuffersAndCommands( UiVertex **RESTRICT_ALIAS vertexBuffer,
+											GlyphVertex **RESTRICT_ALIAS textVertBuffer,
+											const Ogre::Vector2 &parentPos,
+											const Ogre::Vector2 &parentCurrentScrollPos,
+											const Matrix2x3 &parentRot )
+	{
+		updateDerivedTransform( parentPos, parentRot );
+
+		cullVisibleParagraphs();
+
+		_culled() = true;
+
+		if( !m_parent->intersectsChild( this, parentCurrentScrollPos ) || m_hidden ||
+			m_manager->_isOccluded( _derivedTopLeft(), _derivedBottomRight() ) )
+			return;
+
+		_culled() = false;
+
+		const Ogre::Vector2 invCanvasSize2x = m_manager->getInvCanvasSize2x();
+
+		Ogre::Vector2 parentDerivedTL = m_parent->_derivedTopLeft() +
+										m_parent->m_clipBorderTL * invCanvasSize2x;
+		Ogre::Vector2 parentDerivedBR = m_parent->_derivedBottomRight() -
+										m_parent->m_clipBorderBR * invCanvasSize2x;
+
+		parentDerivedTL.makeCeil( m_parent->_accumMinClipTL() );
+		parentDerivedBR.makeFloor( m_parent->_accumMaxClipBR() );
+		_accumMinClipTL() = parentDerivedTL;
+		_accumMaxClipBR() = parentDerivedBR;
+
+		const Ogre::Vector2 outerTopLeftWithClipping =
+			_derivedTopLeft() + ( m_clipBorderTL - m_currentScroll ) * invCanvasSize2x;
+
+		size_t visibleBegin, visibleEnd;
+		getVisibleParagraphs( visibleBegin, visibleEnd );
+
+		for( size_t i = visibleBegin; i < visibleEnd; ++i )
+		{
+			m_paragraphs[i]->_fillBuffersAndCommands( vertexBuffer, textVertBuffer,
+													  outerTopLeftWithClipping, m_currentScroll,
+													  _derivedOrientation() );
+		}
+
+		m_visibleBegin = visibleBegin;
+		m_visibleEnd = visibleEnd;
+	}
+}  // namespace Colibri
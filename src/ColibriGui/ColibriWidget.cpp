@@ -17,13 +17,14 @@ namespace Colibri
 		Borders::NumBorders
 	};
 
-	const Matrix2x3 Matrix2x3::IDENTITY( 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f );
-
 	Widget::Widget( ColibriManager *manager ) :
 		m_parent( 0 ),
 		m_numNonRenderables( 0 ),
 		m_numWidgets( 0 ),
 		m_manager( manager ),
+		m_transformStore( &manager->_getTransformStore() ),
+		m_transformId( m_transformStore->createSlot( this ) ),
+		m_coldData( 0 ),
 		m_hidden( false ),
 		m_ignoreFromChildrenSize( false ),
 		m_clickable( false ),
@@ -32,27 +33,17 @@ namespace Colibri
 		m_pressable( true ),
 		m_mouseReleaseTriggersPrimaryAction( true ),
 		m_consumesScroll( false ),
-		m_culled( false ),
 		m_breadthFirst( false ),
+		m_reorderChildrenForBatching( false ),
 		m_userId( 0 ),
 		m_currentState( States::Idle ),
-		m_position( Ogre::Vector2::ZERO ),
-		m_size( Ogre::Vector2::ZERO ),
-		m_orientation( Ogre::Vector4( 1.0f, 0.0f,  //
-									  0.0f, 1.0f ) ),
-		m_derivedTopLeft( Ogre::Vector2::ZERO ),
-		m_derivedBottomRight( Ogre::Vector2::ZERO ),
-		m_derivedOrientation( Matrix2x3::IDENTITY ),
 		m_clipBorderTL( Ogre::Vector2::ZERO ),
 		m_clipBorderBR( Ogre::Vector2::ZERO ),
-		m_accumMinClipTL( -1.0f ),
-		m_accumMaxClipBR( 1.0f ),
 		m_zOrderDirty( false ),
 		m_zOrderHasDirtyChildren( false ),
 		m_zOrder( _wrapZOrderInternalId( 0 ) )  // WARNING: Relies on virtual calls (won't work right)
 #if COLIBRIGUI_DEBUG >= COLIBRIGUI_DEBUG_MEDIUM
 		,
-		m_transformOutOfDate( false ),
 		m_destructionStarted( false )
   #endif
 	{
@@ -64,8 +55,20 @@ namespace Colibri
 	Widget::~Widget()
 	{
 		COLIBRI_ASSERT( m_children.empty() && "_destroy not called before deleting!" );
+		delete m_coldData;
+		m_coldData = 0;
+		m_transformStore->destroySlot( m_transformId );
+	}
+	//-------------------------------------------------------------------------
+	Widget::ColdData &Widget::getColdData()
+	{
+		if( !m_coldData )
+			m_coldData = new ColdData();
+		return *m_coldData;
 	}
 	//-------------------------------------------------------------------------
+	Widget::ColdData *colibri_nullable Widget::getColdDataIfExists() const { return m_coldData; }
+	//-------------------------------------------------------------------------
 	size_t Widget::notifyParentChildIsDestroyed( Widget *childWidgetBeingRemoved )
 	{
 		size_t retVal = std::numeric_limits<size_t>::max();
@@ -159,24 +162,76 @@ namespace Colibri
 	void Widget::setDebugName( const std::string &debugName )
 	{
 #if COLIBRIGUI_DEBUG >= COLIBRIGUI_DEBUG_MEDIUM
-		m_debugName = debugName;
+		getColdData().debugName = debugName;
 #endif
 	}
 	//-------------------------------------------------------------------------
 	const std::string &Widget::_getDebugName() const
 	{
-#if COLIBRIGUI_DEBUG >= COLIBRIGUI_DEBUG_MEDIUM
-		return m_debugName;
-#else
 		static std::string c_blankString = "";
-		return c_blankString;
+#if COLIBRIGUI_DEBUG >= COLIBRIGUI_DEBUG_MEDIUM
+		if( m_coldData )
+			return m_coldData->debugName;
 #endif
+		return c_blankString;
 	}
 	//-------------------------------------------------------------------------
 	void Widget::_initialize()
 	{
 	}
 	//-------------------------------------------------------------------------
+	void Widget::_cloneSettingsTo( Widget *dst ) const
+	{
+		COLIBRI_ASSERT_LOW( dst != this );
+		COLIBRI_ASSERT_LOW( dst->m_manager == m_manager );
+
+		dst->m_hidden = m_hidden;
+		dst->m_ignoreFromChildrenSize = m_ignoreFromChildrenSize;
+		dst->m_clickable = m_clickable;
+		dst->m_keyboardNavigable = m_keyboardNavigable;
+		dst->m_childrenClickable = m_childrenClickable;
+		dst->m_pressable = m_pressable;
+		dst->m_mouseReleaseTriggersPrimaryAction = m_mouseReleaseTriggersPrimaryAction;
+		dst->m_consumesScroll = m_consumesScroll;
+		dst->m_breadthFirst = m_breadthFirst;
+		dst->m_reorderChildrenForBatching = m_reorderChildrenForBatching;
+		dst->m_userId = m_userId;
+
+		for( size_t i = 0; i < Borders::NumBorders; ++i )
+			dst->m_autoSetNextWidget[i] = m_autoSetNextWidget[i];
+
+		// The state is copied as-is without calling setState. Derived classes
+		// copy whatever setState would've changed (i.e. datablocks, glyphs)
+		dst->m_currentState = m_currentState;
+
+		dst->_position() = _position();
+		dst->_size() = _size();
+		dst->_orientation() = _orientation();
+		dst->m_clipBorderTL = m_clipBorderTL;
+		dst->m_clipBorderBR = m_clipBorderBR;
+		dst->syncTransformClipping();
+
+		// LayoutCell
+		dst->m_proportion[0] = m_proportion[0];
+		dst->m_proportion[1] = m_proportion[1];
+		dst->m_priority = m_priority;
+		dst->m_expand[0] = m_expand[0];
+		dst->m_expand[1] = m_expand[1];
+		dst->m_gridLocation = m_gridLocation;
+		dst->m_margin = m_margin;
+		dst->m_minSize = m_minSize;
+
+#if COLIBRIGUI_DEBUG >= COLIBRIGUI_DEBUG_MEDIUM
+		if( m_coldData )
+			dst->getColdData().debugName = m_coldData->debugName;
+#endif
+
+		if( dst->m_zOrder != m_zOrder )
+			dst->setZOrder( getZOrder() );
+
+		dst->setTransformDirty( TransformDirtyAll );
+	}
+	//-------------------------------------------------------------------------
 	void Widget::_destroy()
 	{
 #if COLIBRIGUI_DEBUG >= COLIBRIGUI_DEBUG_MEDIUM
@@ -221,9 +276,10 @@ namespace Colibri
 			children.swap( m_children );
 			m_children.clear();
 		}
+		if( m_coldData )
 		{
-			WidgetListenerPairVec::const_iterator itor = m_listeners.begin();
-			WidgetListenerPairVec::const_iterator end  = m_listeners.end();
+			WidgetListenerPairVec::const_iterator itor = m_coldData->listeners.begin();
+			WidgetListenerPairVec::const_iterator end  = m_coldData->listeners.end();
 
 			while( itor != end )
 			{
@@ -231,7 +287,7 @@ namespace Colibri
 				++itor;
 			}
 
-			m_listeners.clear();
+			m_coldData->listeners.clear();
 		}
 #if COLIBRIGUI_DEBUG >= COLIBRIGUI_DEBUG_MEDIUM
 		m_destructionStarted = false;
@@ -246,6 +302,7 @@ namespace Colibri
 		COLIBRI_ASSERT( (parent->isWindow() || thisIsWindow == parent->isWindow()) &&
 						"Regular Widgets cannot be parents of windows!" );
 		this->m_parent = parent;
+		m_transformStore->setParent( m_transformId, parent->m_transformId );
 		if( !thisIsWindow )
 		{
 			size_t idx = parent->m_numWidgets;
@@ -412,36 +469,17 @@ namespace Colibri
 	//-------------------------------------------------------------------------
 	void Widget::updateDerivedTransform( const Ogre::Vector2 &parentPos, const Matrix2x3 &parentRot )
 	{
-		const float invCanvasAr = m_manager->getCanvasInvAspectRatio();
-		const Ogre::Vector2 invCanvasSize2x = m_manager->getInvCanvasSize2x();
-
-		m_derivedTopLeft = parentPos + m_position * invCanvasSize2x;
-		m_derivedBottomRight = m_derivedTopLeft + m_size * invCanvasSize2x;
-
-		Ogre::Vector2 ndcCenter = ( m_derivedTopLeft + m_derivedBottomRight ) * 0.5f;
-		ndcCenter.y *= invCanvasAr;
-		const Ogre::Vector2 rotatedNdcCenter = mul( m_orientation, ndcCenter );
-
-		const Ogre::Vector2 centerDiff = (ndcCenter - rotatedNdcCenter);
-
-		m_derivedOrientation.m[0][0] = m_orientation.x;
-		m_derivedOrientation.m[0][1] = m_orientation.y;
-		m_derivedOrientation.m[0][2] = centerDiff.x;
-		m_derivedOrientation.m[1][0] = m_orientation.z;
-		m_derivedOrientation.m[1][1] = m_orientation.w;
-		m_derivedOrientation.m[1][2] = centerDiff.y;
-
-		m_derivedOrientation = mul( parentRot, m_derivedOrientation );
-
-#if COLIBRIGUI_DEBUG >= COLIBRIGUI_DEBUG_MEDIUM
-		m_transformOutOfDate = false;
-#endif
+		m_transformStore->updateDerivedTransform( m_transformId, parentPos, parentRot,
+												  m_manager->getInvCanvasSize2x(),
+												  m_manager->getCanvasInvAspectRatio() );
 	}
 	//-------------------------------------------------------------------------
 	WidgetListenerPairVec::iterator Widget::findListener( WidgetListener *listener )
 	{
-		WidgetListenerPairVec::iterator itor = m_listeners.begin();
-		WidgetListenerPairVec::iterator end  = m_listeners.end();
+		COLIBRI_ASSERT_LOW( m_coldData );
+
+		WidgetListenerPairVec::iterator itor = m_coldData->listeners.begin();
+		WidgetListenerPairVec::iterator end  = m_coldData->listeners.end();
 
 		while( itor != end && itor->listener != listener )
 			++itor;
@@ -451,12 +489,13 @@ namespace Colibri
 	//-------------------------------------------------------------------------
 	void Widget::addListener( WidgetListener *listener )
 	{
+		WidgetListenerPairVec &listeners = getColdData().listeners;
 		WidgetListenerPairVec::iterator itor = findListener( listener );
 
-		if( itor == m_listeners.end() )
+		if( itor == listeners.end() )
 		{
-			m_listeners.push_back( listener );
-			itor = m_listeners.begin() + ptrdiff_t( m_listeners.size() - 1u );
+			listeners.push_back( listener );
+			itor = listeners.begin() + ptrdiff_t( listeners.size() - 1u );
 		}
 
 		++itor->refCount;
@@ -464,13 +503,24 @@ namespace Colibri
 	//-------------------------------------------------------------------------
 	void Widget::removeListener( WidgetListener *listener )
 	{
+		ColdData *coldData = getColdDataIfExists();
+		if( !coldData )
+		{
+			// Nothing was ever added. Don't allocate ColdData just to find out
+			LogListener	*log = m_manager->getLogListener();
+			log->log( "Widget::removeListener could not find the listener. Ignoring",
+					  LogSeverity::Warning );
+			return;
+		}
+
+		WidgetListenerPairVec &listeners = coldData->listeners;
 		WidgetListenerPairVec::iterator itor = findListener( listener );
 
-		if( itor != m_listeners.end() )
+		if( itor != listeners.end() )
 		{
 			--itor->refCount;
 			if( itor->refCount == 0 )
-				Ogre::efficientVectorRemove( m_listeners, itor );
+				Ogre::efficientVectorRemove( listeners, itor );
 		}
 		else
 		{
@@ -483,22 +533,34 @@ namespace Colibri
 	void Widget::addActionListener( WidgetActionListener *listener, uint32_t actionMask )
 	{
 		COLIBRI_ASSERT( actionMask != 0 );
-		WidgetActionListenerRecordVec::iterator itor = m_actionListeners.begin();
-		WidgetActionListenerRecordVec::iterator end  = m_actionListeners.end();
+		WidgetActionListenerRecordVec &actionListeners = getColdData().actionListeners;
+		WidgetActionListenerRecordVec::iterator itor = actionListeners.begin();
+		WidgetActionListenerRecordVec::iterator end  = actionListeners.end();
 
 		while( itor != end && itor->listener != listener )
 			++itor;
 
 		if( itor == end )
-			m_actionListeners.push_back( WidgetActionListenerRecord( actionMask, listener ) );
+			actionListeners.push_back( WidgetActionListenerRecord( actionMask, listener ) );
 		else
 			itor->actionMask |= actionMask;
 	}
 	//-------------------------------------------------------------------------
 	void Widget::removeActionListener( WidgetActionListener *listener, uint32_t actionMask )
 	{
-		WidgetActionListenerRecordVec::iterator itor = m_actionListeners.begin();
-		WidgetActionListenerRecordVec::iterator end  = m_actionListeners.end();
+		ColdData *coldData = getColdDataIfExists();
+		if( !coldData )
+		{
+			// Nothing was ever added. Don't allocate ColdData just to find out
+			LogListener	*log = m_manager->getLogListener();
+			log->log( "Widget::removeListener could not find WidgetActionListener. Ignoring",
+					  LogSeverity::Warning );
+			return;
+		}
+
+		WidgetActionListenerRecordVec &actionListeners = coldData->actionListeners;
+		WidgetActionListenerRecordVec::iterator itor = actionListeners.begin();
+		WidgetActionListenerRecordVec::iterator end  = actionListeners.end();
 
 		while( itor != end && itor->listener != listener )
 			++itor;
@@ -508,7 +570,7 @@ namespace Colibri
 			itor->actionMask &= ~actionMask;
 			//Preserve the order in which listeners were added
 			if( !itor->actionMask )
-				m_actionListeners.erase( itor );
+				actionListeners.erase( itor );
 		}
 		else
 		{
@@ -526,14 +588,18 @@ namespace Colibri
 
 		const uint32_t actionMask = 1u << action;
 
-		WidgetActionListenerRecordVec::const_iterator itor = m_actionListeners.begin();
-		WidgetActionListenerRecordVec::const_iterator end  = m_actionListeners.end();
-
-		while( itor != end )
+		if( m_coldData )
 		{
-			if( itor->actionMask & actionMask )
-				itor->listener->notifyWidgetAction( this, action );
-			++itor;
+			WidgetActionListenerRecordVec::const_iterator itor =
+				m_coldData->actionListeners.begin();
+			WidgetActionListenerRecordVec::const_iterator end = m_coldData->actionListeners.end();
+
+			while( itor != end )
+			{
+				if( itor->actionMask & actionMask )
+					itor->listener->notifyWidgetAction( this, action );
+				++itor;
+			}
 		}
 
 		if( action == Action::PrimaryActionPerform || action == Action::ValueChanged )
@@ -637,31 +703,40 @@ namespace Colibri
 	//-------------------------------------------------------------------------
 	float Widget::getRight() const
 	{
-		return m_position.x + m_size.x;
+		return _position().x + _size().x;
 	}
 	//-------------------------------------------------------------------------
 	float Widget::getBottom() const
 	{
-		return m_position.y + m_size.y;
+		return _position().y + _size().y;
 	}
 	//-------------------------------------------------------------------------
 	bool Widget::intersectsChild( Widget *child, const Ogre::Vector2 &currentScroll ) const
 	{
 		COLIBRI_ASSERT( this == child->m_parent );
-		return !( 0.0f > child->m_position.x - currentScroll.x + child->m_size.x	||
-				  0.0f > child->m_position.y - currentScroll.y + child->m_size.y	||
-				  this->m_size.x < child->m_position.x - currentScroll.x			||
-				  this->m_size.y < child->m_position.y - currentScroll.y );
+		return !( 0.0f > child->_position().x - currentScroll.x + child->_size().x	||
+				  0.0f > child->_position().y - currentScroll.y + child->_size().y	||
+				  this->_size().x < child->_position().x - currentScroll.x			||
+				  this->_size().y < child->_position().y - currentScroll.y );
 	}
 	//-------------------------------------------------------------------------
 	bool Widget::intersects( const Ogre::Vector2 &posNdc ) const
 	{
-		COLIBRI_ASSERT_MEDIUM( !m_transformOutOfDate );
+		COLIBRI_ASSERT_MEDIUM( !m_transformStore->m_transformOutOfDate[m_transformId] );
+		TODO_account_rotation;
+		return !( posNdc.x < _derivedTopLeft().x ||
+				  posNdc.y < _derivedTopLeft().y ||
+				  posNdc.x > _derivedBottomRight().x ||
+				  posNdc.y > _derivedBottomRight().y );
+	}
+	//-------------------------------------------------------------------------
+	bool Widget::overlapsWith( const Widget *other ) const
+	{
 		TODO_account_rotation;
-		return !( posNdc.x < m_derivedTopLeft.x ||
-				  posNdc.y < m_derivedTopLeft.y ||
-				  posNdc.x > m_derivedBottomRight.x ||
-				  posNdc.y > m_derivedBottomRight.y );
+		return !( other->_derivedTopLeft().x >= _derivedBottomRight().x ||
+				  other->_derivedTopLeft().y >= _derivedBottomRight().y ||
+				  other->_derivedBottomRight().x <= _derivedTopLeft().x ||
+				  other->_derivedBottomRight().y <= _derivedTopLeft().y );
 	}
 	//-------------------------------------------------------------------------
 	FocusPair Widget::_setIdleCursorMoved( const Ogre::Vector2 &newPosNdc )
@@ -740,26 +815,6 @@ namespace Colibri
 		}
 	}
 	//-------------------------------------------------------------------------
-	void Widget::_updateDerivedTransformOnly( const Ogre::Vector2 &parentPos,
-											  const Matrix2x3 &parentRot )
-	{
-		updateDerivedTransform( parentPos, parentRot );
-
-		const Ogre::Vector2 invCanvasSize2x	= m_manager->getInvCanvasSize2x();
-		const Ogre::Vector2 outerTopLeft	= this->m_derivedTopLeft;
-		const Ogre::Vector2 outerTopLeftWithClipping = outerTopLeft + m_clipBorderTL * invCanvasSize2x;
-
-		const Matrix2x3 &finalRot = this->m_derivedOrientation;
-		WidgetVec::const_iterator itor = m_children.begin();
-		WidgetVec::const_iterator end  = m_children.end();
-
-		while( itor != end )
-		{
-			(*itor)->_updateDerivedTransformOnly( outerTopLeftWithClipping, finalRot );
-			++itor;
-		}
-	}
-	//-------------------------------------------------------------------------
 	void Widget::_fillBuffersAndCommands( UiVertex ** RESTRICT_ALIAS vertexBuffer,
 										  GlyphVertex ** RESTRICT_ALIAS textVertBuffer,
 										  const Ogre::Vector2 &parentPos,
@@ -768,30 +823,31 @@ namespace Colibri
 	{
 		updateDerivedTransform( parentPos, parentRot );
 
-		m_culled = true;
+		_culled() = true;
 
-		if( !m_parent->intersectsChild( this, parentCurrentScrollPos ) || m_hidden )
+		if( !m_parent->intersectsChild( this, parentCurrentScrollPos ) || m_hidden ||
+			m_manager->_isOccluded( _derivedTopLeft(), _derivedBottomRight() ) )
 			return;
 
-		m_culled = false;
+		_culled() = false;
 
 		Ogre::Vector2 invCanvasSize2x = m_manager->getInvCanvasSize2x();
 
-		Ogre::Vector2 parentDerivedTL = m_parent->m_derivedTopLeft +
+		Ogre::Vector2 parentDerivedTL = m_parent->_derivedTopLeft() +
 										m_parent->m_clipBorderTL * invCanvasSize2x;
-		Ogre::Vector2 parentDerivedBR = m_parent->m_derivedBottomRight -
+		Ogre::Vector2 parentDerivedBR = m_parent->_derivedBottomRight() -
 										m_parent->m_clipBorderBR * invCanvasSize2x;
 
-		parentDerivedTL.makeCeil( m_parent->m_accumMinClipTL );
-		parentDerivedBR.makeFloor( m_parent->m_accumMaxClipBR );
-		m_accumMinClipTL = parentDerivedTL;
-		m_accumMaxClipBR = parentDerivedBR;
+		parentDerivedTL.makeCeil( m_parent->_accumMinClipTL() );
+		parentDerivedBR.makeFloor( m_parent->_accumMaxClipBR() );
+		_accumMinClipTL() = parentDerivedTL;
+		_accumMaxClipBR() = parentDerivedBR;
 
 		WidgetVec::const_iterator itor = m_children.begin();
 		WidgetVec::const_iterator end  = m_children.end();
 
 		const Ogre::Vector2 currentScrollPos = Ogre::Vector2::ZERO /*getCurrentScroll()*/;
-		const Ogre::Vector2 outerTopLeft = this->m_derivedTopLeft;
+		const Ogre::Vector2 outerTopLeft = this->_derivedTopLeft();
 		const Ogre::Vector2 outerTopLeftWithClipping = outerTopLeft +
 													   (m_clipBorderTL - currentScrollPos) *
 													   invCanvasSize2x;
@@ -800,7 +856,7 @@ namespace Colibri
 		{
 			(*itor)->_fillBuffersAndCommands( vertexBuffer, textVertBuffer,
 											  outerTopLeftWithClipping, currentScrollPos,
-											  m_derivedOrientation );
+											  _derivedOrientation() );
 			++itor;
 		}
 	}
@@ -808,7 +864,7 @@ namespace Colibri
 	void Widget::addNonRenderableCommands( ApiEncapsulatedObjects &apiObject,
 										   bool collectingBreadthFirst )
 	{
-		if( m_culled )
+		if( _culled() )
 			return;
 
 		addChildrenCommands( apiObject, collectingBreadthFirst );
@@ -827,6 +883,12 @@ namespace Colibri
 				++itor;
 			}
 
+			if( m_reorderChildrenForBatching )
+			{
+				addChildrenCommandsReordered( apiObject );
+				return;
+			}
+
 			itor = m_children.begin() + ptrdiff_t( m_numNonRenderables );
 			endt = m_children.end();
 
@@ -887,6 +949,98 @@ namespace Colibri
 		}
 	}
 	//-------------------------------------------------------------------------
+	const size_t Widget::c_maxReorderedSiblings = 256u;
+	//-------------------------------------------------------------------------
+	void Widget::addChildrenCommandsReordered( ApiEncapsulatedObjects &apiObject )
+	{
+		// Culled children produce no draws. They don't take part.
+		Renderable *siblingsBuffer[64];
+		std::vector<Renderable *> siblingsVec;
+		Renderable **siblings = siblingsBuffer;
+
+		const size_t numRenderables = m_children.size() - m_numNonRenderables;
+		if( numRenderables > sizeof( siblingsBuffer ) / sizeof( siblingsBuffer[0] ) )
+		{
+			siblingsVec.resize( numRenderables );
+			siblings = &siblingsVec[0];
+		}
+
+		size_t numSiblings = 0u;
+		{
+			WidgetVec::const_iterator itor = m_children.begin() + ptrdiff_t( m_numNonRenderables );
+			WidgetVec::const_iterator endt = m_children.end();
+
+			while( itor != endt )
+			{
+				COLIBRI_ASSERT_HIGH( dynamic_cast<Renderable *>( *itor ) );
+				if( !( *itor )->_culled() )
+					siblings[numSiblings++] = static_cast<Renderable *>( *itor );
+				++itor;
+			}
+		}
+
+		if( numSiblings <= 2u || numSiblings > c_maxReorderedSiblings )
+		{
+			for( size_t i = 0u; i < numSiblings; ++i )
+				siblings[i]->_addCommands( apiObject, false );
+			return;
+		}
+
+		// numBlockers[i] = Number of siblings before i (in tree order) that overlap
+		// with i and haven't been drawn yet. i can only be drawn when it reaches 0.
+		uint16_t numBlockers[c_maxReorderedSiblings];
+		memset( numBlockers, 0, sizeof( numBlockers[0] ) * numSiblings );
+		for( size_t i = 0u; i < numSiblings; ++i )
+		{
+			for( size_t j = i + 1u; j < numSiblings; ++j )
+			{
+				if( siblings[i]->overlapsWith( siblings[j] ) )
+					++numBlockers[j];
+			}
+		}
+
+		uint32_t lastHash = siblings[0]->getHlmsHash();
+		const Ogre::HlmsDatablock *lastDatablock = siblings[0]->getDatablock();
+
+		for( size_t numDrawn = 0u; numDrawn < numSiblings; ++numDrawn )
+		{
+			// Pick the first ready sibling that matches what we drew last.
+			// Otherwise the first ready sibling.
+			size_t firstReady = numSiblings;
+			size_t pick = numSiblings;
+			for( size_t i = 0u; i < numSiblings && pick == numSiblings; ++i )
+			{
+				if( siblings[i] && numBlockers[i] == 0u )
+				{
+					if( firstReady == numSiblings )
+						firstReady = i;
+					if( siblings[i]->getHlmsHash() == lastHash &&
+						siblings[i]->getDatablock() == lastDatablock )
+					{
+						pick = i;
+					}
+				}
+			}
+
+			if( pick == numSiblings )
+				pick = firstReady;
+
+			COLIBRI_ASSERT_MEDIUM( pick < numSiblings );
+
+			Renderable *renderable = siblings[pick];
+			renderable->_addCommands( apiObject, false );
+			lastHash = renderable->getHlmsHash();
+			lastDatablock = renderable->getDatablock();
+			siblings[pick] = 0;
+
+			for( size_t j = pick + 1u; j < numSiblings; ++j )
+			{
+				if( siblings[j] && renderable->overlapsWith( siblings[j] ) )
+					--numBlockers[j];
+			}
+		}
+	}
+	//-------------------------------------------------------------------------
 	bool Widget::isUltimatelyBreadthFirst() const
 	{
 		bool isBreadthFirst = m_breadthFirst;
@@ -968,7 +1122,7 @@ namespace Colibri
 	void Widget::setTransformDirty( uint32_t dirtyReason )
 	{
 #if COLIBRIGUI_DEBUG >= COLIBRIGUI_DEBUG_MEDIUM
-		m_transformOutOfDate = true;
+		m_transformStore->m_transformOutOfDate[m_transformId] = 1u;
 #endif
 		WidgetVec::const_iterator itor = m_children.begin();
 		WidgetVec::const_iterator end  = m_children.end();
@@ -990,16 +1144,16 @@ namespace Colibri
 	void Widget::setTransform( const Ogre::Vector2 &topLeft, const Ogre::Vector2 &size,
 							   const Ogre::Vector4 &orientation )
 	{
-		m_position = topLeft;
-		m_size = size;
-		m_orientation = orientation;
+		_position() = topLeft;
+		_size() = size;
+		_orientation() = orientation;
 		setTransformDirty( TransformDirtyAll );
 	}
 	//-------------------------------------------------------------------------
 	void Widget::setTransform( const Ogre::Vector2 &topLeft, const Ogre::Vector2 &size )
 	{
-		m_position = topLeft;
-		m_size = size;
+		_position() = topLeft;
+		_size() = size;
 		setTransformDirty( TransformDirtyPosition | TransformDirtyScale );
 	}
 	//-------------------------------------------------------------------------
@@ -1084,40 +1238,40 @@ namespace Colibri
 	//-------------------------------------------------------------------------
 	void Widget::setTopLeft( const Ogre::Vector2 &topLeft )
 	{
-		m_position = topLeft;
+		_position() = topLeft;
 		setTransformDirty( TransformDirtyPosition );
 	}
 	//-------------------------------------------------------------------------
 	void Widget::setSize( const Ogre::Vector2 &size )
 	{
-		m_size = size;
+		_size() = size;
 		setTransformDirty( TransformDirtyScale );
 	}
 	//-------------------------------------------------------------------------
 	void Widget::setOrientation( const Ogre::Vector4 &orientation )
 	{
-		m_orientation = orientation;
+		_orientation() = orientation;
 		setTransformDirty( TransformDirtyOrientation );
 	}
 	//-------------------------------------------------------------------------
 	void Widget::setOrientation( const Ogre::Radian rotationAngle )
 	{
 		const float valueRadians = rotationAngle.valueRadians();
-		m_orientation.x = std::cos( valueRadians );
-		m_orientation.z = std::sin( valueRadians );
-		m_orientation.y = -m_orientation.z;
-		m_orientation.w = m_orientation.x;
+		_orientation().x = std::cos( valueRadians );
+		_orientation().z = std::sin( valueRadians );
+		_orientation().y = -_orientation().z;
+		_orientation().w = _orientation().x;
 		setTransformDirty( TransformDirtyOrientation );
 	}
 	//-------------------------------------------------------------------------
 	void Widget::setCenter( const Ogre::Vector2 &center )
 	{
-		setTopLeft( center - this->m_size * 0.5f );
+		setTopLeft( center - this->_size() * 0.5f );
 	}
 	//-------------------------------------------------------------------------
 	Ogre::Vector2 Widget::getCenter() const
 	{
-		return m_position + this->m_size * 0.5f;
+		return _position() + this->_size() * 0.5f;
 	}
 	//-------------------------------------------------------------------------
 	void Widget::setCenterIgnoringBorder( const Ogre::Vector2 &center )
@@ -1127,7 +1281,7 @@ namespace Colibri
 	//-------------------------------------------------------------------------
 	Ogre::Vector2 Widget::getCenterIgnoringBorder() const
 	{
-		return m_position + this->m_clipBorderTL + this->getSizeAfterClipping() * 0.5f;
+		return _position() + this->m_clipBorderTL + this->getSizeAfterClipping() * 0.5f;
 	}
 	//-------------------------------------------------------------------------
 	void Widget::setClipBorders( float clipBorders[Borders::NumBorders] )
@@ -1141,18 +1295,26 @@ namespace Colibri
 			m_clipBorderTL.y = clipBorders[Borders::Top];
 			m_clipBorderBR.x = clipBorders[Borders::Right];
 			m_clipBorderBR.y = clipBorders[Borders::Bottom];
+			syncTransformClipping();
 			scheduleSetTransformDirty();
 		}
 	}
 	//-------------------------------------------------------------------------
+	void Widget::syncTransformClipping()
+	{
+		m_transformStore->m_clipBorderTL[m_transformId] = m_clipBorderTL;
+		m_transformStore->m_clipBorderBR[m_transformId] = m_clipBorderBR;
+		m_transformStore->m_currentScroll[m_transformId] = getCurrentScroll();
+	}
+	//-------------------------------------------------------------------------
 	Ogre::Vector2 Widget::getTopLeftAfterClipping() const
 	{
-		return m_position + m_clipBorderTL;
+		return _position() + m_clipBorderTL;
 	}
 	//-------------------------------------------------------------------------
 	Ogre::Vector2 Widget::getBottomRightAfterClipping() const
 	{
-		return m_position + m_size - m_clipBorderBR;
+		return _position() + _size() - m_clipBorderBR;
 	}
 	//-------------------------------------------------------------------------
 	void Widget::setSizeAfterClipping( const Ogre::Vector2 &size )
@@ -1162,7 +1324,7 @@ namespace Colibri
 	//-------------------------------------------------------------------------
 	Ogre::Vector2 Widget::getSizeAfterClipping() const
 	{
-		return m_size - (m_clipBorderTL + m_clipBorderBR);
+		return _size() - (m_clipBorderTL + m_clipBorderBR);
 	}
 	//-------------------------------------------------------------------------
 	void Widget::updateDerivedTransformFromParent( bool updateParent )
@@ -1174,9 +1336,9 @@ namespace Colibri
 
 			Ogre::Vector2 currentScroll = m_parent->getCurrentScroll();
 			const Ogre::Vector2 &invCanvasSize2x = m_manager->getInvCanvasSize2x();
-			updateDerivedTransform( m_parent->m_derivedTopLeft +
+			updateDerivedTransform( m_parent->_derivedTopLeft() +
 									(m_parent->m_clipBorderTL - currentScroll) * invCanvasSize2x,
-									m_parent->m_derivedOrientation );
+									m_parent->_derivedOrientation() );
 		}
 		else
 		{
@@ -1234,30 +1396,42 @@ namespace Colibri
 		}
 	}
 	//-------------------------------------------------------------------------
+	void Widget::_notifySkinsChanged()
+	{
+		WidgetVec::const_iterator itor = m_children.begin();
+		WidgetVec::const_iterator end  = m_children.end();
+
+		while( itor != end )
+		{
+			(*itor)->_notifySkinsChanged();
+			++itor;
+		}
+	}
+	//-------------------------------------------------------------------------
 	ColibriManager *Widget::getManager() { return m_manager; }
 	//-------------------------------------------------------------------------
-	const Ogre::Vector2& Widget::getDerivedTopLeft() const
+	Ogre::Vector2 Widget::getDerivedTopLeft() const
 	{
-		COLIBRI_ASSERT_MEDIUM( !m_transformOutOfDate );
-		return m_derivedTopLeft;
+		COLIBRI_ASSERT_MEDIUM( !m_transformStore->m_transformOutOfDate[m_transformId] );
+		return _derivedTopLeft();
 	}
 	//-------------------------------------------------------------------------
-	const Ogre::Vector2& Widget::getDerivedBottomRight() const
+	Ogre::Vector2 Widget::getDerivedBottomRight() const
 	{
-		COLIBRI_ASSERT_MEDIUM( !m_transformOutOfDate );
-		return m_derivedBottomRight;
+		COLIBRI_ASSERT_MEDIUM( !m_transformStore->m_transformOutOfDate[m_transformId] );
+		return _derivedBottomRight();
 	}
 	//-------------------------------------------------------------------------
-	const Matrix2x3 &Widget::getDerivedOrientation() const
+	Matrix2x3 Widget::getDerivedOrientation() const
 	{
-		COLIBRI_ASSERT_MEDIUM( !m_transformOutOfDate );
-		return m_derivedOrientation;
+		COLIBRI_ASSERT_MEDIUM( !m_transformStore->m_transformOutOfDate[m_transformId] );
+		return _derivedOrientation();
 	}
 	//-------------------------------------------------------------------------
 	Ogre::Vector2 Widget::getDerivedCenter() const
 	{
-		COLIBRI_ASSERT_MEDIUM( !m_transformOutOfDate );
-		return (m_derivedTopLeft + m_derivedBottomRight) * 0.5f;
+		COLIBRI_ASSERT_MEDIUM( !m_transformStore->m_transformOutOfDate[m_transformId] );
+		return (_derivedTopLeft() + _derivedBottomRight()) * 0.5f;
 	}
 	//-------------------------------------------------------------------------
 	Ogre::Vector2 Widget::calculateChildrenSize() const
@@ -1296,7 +1470,7 @@ namespace Colibri
 	//-------------------------------------------------------------------------
 	Ogre::Vector2 Widget::getCellSize() const
 	{
-		return m_size;
+		return _size();
 	}
 	//-------------------------------------------------------------------------
 	Ogre::Vector2 Widget::getCellMinSize() const
@@ -0,0 +1,230 @@
+#include "ColibriGui/ColibriWidgetTransformStore.h"
+
+#include "ColibriGui/ColibriWidget.h"
+
+#include <algorithm>
+
+namespace Colibri
+{
+	const Matrix2x3 Matrix2x3::IDENTITY( 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f );
+
+	/// Rearranges inOutValues so that inOutValues[i] = oldValues[newToOld[i]]
+	template <typename T>
+	static void applyNewOrder( std::vector<T> &inOutValues, const std::vector<uint32_t> &newToOld )
+	{
+		std::vector<T> sorted;
+		sorted.reserve( newToOld.size() );
+		for( const uint32_t oldIdx : newToOld )
+			sorted.push_back( inOutValues[oldIdx] );
+		inOutValues.swap( sorted );
+	}
+
+	WidgetTransformStore::WidgetTransformStore() : m_orderDirty( false ) {}
+	//-------------------------------------------------------------------------
+	uint32_t WidgetTransformStore::createSlot( Widget *owner )
+	{
+		const uint32_t transformId = static_cast<uint32_t>( m_owner.size() );
+
+		m_owner.push_back( owner );
+		m_parentId.push_back( c_noParent );
+		m_position.push_back( Ogre::Vector2::ZERO );
+		m_size.push_back( Ogre::Vector2::ZERO );
+		m_orientation.push_back( Ogre::Vector4( 1.0f, 0.0f,  //
+												0.0f, 1.0f ) );
+		m_clipBorderTL.push_back( Ogre::Vector2::ZERO );
+		m_clipBorderBR.push_back( Ogre::Vector2::ZERO );
+		m_currentScroll.push_back( Ogre::Vector2::ZERO );
+		m_derivedTopLeft.push_back( Ogre::Vector2::ZERO );
+		m_derivedBottomRight.push_back( Ogre::Vector2::ZERO );
+		m_derivedOrientation.push_back( Matrix2x3::IDENTITY );
+		m_accumMinClipTL.push_back( Ogre::Vector2( -1.0f ) );
+		m_accumMaxClipBR.push_back( Ogre::Vector2( 1.0f ) );
+		m_culled.push_back( 0u );
+#if COLIBRIGUI_DEBUG >= COLIBRIGUI_DEBUG_MEDIUM
+		m_transformOutOfDate.push_back( 0u );
+#endif
+
+		return transformId;
+	}
+	//-------------------------------------------------------------------------
+	void WidgetTransformStore::destroySlot( uint32_t transformId )
+	{
+		COLIBRI_ASSERT_LOW( transformId < m_owner.size() );
+		m_owner[transformId] = 0;
+		m_parentId[transformId] = c_noParent;
+		m_orderDirty = true;
+	}
+	//-------------------------------------------------------------------------
+	void WidgetTransformStore::setParent( uint32_t transformId, uint32_t parentId )
+	{
+		COLIBRI_ASSERT_LOW( transformId < m_owner.size() );
+		COLIBRI_ASSERT_LOW( parentId == c_noParent || parentId < m_owner.size() );
+		m_parentId[transformId] = parentId;
+		// A Window attached to a Window that was created after it
+		if( parentId != c_noParent && parentId > transformId )
+			m_orderDirty = true;
+	}
+	//-------------------------------------------------------------------------
+	void WidgetTransformStore::reorder()
+	{
+		const size_t numSlots = m_owner.size();
+
+		// Calculate the depth of every live slot. Walk up until we find a parent whose
+		// depth we already know (or a root), then assign the depths on the way back.
+		std::vector<uint32_t> depths( numSlots, c_noParent );
+		std::vector<uint32_t> chain;
+		uint32_t maxDepth = 0u;
+		size_t numLiveSlots = 0u;
+
+		for( size_t i = 0u; i < numSlots; ++i )
+		{
+			if( !m_owner[i] )
+				continue;
+
+			uint32_t slot = static_cast<uint32_t>( i );
+			while( depths[slot] == c_noParent && m_parentId[slot] != c_noParent )
+			{
+				chain.push_back( slot );
+				slot = m_parentId[slot];
+			}
+
+			if( depths[slot] == c_noParent )
+				depths[slot] = 0u;
+
+			uint32_t depth = depths[slot];
+			while( !chain.empty() )
+			{
+				++depth;
+				depths[chain.back()] = depth;
+				chain.pop_back();
+			}
+
+			maxDepth = std::max( maxDepth, depth );
+			++numLiveSlots;
+		}
+
+		// Counting sort by depth. It's stable, thus siblings keep their creation order
+		std::vector<uint32_t> depthStart( maxDepth + 2u, 0u );
+		for( size_t i = 0u; i < numSlots; ++i )
+		{
+			if( m_owner[i] )
+				++depthStart[depths[i] + 1u];
+		}
+		for( size_t i = 1u; i < depthStart.size(); ++i )
+			depthStart[i] += depthStart[i - 1u];
+
+		std::vector<uint32_t> newToOld( numLiveSlots );
+		std::vector<uint32_t> oldToNew( numSlots, c_noParent );
+		for( size_t i = 0u; i < numSlots; ++i )
+		{
+			if( m_owner[i] )
+			{
+				const uint32_t newIdx = depthStart[depths[i]]++;
+				newToOld[newIdx] = static_cast<uint32_t>( i );
+				oldToNew[i] = newIdx;
+			}
+		}
+
+		applyNewOrder( m_owner, newToOld );
+		applyNewOrder( m_parentId, newToOld );
+		applyNewOrder( m_position, newToOld );
+		applyNewOrder( m_size, newToOld );
+		applyNewOrder( m_orientation, newToOld );
+		applyNewOrder( m_clipBorderTL, newToOld );
+		applyNewOrder( m_clipBorderBR, newToOld );
+		applyNewOrder( m_currentScroll, newToOld );
+		applyNewOrder( m_derivedTopLeft, newToOld );
+		applyNewOrder( m_derivedBottomRight, newToOld );
+		applyNewOrder( m_derivedOrientation, newToOld );
+		applyNewOrder( m_accumMinClipTL, newToOld );
+		applyNewOrder( m_accumMaxClipBR, newToOld );
+		applyNewOrder( m_culled, newToOld );
+#if COLIBRIGUI_DEBUG >= COLIBRIGUI_DEBUG_MEDIUM
+		applyNewOrder( m_transformOutOfDate, newToOld );
+#endif
+
+		for( size_t i = 0u; i < numLiveSlots; ++i )
+		{
+			if( m_parentId[i] != c_noParent )
+				m_parentId[i] = oldToNew[m_parentId[i]];
+			m_owner[i]->m_transformId = static_cast<uint32_t>( i );
+			COLIBRI_ASSERT_MEDIUM( m_parentId[i] == c_noParent || m_parentId[i] < i );
+		}
+
+		m_orderDirty = false;
+	}
+	//-------------------------------------------------------------------------
+	void WidgetTransformStore::updateDerivedTransform( uint32_t transformId,
+													   const Ogre::Vector2 &parentPos,
+													   const Matrix2x3 &parentRot,
+													   const Ogre::Vector2 &invCanvasSize2x,
+													   float invCanvasAr )
+	{
+		const Ogre::Vector4 orientation = m_orientation[transformId];
+
+		const Ogre::Vector2 derivedTopLeft = parentPos + m_position[transformId] * invCanvasSize2x;
+		const Ogre::Vector2 derivedBottomRight =
+			derivedTopLeft + m_size[transformId] * invCanvasSize2x;
+
+		Ogre::Vector2 ndcCenter = ( derivedTopLeft + derivedBottomRight ) * 0.5f;
+		ndcCenter.y *= invCanvasAr;
+		const Ogre::Vector2 rotatedNdcCenter = Widget::mul( orientation, ndcCenter );
+
+		const Ogre::Vector2 centerDiff = ( ndcCenter - rotatedNdcCenter );
+
+		const Matrix2x3 localOrientation( orientation.x, orientation.y, centerDiff.x,  //
+										  orientation.z, orientation.w, centerDiff.y );
+
+		m_derivedTopLeft[transformId] = derivedTopLeft;
+		m_derivedBottomRight[transformId] = derivedBottomRight;
+		m_derivedOrientation[transformId] = Widget::mul( parentRot, localOrientation );
+
+#if COLIBRIGUI_DEBUG >= COLIBRIGUI_DEBUG_MEDIUM
+		m_transformOutOfDate[transformId] = 0u;
+#endif
+	}
+	//-------------------------------------------------------------------------
+	void WidgetTransformStore::updateAllDerivedTransforms( const Ogre::Vector2 &invCanvasSize2x,
+														   float invCanvasAr )
+	{
+		if( m_orderDirty )
+			reorder();
+
+		const size_t numSlots = m_owner.size();
+		for( size_t i = 0u; i < numSlots; ++i )
+		{
+			const uint32_t transformId = static_cast<uint32_t>( i );
+			const uint32_t parentId = m_parentId[i];
+
+			if( parentId == c_noParent )
+			{
+				updateDerivedTransform( transformId, -Ogre::Vector2::UNIT_SCALE, Matrix2x3::IDENTITY,
+										invCanvasSize2x, invCanvasAr );
+				m_accumMinClipTL[i] = -1.0f;
+				m_accumMaxClipBR[i] = 1.0f;
+			}
+			else
+			{
+				COLIBRI_ASSERT_HIGH( parentId < transformId );
+
+				const Ogre::Vector2 parentTopLeft = m_derivedTopLeft[parentId];
+				const Ogre::Vector2 parentBottomRight = m_derivedBottomRight[parentId];
+
+				const Ogre::Vector2 childrenTopLeft =
+					parentTopLeft +
+					( m_clipBorderTL[parentId] - m_currentScroll[parentId] ) * invCanvasSize2x;
+				updateDerivedTransform( transformId, childrenTopLeft, m_derivedOrientation[parentId],
+										invCanvasSize2x, invCanvasAr );
+
+				Ogre::Vector2 accumMinClipTL =
+					parentTopLeft + m_clipBorderTL[parentId] * invCanvasSize2x;
+				Ogre::Vector2 accumMaxClipBR =
+					parentBottomRight - m_clipBorderBR[parentId] * invCanvasSize2x;
+				accumMinClipTL.makeCeil( m_accumMinClipTL[parentId] );
+				accumMaxClipBR.makeFloor( m_accumMaxClipBR[parentId] );
+				m_accumMinClipTL[i] = accumMinClipTL;
+				m_accumMaxClipBR[i] = accumMaxClipBR;
+			}
+		}
+	}
+}  // namespace Colibri
@@ -19,7 +19,8 @@ namespace Colibri
 		m_lastPrimaryAction( std::numeric_limits<uint16_t>::max() ),
 		m_widgetNavigationDirty( false ),
 		m_windowNavigationDirty( false ),
-		m_childrenNavigationDirty( false )
+		m_childrenNavigationDirty( false ),
+		m_opaque( false )
 	{
 		memset( m_arrows, 0, sizeof( m_arrows ) );
 		memset( m_scrollArrowsVisibility, 0, sizeof( m_scrollArrowsVisibility ) );
@@ -148,7 +149,7 @@ namespace Colibri
 			createScrollArrow( border );
 		}
 
-		m_arrows[border]->setCenter( m_size * m_scrollArrowProportion[border] );
+		m_arrows[border]->setCenter( _size() * m_scrollArrowProportion[border] );
 		const Ogre::Vector2 arrowTopLeft = m_arrows[border]->getLocalTopLeft();
 
 		// Whether the arrow is shown depends on current scroll.
@@ -280,17 +281,18 @@ namespace Colibri
 		m_currentScroll.makeFloor( maxScroll );
 		m_currentScroll.makeCeil( Ogre::Vector2::ZERO );
 		m_nextScroll = m_currentScroll;
+		syncTransformClipping();
 	}
 	//-------------------------------------------------------------------------
 	void Window::setMaxScroll( const Ogre::Vector2 &maxScroll )
 	{
 		COLIBRI_ASSERT_LOW( maxScroll.x >= 0 && maxScroll.y >= 0 );
-		m_scrollableArea = maxScroll - m_clipBorderBR - m_clipBorderTL + m_size;
+		m_scrollableArea = maxScroll - m_clipBorderBR - m_clipBorderTL + _size();
 	}
 	//-------------------------------------------------------------------------
 	Ogre::Vector2 Window::getMaxScroll() const
 	{
-		Ogre::Vector2 maxScroll = m_scrollableArea - m_size + m_clipBorderTL + m_clipBorderBR;
+		Ogre::Vector2 maxScroll = m_scrollableArea - _size() + m_clipBorderTL + m_clipBorderBR;
 		maxScroll.makeCeil( Ogre::Vector2::ZERO );
 		return maxScroll;
 	}
@@ -370,6 +372,7 @@ namespace Colibri
 		{
 			m_currentScroll = m_nextScroll;
 		}
+		syncTransformClipping();
 
 		for( size_t i = 0u; i < Borders::NumBorders; ++i )
 			evaluateScrollArrowVisibility( static_cast<Borders::Borders>( i ) );
@@ -479,6 +482,7 @@ namespace Colibri
 		{
 			m_childWindows.erase( itor );
 			window->m_parent = 0;
+			m_transformStore->setParent( window->m_transformId, WidgetTransformStore::c_noParent );
 
 			WidgetVec::iterator itWidget =
 				std::find( m_children.begin() + ptrdiff_t( m_numWidgets ), m_children.end(), window );
@@ -559,27 +563,6 @@ namespace Colibri
 		return retVal;
 	}
 	//-------------------------------------------------------------------------
-	void Window::_updateDerivedTransformOnly( const Ogre::Vector2 &parentPos,
-											  const Matrix2x3 &parentRot )
-	{
-		updateDerivedTransform( parentPos, parentRot );
-
-		const Ogre::Vector2 invCanvasSize2x = m_manager->getInvCanvasSize2x();
-		const Ogre::Vector2 outerTopLeft = this->m_derivedTopLeft;
-		const Ogre::Vector2 outerTopLeftWithClipping =
-			outerTopLeft + ( m_clipBorderTL - m_currentScroll ) * invCanvasSize2x;
-
-		const Matrix2x3 &finalRot = this->m_derivedOrientation;
-		WidgetVec::const_iterator itor = m_children.begin();
-		WidgetVec::const_iterator end = m_children.end();
-
-		while( itor != end )
-		{
-			( *itor )->_updateDerivedTransformOnly( outerTopLeftWithClipping, finalRot );
-			++itor;
-		}
-	}
-	//-------------------------------------------------------------------------
 	void Window::_fillBuffersAndCommands( UiVertex **RESTRICT_ALIAS vertexBuffer,
 										  GlyphVertex **RESTRICT_ALIAS textVertBuffer,
 										  const Ogre::Vector2 &parentPos,
@@ -135,8 +135,7 @@ namespace Ogre
 		return indexBuffer;
 	}*/
 	//-----------------------------------------------------------------------------------
-	VertexArrayObject *ColibriOgreRenderable::createVao( uint32 vertexCount, VaoManager *vaoManager,
-														 const bool bMultiPass )
+	VertexArrayObject *ColibriOgreRenderable::createVao( uint32 vertexCount, VaoManager *vaoManager )
 	{
 		// Vertex declaration
 		VertexElement2Vec vertexElements;
@@ -148,8 +147,8 @@ namespace Ogre
 
 		// Create the actual vertex buffer.
 		Ogre::VertexBufferPacked *vertexBuffer = 0;
-		vertexBuffer = vaoManager->createVertexBuffer(
-			vertexElements, vertexCount, bMultiPass ? BT_DEFAULT : BT_DYNAMIC_PERSISTENT, 0, false );
+		vertexBuffer = vaoManager->createVertexBuffer( vertexElements, vertexCount,
+													   BT_DYNAMIC_PERSISTENT, 0, false );
 
 		VertexBufferPackedVec vertexBuffers;
 		vertexBuffers.push_back( vertexBuffer );
@@ -159,8 +158,8 @@ namespace Ogre
 		return vao;
 	}
 	//-----------------------------------------------------------------------------------
-	VertexArrayObject *ColibriOgreRenderable::createTextVao( uint32 vertexCount, VaoManager *vaoManager,
-															 const bool bMultiPass )
+	VertexArrayObject *ColibriOgreRenderable::createTextVao( uint32 vertexCount,
+															 VaoManager *vaoManager )
 	{
 		// Vertex declaration
 		VertexElement2Vec vertexElements;
@@ -173,9 +172,8 @@ namespace Ogre
 
 		// Create the actual vertex buffer.
 		Ogre::VertexBufferPacked *vertexBuffer = 0;
-		vertexBuffer = vaoManager->createVertexBuffer(
-			vertexElements, vertexCount, bMultiPass ? Ogre::BT_DEFAULT : Ogre::BT_DYNAMIC_PERSISTENT, 0,
-			false );
+		vertexBuffer = vaoManager->createVertexBuffer( vertexElements, vertexCount,
+													   Ogre::BT_DYNAMIC_PERSISTENT, 0, false );
 
 		VertexBufferPackedVec vertexBuffers;
 		vertexBuffers.push_back( vertexBuffer );
@@ -76,7 +76,8 @@ namespace Ogre
 		// Fire the listener in case it wants to change anything
 		notifyPassPreExecuteListeners();
 
-		m_colibriManager->prepareRenderCommands();
+		if( !mDefinition->mReuseFill || !m_colibriManager->isLastFillReusable() )
+			m_colibriManager->prepareRenderCommands();
 
 		RenderSystem *renderSystem = sceneManager->getDestinationRenderSystem();
 		renderSystem->executeRenderPassDescriptorDelayedActions();
@@ -107,6 +107,16 @@ namespace Ogre
 							" line " + StringConverter::toString( prop->line ) );
 					}
 				}
+				else if( prop->name == "reuse_fill" )
+				{
+					if( prop->values.size() != 1u ||
+						!ScriptTranslatorGetBoolean( prop->values.front(),
+													 &colibriGuiDef->mReuseFill ) )
+					{
+						compiler->addError( ScriptCompiler::CE_BOOLEANEXPECTED, prop->file,
+											prop->line, "reuse_fill accepts <true|false>" );
+					}
+				}
 				else if( prop->name == "aspect_ratio_mode" )
 				{
 					bool bValid = false;
@@ -75,7 +75,8 @@ namespace Ogre
 
 	HlmsColibri::HlmsColibri( Archive *dataFolder, ArchiveVec *libraryFolders ) :
 		HlmsUnlit( dataFolder, libraryFolders ),
-		mGlyphAtlasBuffer( 0 )
+		mGlyphAtlasBuffer( 0 ),
+		mNumShaderCacheEntriesCreated( 0u )
 	{
 #if OGRE_VERSION >= OGRE_MAKE_VERSION( 4, 0, 0 )
 		mReservedTexSlots = 1u;
@@ -87,7 +88,8 @@ namespace Ogre
 	HlmsColibri::HlmsColibri( Archive *dataFolder, ArchiveVec *libraryFolders, HlmsTypes type,
 							  const String &typeName ) :
 		HlmsUnlit( dataFolder, libraryFolders, type, typeName ),
-		mGlyphAtlasBuffer( 0 )
+		mGlyphAtlasBuffer( 0 ),
+		mNumShaderCacheEntriesCreated( 0u )
 	{
 #if OGRE_VERSION >= OGRE_MAKE_VERSION( 4, 0, 0 )
 		mReservedTexSlots = 1u;
@@ -129,6 +131,8 @@ namespace Ogre
 			HlmsUnlit::createShaderCacheEntry( renderableHash, passCache, finalHash,
 											   queuedRenderable COLIBRI_STUB_ENTRY_ARG COLIBRI_TID_ARG );
 
+		++mNumShaderCacheEntriesCreated;
+
 		if( mShaderProfile != "glsl" )
 			return retVal;  // D3D embeds the texture slots in the shader.
 
@@ -142,23 +146,6 @@ namespace Ogre
 		return retVal;
 	}
 	//-----------------------------------------------------------------------------------
-	static inline const char *toPieceStr( LwString &str, const ColourValue &colourValue )
-	{
-		str.clear();
-		str.a( colourValue.r, "f, ", colourValue.g, "f, " );
-		return str.a( colourValue.b, "f, ", colourValue.a, "f" ).c_str();
-	}
-	static inline const char *toPieceStr( LwString &str, const Vector2 &value )
-	{
-		str.clear();
-		return str.a( value.x, "f, ", value.y, "f" ).c_str();
-	}
-	static inline const char *toPieceStr( LwString &str, const float value )
-	{
-		str.clear();
-		return str.a( value, "f" ).c_str();
-	}
-
 	void HlmsColibri::calculateHashForPreCreate( Renderable *renderable, PiecesMap *inOutPieces )
 	{
 		HlmsUnlit::calculateHashForPreCreate( renderable, inOutPieces );
@@ -206,33 +193,10 @@ namespace Ogre
 				COLIBRI_NOTID "ogre_version",
 				( OGRE_VERSION_MAJOR * 1000000 + OGRE_VERSION_MINOR * 1000 + OGRE_VERSION_PATCH ) );
 
+			// Only the number of datasets affects the shader. The rest of the parameters
+			// live in the chart's data texture. See GraphChart::syncChart
 			COLIBRI_ASSERT_HIGH( dynamic_cast<Colibri::GraphChart *>( renderable ) );
 			Colibri::GraphChart *graphChart = static_cast<Colibri::GraphChart *>( renderable );
-			const Colibri::GraphChart::Params &params = graphChart->getParams();
-
-			char tmpBuffer[128];
-			LwString pieceStr( LwString::FromEmptyPointer( tmpBuffer, sizeof( tmpBuffer ) ) );
-			pieceStr.clear();
-			inOutPieces[PixelShader]["colibri_graphStartTL"] =
-				toPieceStr( pieceStr, params.graphInnerTopLeft );
-			pieceStr.clear();
-			inOutPieces[PixelShader]["colibri_graphStartBR"] =
-				toPieceStr( pieceStr, params.graphInnerTopLeft + params.graphInnerSize );
-
-			const float intervalLength = 1.0f / float( params.numLines - 1u );
-			pieceStr.clear();
-			inOutPieces[PixelShader]["colibri_intervalLength"] = toPieceStr( pieceStr, intervalLength );
-
-			const float intervalBlankAreaSize = intervalLength - params.lineThickness;
-			pieceStr.clear();
-			inOutPieces[PixelShader]["colibri_intervalBlankAreaSize"] =
-				toPieceStr( pieceStr, Vector2( 0.0f, intervalBlankAreaSize ) );
-
-			inOutPieces[PixelShader]["colibri_lineColour"] = toPieceStr( pieceStr, params.lineColour );
-			inOutPieces[PixelShader]["colibri_bgInnerColour"] =
-				toPieceStr( pieceStr, params.bgInnerColour );
-			inOutPieces[PixelShader]["colibri_bgOuterColour"] =
-				toPieceStr( pieceStr, params.bgOuterColour );
 
 			const std::vector<Colibri::GraphChart::Column> &columns = graphChart->getColumns();
 			const size_t numDatasets = columns.size();
@@ -241,13 +205,6 @@ namespace Ogre
 				kNoTid,
 #endif
 				"colibri_numDatasets", static_cast<int32>( numDatasets ) );
-			for( size_t i = 0u; i < numDatasets; ++i )
-			{
-				pieceStr.clear();
-				IdString keyName( pieceStr.a( "colibri_datasetCol", (uint32)i ).c_str() );
-				inOutPieces[PixelShader][keyName] =
-					toPieceStr( pieceStr, columns[i].rectangle->getColour() );
-			}
 		}
 	}
 	//-----------------------------------------------------------------------------------
@@ -279,7 +236,8 @@ namespace Ogre
 	uint32 HlmsColibri::fillBuffersForColibri( const HlmsCache *cache,
 											   const QueuedRenderable &queuedRenderable, bool casterPass,
 											   uint32 baseVertex, uint32 lastCacheHash,
-											   CommandBuffer *commandBuffer )
+											   CommandBuffer *commandBuffer,
+											   const uint32 *textShadowData )
 	{
 		COLIBRI_ASSERT_HIGH( getProperty( cache->setProperties, HlmsBaseProp::GlobalClipPlanes ) == 0 &&
 							 "Clipping planes not supported! Generated shader may be buggy!" );
@@ -367,8 +325,11 @@ namespace Ogre
 		uint32 *RESTRICT_ALIAS currentMappedConstBuffer = mCurrentMappedConstBuffer;
 		// float * RESTRICT_ALIAS currentMappedTexBuffer       = mCurrentMappedTexBuffer;
 
+		// Text also needs its shadow, which must be in the same buffer
+		const size_t numSlots = textShadowData ? 8u : 4u;
+
 		bool exceedsConstBuffer = (size_t)( ( currentMappedConstBuffer - mStartMappedConstBuffer ) +
-											4 ) > mCurrentConstBufferSize;
+											numSlots ) > mCurrentConstBufferSize;
 
 		const size_t minimumTexBufferSize = 16;
 		bool exceedsTexBuffer = false /*(currentMappedTexBuffer - mStartMappedTexBuffer) +
@@ -400,6 +361,13 @@ namespace Ogre
 		*( currentMappedConstBuffer + 3 ) = baseVertex;
 		currentMappedConstBuffer += 4;
 
+		// Read by the vertex shader at drawId + 1
+		if( textShadowData )
+		{
+			memcpy( currentMappedConstBuffer, textShadowData, sizeof( uint32 ) * 4u );
+			currentMappedConstBuffer += 4;
+		}
+
 		//---------------------------------------------------------------------------
 		//                          ---- PIXEL SHADER ----
 		//---------------------------------------------------------------------------
@@ -449,7 +417,8 @@ namespace Ogre
 		mCurrentMappedConstBuffer = currentMappedConstBuffer;
 		// mCurrentMappedTexBuffer     = currentMappedTexBuffer;
 
-		return uint32( ( ( mCurrentMappedConstBuffer - mStartMappedConstBuffer ) >> 2u ) - 1u );
+		return uint32( ( ( mCurrentMappedConstBuffer - mStartMappedConstBuffer ) >> 2u ) -
+					   ( textShadowData ? 2u : 1u ) );
 	}
 	//-----------------------------------------------------------------------------------
 	void HlmsColibri::getDefaultPaths( String &outDataFolderPath, StringVector &outLibraryFoldersPaths )
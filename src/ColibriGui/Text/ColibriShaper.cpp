@@ -10,6 +10,7 @@
 #include "ft2build.h"
 
 #include "freetype/freetype.h"
+#include "freetype/ftsizes.h"
 
 #include "hb-ft.h"
 
@@ -61,12 +62,16 @@ namespace Colibri
 		m_ftFont( 0 ),
 		m_hbFont( 0 ),
 		m_buffer( 0 ),
+		m_currentSizeIdx( std::numeric_limits<size_t>::max() ),
+		m_sizeUsageCounter( 0u ),
 		m_library( shaperManager->getFreeTypeLibrary() ),
 		m_shaperManager( shaperManager ),
+		m_fontLocation( fontLocation ),
 		m_ptSize( 0u ),
 		m_fontIdx(
 			std::max<uint16_t>( static_cast<uint16_t>( shaperManager->getShapers().size() ), 1u ) ),
-		m_useCodepoint0ForRaster( false )
+		m_useCodepoint0ForRaster( false ),
+		m_sdfMode( false )
 	{
 #ifndef __ANDROID__
 		FT_Error errorCode = FT_New_Face( m_library, fontLocation, 0, &m_ftFont );
@@ -107,10 +112,9 @@ namespace Colibri
 			log->log( errorMsg.c_str(), LogSeverity::Fatal );
 		}
 
-		setFontSize( FontSize( 24.0f ) );
 		force_ucs2_charmap( m_ftFont );
+		setFontSize( FontSize( 24.0f ) );
 
-		m_hbFont = hb_ft_font_create( m_ftFont, NULL );
 		m_buffer = hb_buffer_create();
 
 		m_hbLanguage = hb_language_from_string( language.c_str(), static_cast<int>( language.size() ) );
@@ -119,7 +123,20 @@ namespace Colibri
 	Shaper::~Shaper()
 	{
 		hb_buffer_destroy( m_buffer );
-		hb_font_destroy( m_hbFont );
+
+		{
+			// FT_Done_Face takes care of the FT_Size objects
+			SizeEntryVec::const_iterator itor = m_sizes.begin();
+			SizeEntryVec::const_iterator endt = m_sizes.end();
+
+			while( itor != endt )
+			{
+				hb_font_destroy( itor->hbFont );
+				++itor;
+			}
+			m_sizes.clear();
+			m_hbFont = 0;
+		}
 
 		FT_Error errorCode = FT_Done_Face( m_ftFont );
 
@@ -146,33 +163,100 @@ namespace Colibri
 	//-------------------------------------------------------------------------
 	void Shaper::addFeatures( const hb_feature_t &feature ) { m_features.push_back( feature ); }
 	//-------------------------------------------------------------------------
-	void Shaper::setFontSize( FontSize ptSize )
+	size_t Shaper::createSizeEntry( FontSize ptSize, uint32_t dpi )
 	{
-		const FontSize oldSize = m_ptSize;
-		m_ptSize = ptSize;
+		size_t entryIdx = m_sizes.size();
 
-		if( oldSize != m_ptSize )
+		if( m_sizes.size() >= getMaxCachedSizes() )
 		{
-			const FT_UInt deviceHdpi = m_shaperManager->getDPI();
-			const FT_UInt deviceVdpi = m_shaperManager->getDPI();
-			FT_Error errorCode =
-				FT_Set_Char_Size( m_ftFont, 0, (FT_F26Dot6)ptSize.value26d6, deviceHdpi, deviceVdpi );
-			if( colibri_unlikely( errorCode ) )
+			// Evict the least recently used size. It can't be the current one,
+			// as that one is always the most recently used.
+			entryIdx = 0u;
+			for( size_t i = 1u; i < m_sizes.size(); ++i )
 			{
-				LogListener *log = m_shaperManager->getLogListener();
-				char tmpBuffer[512];
-				Ogre::LwString errorMsg(
-					Ogre::LwString::FromEmptyPointer( tmpBuffer, sizeof( tmpBuffer ) ) );
-
-				errorMsg.clear();
-				errorMsg.a( "[Freetype2 error] Could set font size to ",
-							Ogre::LwString::Float( ptSize.asFloat(), 2 ), ". errorCode: ", errorCode,
-							" Desc: ", ShaperManager::getErrorMessage( errorCode ) );
-				log->log( errorMsg.c_str(), LogSeverity::Error );
+				if( m_sizes[i].lastUsed < m_sizes[entryIdx].lastUsed )
+					entryIdx = i;
 			}
-			else if( colibri_likely( m_hbFont != 0 ) )
-				hb_ft_font_changed( m_hbFont );
+
+			COLIBRI_ASSERT_MEDIUM( entryIdx != m_currentSizeIdx );
+			hb_font_destroy( m_sizes[entryIdx].hbFont );
+			FT_Done_Size( m_sizes[entryIdx].ftSize );
+		}
+		else
+		{
+			m_sizes.push_back( SizeEntry() );
+		}
+
+		SizeEntry &entry = m_sizes[entryIdx];
+		entry.ptSize = ptSize;
+		entry.dpi = dpi;
+		entry.ftSize = 0;
+		entry.hbFont = 0;
+		entry.lastUsed = m_sizeUsageCounter;
+
+		FT_Error errorCode = FT_New_Size( m_ftFont, &entry.ftSize );
+		if( colibri_likely( !errorCode ) )
+		{
+			FT_Activate_Size( entry.ftSize );
+			errorCode = FT_Set_Char_Size( m_ftFont, 0, (FT_F26Dot6)ptSize.value26d6, dpi, dpi );
 		}
+
+		if( colibri_unlikely( errorCode ) )
+		{
+			LogListener *log = m_shaperManager->getLogListener();
+			char tmpBuffer[512];
+			Ogre::LwString errorMsg(
+				Ogre::LwString::FromEmptyPointer( tmpBuffer, sizeof( tmpBuffer ) ) );
+
+			errorMsg.clear();
+			errorMsg.a( "[Freetype2 error] Could set font size to ",
+						Ogre::LwString::Float( ptSize.asFloat(), 2 ), ". errorCode: ", errorCode,
+						" Desc: ", ShaperManager::getErrorMessage( errorCode ) );
+			log->log( errorMsg.c_str(), LogSeverity::Error );
+		}
+
+		// hb_ft_font_create grabs the scale from the active size
+		entry.hbFont = hb_ft_font_create( m_ftFont, NULL );
+
+		return entryIdx;
+	}
+	//-------------------------------------------------------------------------
+	void Shaper::setFontSize( FontSize ptSize )
+	{
+		const uint32_t dpi = m_shaperManager->getDPI();
+
+		if( m_currentSizeIdx < m_sizes.size() && m_sizes[m_currentSizeIdx].ptSize == ptSize &&
+			m_sizes[m_currentSizeIdx].dpi == dpi )
+		{
+			return;
+		}
+
+		m_ptSize = ptSize;
+
+		if( colibri_unlikely( !m_ftFont ) )
+			return;  // Font failed to load. Already logged.
+
+		++m_sizeUsageCounter;
+
+		size_t entryIdx = std::numeric_limits<size_t>::max();
+		for( size_t i = 0u; i < m_sizes.size() && entryIdx == std::numeric_limits<size_t>::max(); ++i )
+		{
+			if( m_sizes[i].ptSize == ptSize && m_sizes[i].dpi == dpi )
+				entryIdx = i;
+		}
+
+		if( entryIdx == std::numeric_limits<size_t>::max() )
+		{
+			entryIdx = createSizeEntry( ptSize, dpi );
+		}
+		else
+		{
+			m_sizes[entryIdx].lastUsed = m_sizeUsageCounter;
+			FT_Activate_Size( m_sizes[entryIdx].ftSize );
+		}
+
+		m_currentSizeIdx = entryIdx;
+		m_hbFont = m_sizes[entryIdx].hbFont;
 	}
 	//-------------------------------------------------------------------------
 	FontSize Shaper::getFontSize() const { return m_ptSize; }
@@ -184,6 +268,8 @@ namespace Colibri
 	//-------------------------------------------------------------------------
 	bool Shaper::getUseCodepoint0ForRaster() const { return m_useCodepoint0ForRaster; }
 	//-------------------------------------------------------------------------
+	void Shaper::setSdfMode( bool sdfMode ) { m_sdfMode = sdfMode; }
+	//-------------------------------------------------------------------------
 	size_t Shaper::renderWithSubstituteFont( const uint16_t *utf16Str, size_t stringLength,
 											 hb_direction_t dir, uint32_t richTextIdx,
 											 uint32_t clusterOffset, ShapedGlyphVec &outShapes,
@@ -194,14 +280,37 @@ namespace Colibri
 
 		const ShaperManager::ShaperVec &shapers = m_shaperManager->getShapers();
 
+		uint32_t firstCodepoint;
+		U16_GET_UNSAFE( utf16Str, 0, firstCodepoint );
+
+		// Go straight to the font that has this codepoint, instead of shaping
+		// with every font until one of them works.
+		const uint16_t fallbackIdx = m_shaperManager->findFallbackFont( firstCodepoint, this );
+		const Shaper *fallbackShaper = fallbackIdx != 0u ? shapers[fallbackIdx] : 0;
+		if( fallbackShaper )
+		{
+			Shaper *otherShaper = shapers[fallbackIdx];
+			otherShaper->setFontSize( m_ptSize );
+			numWrittenCodepoints =
+				otherShaper->renderString( utf16Str, stringLength, dir, richTextIdx, clusterOffset,
+										   outShapes, bOutHasPrivateUse, false );
+		}
+
+		// That font couldn't shape it (e.g. the rest of the cluster is not in it).
+		// Try with the other fonts that at least have the first codepoint.
+		// If no font claims to have it (e.g. its charmap isn't Unicode), try them all
+		// since some may still be able to shape the cluster.
+		const bool bCheckCoverage = fallbackShaper != 0;
+
 		ShaperManager::ShaperVec::const_iterator itor = shapers.begin() + 1u;
 		ShaperManager::ShaperVec::const_iterator endt = shapers.end();
 
 		while( itor != endt && outShapes.size() == currentSize )
 		{
-			if( *itor != this )
+			Shaper *otherShaper = *itor;
+			if( otherShaper != this && otherShaper != fallbackShaper &&
+				( !bCheckCoverage || otherShaper->coversCodepoint( firstCodepoint ) ) )
 			{
-				Shaper *otherShaper = *itor;
 				otherShaper->setFontSize( m_ptSize );
 				numWrittenCodepoints =
 					otherShaper->renderString( utf16Str, stringLength, dir, richTextIdx, clusterOffset,
@@ -425,5 +534,33 @@ namespace Colibri
 		return numWrittenCodepoints;
 	}
 	//-------------------------------------------------------------------------
+	bool Shaper::coversCodepoint( uint32_t codepoint )
+	{
+		if( colibri_unlikely( !m_ftFont ) )
+			return false;
+
+		const uint32_t blockIdx = codepoint >> 8u;
+
+		CoverageBlockMap::iterator itor = m_coverage.find( blockIdx );
+		if( itor == m_coverage.end() )
+		{
+			CoverageBlock block;
+			memset( block.bits, 0, sizeof( block.bits ) );
+
+			const uint32_t blockStart = blockIdx << 8u;
+			for( uint32_t i = 0u; i < 256u; ++i )
+			{
+				if( FT_Get_Char_Index( m_ftFont, blockStart + i ) != 0u )
+					block.bits[i >> 6u] |= uint64_t( 1u ) << ( i & 0x3Fu );
+			}
+
+			itor = m_coverage.insert( CoverageBlockMap::value_type( blockIdx, block ) ).first;
+		}
+
+		const uint32_t idxInBlock = codepoint & 0xFFu;
+		return ( itor->second.bits[idxInBlock >> 6u] & ( uint64_t( 1u ) << ( idxInBlock & 0x3Fu ) ) ) !=
+			   0u;
+	}
+	//-------------------------------------------------------------------------
 	bool Shaper::operator<( const Shaper &other ) const { return this->m_script < other.m_script; }
 }  // namespace Colibri
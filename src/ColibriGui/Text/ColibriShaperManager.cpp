@@ -10,10 +10,13 @@
 #if OGRE_VERSION >= OGRE_MAKE_VERSION( 2, 3, 0 )
 #	include "Vao/OgreReadOnlyBufferPacked.h"
 #endif
+#include "Vao/OgreStagingBuffer.h"
 #include "Vao/OgreTexBufferPacked.h"
 #include "Vao/OgreVaoManager.h"
 
 #include "OgreLwString.h"
+#include "Threading/OgreBarrier.h"
+#include "Threading/OgreThreads.h"
 
 #include "ft2build.h"
 
@@ -22,14 +25,55 @@
 #include "unicode/ubidi.h"
 #include "unicode/unistr.h"
 
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <stdio.h>
+
 namespace Colibri
 {
+	struct ShaperManager::RasterWorkers
+	{
+		struct Worker
+		{
+			FT_Library library;
+			/// Index is the font index. Opened on demand.
+			std::vector<FT_Face> faces;
+			/// Last size set to each face
+			std::vector<uint32_t> faceSizes;
+		};
+
+		Ogre::Barrier         barrier;
+		Ogre::ThreadHandleVec threads;
+		std::vector<Worker>   workers;
+		bool                  exitRequested;
+
+		RasterWorkers( size_t numThreads ) :
+			barrier( numThreads + 1u ),
+			workers( numThreads ),
+			exitRequested( false )
+		{
+		}
+	};
+
+	static unsigned long rasterWorkerThread( Ogre::ThreadHandle *threadHandle )
+	{
+		ShaperManager *shaperManager =
+			reinterpret_cast<ShaperManager *>( threadHandle->getUserParam() );
+		return shaperManager->_rasterWorkerThread( threadHandle->getThreadIdx() );
+	}
+	THREAD_DECLARE( rasterWorkerThread );
+	//-------------------------------------------------------------------------
 	ShaperManager::ShaperManager( ColibriManager *colibriManager ) :
 		m_ftLibrary( 0 ),
 		m_colibriManager( colibriManager ),
-		m_glyphAtlas( 0 ),
-		m_offsetPtr( 1 ),  // The 1st byte is taken. See ShaperManager::updateGpuBuffers
+		m_atlasPageSize( 1u << 20u ),
+		m_maxAtlasSize( std::numeric_limits<size_t>::max() ),
+		m_offsetPtr( 1 ),  // The 1st byte is taken. See ShaperManager::growAtlas
 		m_atlasCapacity( 0 ),
+		m_sdfReferenceSize( 48.0f ),
+		m_sdfSpread( 6u ),
+		m_rasterWorkers( 0 ),
 		m_preferredVertReadingDir( VertReadingDir::Disabled ),
 		m_bidi( 0 ),
 		m_defaultDirection( UBIDI_DEFAULT_LTR /*Note: non-defaults like UBIDI_RTL work differently!*/ ),
@@ -59,6 +103,9 @@ namespace Colibri
 	//-------------------------------------------------------------------------
 	ShaperManager::~ShaperManager()
 	{
+		setNumRasterThreads( 0u );
+		releasePrewarmedGlyphs();
+
 		if( !m_shapers.empty() )
 		{
 			ShaperVec::const_iterator itor = m_shapers.begin() + 1u;
@@ -79,10 +126,13 @@ namespace Colibri
 			m_bmpFonts.clear();
 		}
 
-		if( m_glyphAtlas )
 		{
-			free( m_glyphAtlas );
-			m_glyphAtlas = 0;
+			AtlasPageVec::const_iterator itor = m_atlasPages.begin();
+			AtlasPageVec::const_iterator endt = m_atlasPages.end();
+
+			while( itor != endt )
+				free( *itor++ );
+			m_atlasPages.clear();
 		}
 
 		setOgre( 0, 0 );
@@ -158,9 +208,46 @@ namespace Colibri
 
 		m_shapers.push_back( shaper );
 
+		// The new font may have codepoints none of the others had
+		m_fallbackFonts.clear();
+
 		return shaper;
 	}
 	//-------------------------------------------------------------------------
+	uint16_t ShaperManager::findFallbackFont( uint32_t codepoint, const Shaper *exclude )
+	{
+		uint16_t retVal = 0u;
+
+		CodepointFontMap::const_iterator itor = m_fallbackFonts.find( codepoint );
+		if( itor != m_fallbackFonts.end() )
+			retVal = itor->second;
+		else
+		{
+			const size_t numShapers = m_shapers.size();
+			for( size_t i = 1u; i < numShapers && retVal == 0u; ++i )
+			{
+				if( m_shapers[i]->coversCodepoint( codepoint ) )
+					retVal = static_cast<uint16_t>( i );
+			}
+			m_fallbackFonts[codepoint] = retVal;
+		}
+
+		if( retVal != 0u && m_shapers[retVal] == exclude )
+		{
+			// Rare: the font has the codepoint, yet it couldn't shape it. Try the next ones.
+			const size_t numShapers = m_shapers.size();
+			const size_t firstIdx = retVal + 1u;
+			retVal = 0u;
+			for( size_t i = firstIdx; i < numShapers && retVal == 0u; ++i )
+			{
+				if( m_shapers[i]->coversCodepoint( codepoint ) )
+					retVal = static_cast<uint16_t>( i );
+			}
+		}
+
+		return retVal;
+	}
+	//-------------------------------------------------------------------------
 	void ShaperManager::setDefaultShaper( uint16_t font,
 										  HorizReadingDir::HorizReadingDir horizReadingDir,
 										  bool useVerticalLayoutWhenAvailable )
@@ -202,11 +289,54 @@ namespace Colibri
 		return m_colibriManager->getLogListener();
 	}
 	//-------------------------------------------------------------------------
-	void ShaperManager::growAtlas( size_t sizeBytes )
+	bool ShaperManager::growAtlas()
+	{
+		if( !m_atlasPages.empty() && m_atlasCapacity + m_atlasPageSize > m_maxAtlasSize )
+			return false;
+
+		uint8_t *newPage = reinterpret_cast<uint8_t *>( malloc( m_atlasPageSize ) );
+		if( m_atlasPages.empty() )
+		{
+			// The 1st byte is taken. We use this byte to render arbitrary fixed-colour
+			// stuff without having to switch shaders and would complicate rendering.
+			// It's mostly used for the background colour by Label.
+			newPage[0] = 0xff;
+			Range dirtyRange;
+			dirtyRange.offset = 0u;
+			dirtyRange.size = 1u;
+			m_dirtyRanges.push_back( dirtyRange );
+		}
+
+		m_atlasPages.push_back( newPage );
+		m_atlasCapacity += m_atlasPageSize;
+		return true;
+	}
+	//-------------------------------------------------------------------------
+	bool ShaperManager::allocateFromOffsetPtr( size_t sizeBytes, size_t &outOffset )
 	{
-		m_atlasCapacity = std::max( m_offsetPtr + sizeBytes,
-									m_atlasCapacity + (m_atlasCapacity >> 1u) + 1u );
-		m_glyphAtlas = reinterpret_cast<uint8_t*>( realloc( m_glyphAtlas, m_atlasCapacity ) );
+		size_t offset = m_offsetPtr;
+
+		// Glyphs can't straddle two pages. Skip to the beginning of the next page.
+		const size_t offsetInPage = offset % m_atlasPageSize;
+		if( offsetInPage + sizeBytes > m_atlasPageSize )
+			offset += m_atlasPageSize - offsetInPage;
+
+		if( offset + sizeBytes > m_atlasCapacity )
+			return false;
+
+		if( offset != m_offsetPtr )
+		{
+			// The remainder of the previous page can still be used by smaller glyphs
+			Range freeRange;
+			freeRange.offset = m_offsetPtr;
+			freeRange.size = offset - m_offsetPtr;
+			m_freeRanges.push_back( freeRange );
+			mergeContiguousBlocks( m_freeRanges.end() - 1u, m_freeRanges );
+		}
+
+		outOffset = offset;
+		m_offsetPtr = offset + sizeBytes;
+		return true;
 	}
 	//-------------------------------------------------------------------------
 	size_t ShaperManager::getAtlasOffset( size_t sizeBytes )
@@ -235,61 +365,69 @@ namespace Colibri
 			if( bestRange->size == 0 )
 				Ogre::efficientVectorRemove( m_freeRanges, bestRange );
 		}
-		else
+		else if( !allocateFromOffsetPtr( sizeBytes, retVal ) )
 		{
-			//Couldn't find free space in fragmented pool.
-			if( m_offsetPtr + sizeBytes > m_atlasCapacity )
-			{
-				//We're out of space. First check if we can steal another slot.
-				const CachedGlyphMap::iterator enGlyph = m_glyphCache.end();
-				CachedGlyphMap::iterator bestUnusedGlyph = enGlyph;
+			//Couldn't find free space in fragmented pool, and we're out of space.
+			//First check if we can steal another slot.
+			const CachedGlyphMap::iterator enGlyph = m_glyphCache.end();
+			CachedGlyphMap::iterator bestUnusedGlyph = enGlyph;
 
-				for( size_t i = 0; i < 2u && bestUnusedGlyph == enGlyph; ++i )
+			for( size_t i = 0; i < 2u && bestUnusedGlyph == enGlyph; ++i )
+			{
+				CachedGlyphMap::iterator itGlyph = m_glyphCache.begin();
+				while( itGlyph != enGlyph )
 				{
-					CachedGlyphMap::iterator itGlyph = m_glyphCache.begin();
-					while( itGlyph != enGlyph )
+					if( !itGlyph->second.refCount && itGlyph->second.getSizeBytes() >= sizeBytes &&
+						( bestUnusedGlyph == enGlyph ||
+						  itGlyph->second.getSizeBytes() < bestUnusedGlyph->second.getSizeBytes() ) )
 					{
-						if( !itGlyph->second.refCount && itGlyph->second.getSizeBytes() >= sizeBytes &&
-							( bestUnusedGlyph == enGlyph ||
-							  itGlyph->second.getSizeBytes() < bestUnusedGlyph->second.getSizeBytes() ) )
-						{
-							bestUnusedGlyph = itGlyph;
-						}
-						++itGlyph;
+						bestUnusedGlyph = itGlyph;
 					}
-
-					// Not found? Try again, this time with all unused glyphs removed and merged.
-					// We may have two contiguous unused glyphs that are big enough to hold
-					// this new glyph, but weren't big enough individually.
-					if( i == 0 && bestUnusedGlyph == enGlyph )
-						flushReleasedGlyphs();
+					++itGlyph;
 				}
 
-				if( bestUnusedGlyph == enGlyph )
-				{
-					// Cannot steal. Grow the atlas, advance the pointer and get a fresh region
-					growAtlas( sizeBytes );
-					retVal = m_offsetPtr;
-					m_offsetPtr += sizeBytes;
-				}
-				else
+				// Not found? Try again, this time with all unused glyphs removed and merged.
+				// We may have two contiguous unused glyphs that are big enough to hold
+				// this new glyph, but weren't big enough individually.
+				if( i == 0 && bestUnusedGlyph == enGlyph )
+					flushReleasedGlyphs();
+			}
+
+			if( bestUnusedGlyph == enGlyph )
+			{
+				// Cannot steal. Add a new page, advance the pointer and get a fresh region
+				if( !growAtlas() || !allocateFromOffsetPtr( sizeBytes, retVal ) )
 				{
-					//Steal successful! Put the unused glyph back into the pool and try again
-					destroyGlyph( bestUnusedGlyph );
-					retVal = getAtlasOffset( sizeBytes );
+					LogListener *log = getLogListener();
+					char tmpBuffer[256];
+					Ogre::LwString errorMsg(
+						Ogre::LwString::FromEmptyPointer( tmpBuffer, sizeof( tmpBuffer ) ) );
+
+					errorMsg.clear();
+					errorMsg.a( "[ShaperManager] Glyph atlas is full. Could not allocate ",
+								(uint32_t)sizeBytes, " bytes. Max atlas size: ",
+								(uint32_t)( m_maxAtlasSize >> 10u ),
+								" KiB. See ShaperManager::setMaxGlyphAtlasSize" );
+					log->log( errorMsg.c_str(), LogSeverity::Error );
+					retVal = std::numeric_limits<size_t>::max();
 				}
 			}
 			else
 			{
-				//Advance the pointer and get a fresh region
-				retVal = m_offsetPtr;
-				m_offsetPtr += sizeBytes;
+				//Steal successful! Put the unused glyph back into the pool and try again
+				destroyGlyph( bestUnusedGlyph );
+				retVal = getAtlasOffset( sizeBytes );
 			}
 		}
 
 		return retVal;
 	}
 	//-------------------------------------------------------------------------
+	uint8_t *ShaperManager::getAtlasPtr( size_t offset )
+	{
+		return m_atlasPages[offset / m_atlasPageSize] + ( offset % m_atlasPageSize );
+	}
+	//-------------------------------------------------------------------------
 	CachedGlyph *ShaperManager::createGlyph( FT_Face font, uint32_t codepoint, uint32_t ptSize,
 											 uint16_t fontIdx, bool bDummy )
 	{
@@ -307,9 +445,15 @@ namespace Colibri
 			log->log( errorMsg.c_str(), LogSeverity::Warning );
 		}
 
-		//Rasterize the glyph
 		FT_GlyphSlot slot = font->glyph;
-		FT_Render_Glyph( slot, FT_RENDER_MODE_NORMAL );
+
+		// FT_Load_Glyph already calculated the bitmap's dimensions for outlines, so we only
+		// need to reserve the space now and can leave the actual rasterization to the workers.
+		const bool bDeferRaster = m_rasterWorkers != 0 && slot->format == FT_GLYPH_FORMAT_OUTLINE;
+
+		//Rasterize the glyph
+		if( !bDeferRaster )
+			FT_Render_Glyph( slot, FT_RENDER_MODE_NORMAL );
 
 		FT_Bitmap ftBitmap = slot->bitmap;
 
@@ -321,21 +465,59 @@ namespace Colibri
 		newGlyph.bearingY	= static_cast<float>( slot->bitmap_top );
 		newGlyph.width		= static_cast<uint16_t>( ftBitmap.width );
 		newGlyph.height		= static_cast<uint16_t>( ftBitmap.rows );
-		newGlyph.offsetStart = (uint32_t)getAtlasOffset( newGlyph.getSizeBytes() );
+
+		if( colibri_unlikely( newGlyph.getSizeBytes() > m_atlasPageSize ) )
+		{
+			LogListener *log = getLogListener();
+			char tmpBuffer[256];
+			Ogre::LwString errorMsg( Ogre::LwString::FromEmptyPointer( tmpBuffer, sizeof(tmpBuffer) ) );
+
+			errorMsg.clear();
+			errorMsg.a( "[ShaperManager] Glyph for codepoint ", codepoint, " at ptSize ", ptSize,
+						" is bigger than a glyph atlas page. See setGlyphAtlasPageSize" );
+			log->log( errorMsg.c_str(), LogSeverity::Error );
+			newGlyph.width = 0u;
+			newGlyph.height = 0u;
+		}
+
+		size_t atlasOffset = getAtlasOffset( newGlyph.getSizeBytes() );
+		if( colibri_unlikely( atlasOffset == std::numeric_limits<size_t>::max() ) )
+		{
+			// Atlas is full. getAtlasOffset already logged it. Render it empty.
+			newGlyph.width = 0u;
+			newGlyph.height = 0u;
+			atlasOffset = getAtlasOffset( 0u );
+		}
+		newGlyph.offsetStart = (uint32_t)atlasOffset;
 		newGlyph.newlineSize = (float)font->size->metrics.height / 64.0f;
 		newGlyph.regionUp = (float)font->size->metrics.ascender /
 							float( font->size->metrics.ascender - font->size->metrics.descender );
+		newGlyph.atlasWidth = newGlyph.width;
+		newGlyph.atlasHeight = newGlyph.height;
 		newGlyph.font = fontIdx;
+		newGlyph.isSdf = false;
 		newGlyph.refCount	= 0;
 
 		const GlyphKey glyphKey( codepoint, ptSize, fontIdx );
 		std::pair<CachedGlyphMap::iterator, bool> pair =
 				m_glyphCache.emplace( glyphKey, newGlyph );
 
-		if( newGlyph.getSizeBytes() > 0 )
+		if( newGlyph.getSizeBytes() > 0 && bDeferRaster )
+		{
+			// The dirty range will be scheduled once it's rasterized
+			PendingRaster pendingRaster;
+			pendingRaster.glyphIndex = bDummy ? 0u : codepoint;
+			pendingRaster.ptSize = ptSize;
+			pendingRaster.fontIdx = fontIdx;
+			pendingRaster.width = newGlyph.width;
+			pendingRaster.height = newGlyph.height;
+			pendingRaster.offsetStart = newGlyph.offsetStart;
+			m_pendingRasters.push_back( pendingRaster );
+		}
+		else if( newGlyph.getSizeBytes() > 0 )
 		{
 			//Copy the rasterized results to our atlas
-			memcpy( m_glyphAtlas + newGlyph.offsetStart, ftBitmap.buffer, newGlyph.getSizeBytes() );
+			memcpy( getAtlasPtr( newGlyph.offsetStart ), ftBitmap.buffer, newGlyph.getSizeBytes() );
 			{
 				//Schedule a transfer to the GPU.
 				Range dirtyRange;
@@ -348,6 +530,153 @@ namespace Colibri
 		return &pair.first->second;
 	}
 	//-------------------------------------------------------------------------
+	ShaperManager::SdfBitmap ShaperManager::rasterizeSdfBitmap( FT_Face font, uint32_t glyphIndex,
+																uint16_t fontIdx )
+	{
+		SdfBitmap retVal;
+		retVal.offsetStart = 0u;
+		retVal.width = 0u;
+		retVal.height = 0u;
+		retVal.bearingX = 0.0f;
+		retVal.bearingY = 0.0f;
+		retVal.refCount = 0u;
+
+		// Rasterize at the reference size. The Shaper caches its sizes, so switching is cheap.
+		Shaper *shaper = m_shapers[fontIdx];
+		const FontSize oldSize = shaper->getFontSize();
+		shaper->setFontSize( m_sdfReferenceSize );
+
+		FT_Error errorCode = FT_Load_Glyph( font, glyphIndex, FT_LOAD_DEFAULT );
+		if( !errorCode )
+			errorCode = FT_Render_Glyph( font->glyph, FT_RENDER_MODE_NORMAL );
+
+		const FT_Bitmap &ftBitmap = font->glyph->bitmap;
+		const int32_t srcWidth = static_cast<int32_t>( ftBitmap.width );
+		const int32_t srcHeight = static_cast<int32_t>( ftBitmap.rows );
+		const int32_t spread = static_cast<int32_t>( m_sdfSpread );
+		const size_t dstWidth = size_t( srcWidth + spread * 2 );
+		const size_t dstHeight = size_t( srcHeight + spread * 2 );
+
+		if( colibri_unlikely( errorCode ) )
+		{
+			LogListener *log = getLogListener();
+			char tmpBuffer[512];
+			Ogre::LwString errorMsg( Ogre::LwString::FromEmptyPointer( tmpBuffer, sizeof(tmpBuffer) ) );
+
+			errorMsg.clear();
+			errorMsg.a( "[Freetype2 error] Could not load SDF glyph for codepoint ", glyphIndex,
+						" errorCode: ", errorCode, " Desc: ",
+						ShaperManager::getErrorMessage( errorCode ) );
+			log->log( errorMsg.c_str(), LogSeverity::Warning );
+		}
+		else if( srcWidth > 0 && srcHeight > 0 && dstWidth * dstHeight <= m_atlasPageSize )
+		{
+			const size_t atlasOffset = getAtlasOffset( dstWidth * dstHeight );
+			if( atlasOffset != std::numeric_limits<size_t>::max() )
+			{
+				retVal.offsetStart = static_cast<uint32_t>( atlasOffset );
+				retVal.width = static_cast<uint16_t>( dstWidth );
+				retVal.height = static_cast<uint16_t>( dstHeight );
+				retVal.bearingX = static_cast<float>( font->glyph->bitmap_left - spread );
+				retVal.bearingY = static_cast<float>( font->glyph->bitmap_top + spread );
+
+				// Brute force search of the closest texel with the opposite state, within spread.
+				// It's only done once per glyph (regardless of sizes).
+				const uint8_t *srcData = ftBitmap.buffer;
+				const int32_t srcPitch = ftBitmap.pitch;
+				uint8_t *dstData = getAtlasPtr( atlasOffset );
+
+				const float invRange = 0.5f / float( spread );
+
+				for( int32_t y = 0; y < int32_t( dstHeight ); ++y )
+				{
+					for( int32_t x = 0; x < int32_t( dstWidth ); ++x )
+					{
+						const int32_t srcX = x - spread;
+						const int32_t srcY = y - spread;
+						const bool bInside = srcX >= 0 && srcX < srcWidth && srcY >= 0 &&
+											 srcY < srcHeight &&
+											 srcData[srcY * srcPitch + srcX] >= 128u;
+
+						int32_t minDistSq = spread * spread;
+						for( int32_t dy = -spread; dy <= spread; ++dy )
+						{
+							const int32_t nY = srcY + dy;
+							for( int32_t dx = -spread; dx <= spread; ++dx )
+							{
+								const int32_t nX = srcX + dx;
+								const bool bNeighbourInside = nX >= 0 && nX < srcWidth && nY >= 0 &&
+															  nY < srcHeight &&
+															  srcData[nY * srcPitch + nX] >= 128u;
+								if( bNeighbourInside != bInside )
+									minDistSq = std::min( minDistSq, dx * dx + dy * dy );
+							}
+						}
+
+						// The edge is halfway between both texels
+						const float dist = std::sqrt( float( minDistSq ) ) - 0.5f;
+						const float value = 0.5f + ( bInside ? dist : -dist ) * invRange;
+						dstData[size_t( y ) * dstWidth + size_t( x )] =
+							static_cast<uint8_t>( std::min( std::max( value, 0.0f ), 1.0f ) * 255.0f + 0.5f );
+					}
+				}
+
+				//Schedule a transfer to the GPU.
+				Range dirtyRange;
+				dirtyRange.offset = atlasOffset;
+				dirtyRange.size = dstWidth * dstHeight;
+				m_dirtyRanges.push_back( dirtyRange );
+			}
+		}
+
+		shaper->setFontSize( oldSize );
+
+		return retVal;
+	}
+	//-------------------------------------------------------------------------
+	CachedGlyph *ShaperManager::createSdfGlyph( FT_Face font, uint32_t codepoint, uint32_t ptSize,
+												uint16_t fontIdx, bool bDummy )
+	{
+		// These depend on the actual size. Grab them before rasterizeSdfBitmap changes it.
+		const float newlineSize = (float)font->size->metrics.height / 64.0f;
+		const float regionUp = (float)font->size->metrics.ascender /
+							   float( font->size->metrics.ascender - font->size->metrics.descender );
+
+		const GlyphKey bitmapKey( codepoint, 0u, fontIdx );
+		SdfBitmapMap::iterator itBitmap = m_sdfBitmaps.find( bitmapKey );
+		if( itBitmap == m_sdfBitmaps.end() )
+		{
+			const SdfBitmap sdfBitmap = rasterizeSdfBitmap( font, bDummy ? 0u : codepoint, fontIdx );
+			itBitmap = m_sdfBitmaps.insert( SdfBitmapMap::value_type( bitmapKey, sdfBitmap ) ).first;
+		}
+
+		SdfBitmap &sdfBitmap = itBitmap->second;
+		++sdfBitmap.refCount;
+
+		const float scale = float( ptSize ) / float( m_sdfReferenceSize.value26d6 );
+
+		CachedGlyph newGlyph;
+		newGlyph.codepoint = codepoint;
+		newGlyph.ptSize = ptSize;
+		newGlyph.offsetStart = sdfBitmap.offsetStart;
+		newGlyph.bearingX = sdfBitmap.bearingX * scale;
+		newGlyph.bearingY = sdfBitmap.bearingY * scale;
+		newGlyph.width = static_cast<uint16_t>( std::round( float( sdfBitmap.width ) * scale ) );
+		newGlyph.height = static_cast<uint16_t>( std::round( float( sdfBitmap.height ) * scale ) );
+		newGlyph.atlasWidth = sdfBitmap.width;
+		newGlyph.atlasHeight = sdfBitmap.height;
+		newGlyph.newlineSize = newlineSize;
+		newGlyph.regionUp = regionUp;
+		newGlyph.font = fontIdx;
+		newGlyph.isSdf = true;
+		newGlyph.refCount = 0;
+
+		const GlyphKey glyphKey( codepoint, ptSize, fontIdx );
+		std::pair<CachedGlyphMap::iterator, bool> pair = m_glyphCache.emplace( glyphKey, newGlyph );
+
+		return &pair.first->second;
+	}
+	//-------------------------------------------------------------------------
 	CachedGlyph *ShaperManager::createRasterGlyph( FT_Face font, uint32_t codepoint, uint32_t ptSize,
 												   uint16_t fontIdx, const bool bUseCodepoint0ForRaster )
 	{
@@ -387,7 +716,10 @@ namespace Colibri
 		newGlyph.offsetStart = 0u;
 		newGlyph.newlineSize= newGlyph.height;
 		newGlyph.regionUp	= 1.0f;  // Is this correct?
+		newGlyph.atlasWidth	= newGlyph.width;
+		newGlyph.atlasHeight= newGlyph.height;
 		newGlyph.font		= fontIdx;
+		newGlyph.isSdf		= false;
 		newGlyph.refCount	= 0;
 
 		releaseGlyph( dummyCodepoint );
@@ -399,145 +731,810 @@ namespace Colibri
 		return &pair.first->second;
 	}
 	//-------------------------------------------------------------------------
-	void ShaperManager::destroyGlyph( CachedGlyphMap::iterator glyphIt )
+	void ShaperManager::prewarm( uint16_t font, const std::vector<FontSize> &ptSizes,
+								 const char *utf8Str )
 	{
-		CachedGlyph &glyph = glyphIt->second;
-
-		if( glyph.offsetStart + glyph.getSizeBytes() == m_offsetPtr )
-		{
-			//Easy case. LIFO.
-			m_offsetPtr -= glyph.getSizeBytes();
-		}
-		else
+		RichText richText;
+		richText.offset = 0u;
+		richText.length = static_cast<uint32_t>( strlen( utf8Str ) );
+		richText.readingDir = HorizReadingDir::Default;
+		richText.rgba32 = 0xFFFFFFFF;
+		richText.backgroundRgba32 = 0u;
+		richText.font = font;
+		richText.noBackground = true;
+		richText.glyphStart = 0u;
+		richText.glyphEnd = 0u;
+
+		ShapedGlyphVec shapes;
+
+		std::vector<FontSize>::const_iterator itor = ptSizes.begin();
+		std::vector<FontSize>::const_iterator endt = ptSizes.end();
+
+		while( itor != endt )
 		{
-			Range freeRange;
-			freeRange.offset= glyph.offsetStart;
-			freeRange.size	= glyph.getSizeBytes();
-			m_freeRanges.push_back( freeRange );
-			mergeContiguousBlocks( m_freeRanges.end() - 1u, m_freeRanges );
+			richText.ptSize = *itor;
+
+			bool bHasPrivateUse;
+			shapes.clear();
+			renderString( utf8Str, richText, 0u, VertReadingDir::Disabled, shapes, bHasPrivateUse );
+
+			// renderString acquired the glyphs for us. Keep those references.
+			ShapedGlyphVec::const_iterator itShape = shapes.begin();
+			ShapedGlyphVec::const_iterator enShape = shapes.end();
+
+			while( itShape != enShape )
+			{
+				m_prewarmedGlyphs.push_back( itShape->glyph );
+				++itShape;
+			}
+
+			++itor;
 		}
 
-		m_glyphCache.erase( glyphIt );
+		rasterizePendingGlyphs();
 	}
 	//-------------------------------------------------------------------------
-	void ShaperManager::mergeContiguousBlocks( RangeVec::iterator blockToMerge,
-											   RangeVec &blocks )
+	void ShaperManager::prewarm( uint16_t font, const std::vector<FontSize> &ptSizes,
+								 uint32_t firstCodepoint, uint32_t lastCodepoint )
 	{
-		RangeVec::iterator itor = blocks.begin();
-		RangeVec::iterator end  = blocks.end();
-
-		while( itor != end )
+		if( colibri_unlikely( font >= m_shapers.size() ) )
 		{
-			if( itor->offset + itor->size == blockToMerge->offset )
-			{
-				itor->size += blockToMerge->size;
-				ptrdiff_t idx = itor - blocks.begin();
+			LogListener *log = this->getLogListener();
+			char tmpBuffer[512];
+			Ogre::LwString errorMsg( Ogre::LwString::FromEmptyPointer( tmpBuffer, sizeof(tmpBuffer) ) );
 
-				//When blockToMerge is the last one, its index won't be the same
-				//after removing the other iterator, they will swap.
-				if( idx == ptrdiff_t( blocks.size() - 1u ) )
-					idx = blockToMerge - blocks.begin();
+			errorMsg.clear();
+			errorMsg.a( "[ShaperManager::prewarm] Font ", font, " does not exist. There's only ",
+						(uint32_t)m_shapers.size(), " fonts installed" );
+			log->log( errorMsg.c_str(), LogSeverity::Error );
+			return;
+		}
 
-				Ogre::efficientVectorRemove( blocks, blockToMerge );
+		// Nothing lies beyond the last Unicode codepoint. Clamping also
+		// prevents the loop below from wrapping around when lastCodepoint = UINT32_MAX
+		lastCodepoint = std::min( lastCodepoint, 0x10FFFFu );
+		if( firstCodepoint > lastCodepoint )
+			return;
 
-				blockToMerge = blocks.begin() + idx;
-				itor = blocks.begin();
-				end  = blocks.end();
-			}
-			else if( blockToMerge->offset + blockToMerge->size == itor->offset )
-			{
-				blockToMerge->size += itor->size;
-				ptrdiff_t idx = blockToMerge - blocks.begin();
+		Shaper *shaper = m_shapers[font];
+		FT_Face ftFace = shaper->getFtFace();
 
-				//When blockToMerge is the last one, its index won't be the same
-				//after removing the other iterator, they will swap.
-				if( idx == ptrdiff_t( blocks.size() - 1u ) )
-					idx = itor - blocks.begin();
+		std::vector<FontSize>::const_iterator itor = ptSizes.begin();
+		std::vector<FontSize>::const_iterator endt = ptSizes.end();
 
-				Ogre::efficientVectorRemove( blocks, itor );
+		while( itor != endt )
+		{
+			shaper->setFontSize( *itor );
 
-				blockToMerge = blocks.begin() + idx;
-				itor = blocks.begin();
-				end  = blocks.end();
-			}
-			else
+			for( uint32_t codepoint = firstCodepoint; codepoint <= lastCodepoint; ++codepoint )
 			{
-				++itor;
+				// The cache is indexed by glyph index (what HarfBuzz outputs), not by codepoint
+				const FT_UInt glyphIndex = FT_Get_Char_Index( ftFace, codepoint );
+				if( glyphIndex != 0u )
+				{
+					m_prewarmedGlyphs.push_back( acquireGlyph( ftFace, glyphIndex, itor->value26d6,
+															   shaper->getFontIdx(), false,
+															   shaper->getUseCodepoint0ForRaster() ) );
+				}
 			}
+
+			++itor;
 		}
+
+		rasterizePendingGlyphs();
 	}
 	//-------------------------------------------------------------------------
-	const CachedGlyph *ShaperManager::acquireGlyph( FT_Face font, uint32_t codepoint, uint32_t ptSize,
-													uint16_t fontIdx, bool bDummy,
-													const bool bUseCodepoint0ForRaster )
+	void ShaperManager::releasePrewarmedGlyphs()
 	{
-		CachedGlyph *retVal = 0;
+		std::vector<CachedGlyph const *>::const_iterator itor = m_prewarmedGlyphs.begin();
+		std::vector<CachedGlyph const *>::const_iterator endt = m_prewarmedGlyphs.end();
 
-		const GlyphKey glyphKey( codepoint, ptSize, fontIdx );
-		CachedGlyphMap::iterator itor = m_glyphCache.find( glyphKey );
+		while( itor != endt )
+			releaseGlyph( *itor++ );
 
-		if( itor != m_glyphCache.end() )
-		{
-			retVal = &itor->second;
-		}
-		else
-		{
-			if( !bDummy || !getDefaultBmpFontForRaster() )
-			{
-				retVal = createGlyph( font, codepoint, ptSize, fontIdx, bDummy );
-			}
-			else
-			{
-				retVal =
-					createRasterGlyph( font, codepoint, ptSize, fontIdx, bUseCodepoint0ForRaster );
-			}
-		}
+		m_prewarmedGlyphs.clear();
+	}
+	//-------------------------------------------------------------------------
+	static const uint32_t c_glyphCacheMagic = 0x43474743;  // 'CGGC'
+	static const uint32_t c_glyphCacheVersion = 3u;
 
-		++retVal->refCount;
+	/// Layout of each free range in a glyph cache file. Fixed size regardless of size_t
+	struct SerializedRange
+	{
+		uint64_t offset;
+		uint64_t size;
+	};
 
-		return retVal;
+	/// Layout of each glyph in a glyph cache file. See ShaperManager::saveGlyphCache
+	struct SerializedGlyph
+	{
+		uint32_t codepoint;
+		uint32_t ptSize;
+		uint32_t offsetStart;
+		uint16_t font;
+		uint16_t width;
+		uint16_t height;
+		uint16_t atlasWidth;
+		uint16_t atlasHeight;
+		/// Bit 0 is set for SDF glyphs
+		uint16_t flags;
+		float    bearingX;
+		float    bearingY;
+		float    newlineSize;
+		float    regionUp;
+	};
+
+	/// Layout of each shared SDF bitmap in a glyph cache file
+	struct SerializedSdfBitmap
+	{
+		uint32_t codepoint;
+		uint32_t offsetStart;
+		uint16_t font;
+		uint16_t width;
+		uint16_t height;
+		uint16_t padding;
+		float    bearingX;
+		float    bearingY;
+	};
+
+	static uint64_t hashFnv1a( const void *data, size_t sizeBytes, uint64_t hash )
+	{
+		const uint8_t *bytes = reinterpret_cast<const uint8_t *>( data );
+		for( size_t i = 0u; i < sizeBytes; ++i )
+		{
+			hash ^= bytes[i];
+			hash *= 0x100000001B3ull;
+		}
+		return hash;
 	}
 	//-------------------------------------------------------------------------
-	void ShaperManager::addRefCount( const CachedGlyph *cachedGlyph )
+	bool ShaperManager::isAtlasRegionValid( uint64_t offset, uint64_t sizeBytes,
+											uint64_t offsetPtr ) const
 	{
-		const GlyphKey glyphKey( cachedGlyph->codepoint, cachedGlyph->ptSize, cachedGlyph->font );
-
-		COLIBRI_ASSERT_MEDIUM( m_glyphCache.find( glyphKey ) != m_glyphCache.end() &&
-							   "Invalid glyph cache entry. Use-after-free perhaps?" );
-
-		CachedGlyph *nonConstCachedGlyph = const_cast<CachedGlyph*>( cachedGlyph );
-		++nonConstCachedGlyph->refCount;
+		if( offset > offsetPtr || sizeBytes > offsetPtr - offset )
+			return false;
+		// Glyphs never straddle two pages
+		return sizeBytes == 0u ||
+			   offset / m_atlasPageSize == ( offset + sizeBytes - 1u ) / m_atlasPageSize;
 	}
 	//-------------------------------------------------------------------------
-	void ShaperManager::releaseGlyph( uint32_t codepoint, uint32_t ptSize, uint16_t fontIdx )
+	void ShaperManager::getGlyphCacheKey( std::vector<uint64_t> &outKey ) const
 	{
-		const GlyphKey glyphKey( codepoint, ptSize, fontIdx );
+		outKey.clear();
+		outKey.push_back( c_glyphCacheMagic );
+		outKey.push_back( c_glyphCacheVersion );
+		outKey.push_back( ( FREETYPE_MAJOR << 16u ) | ( FREETYPE_MINOR << 8u ) | FREETYPE_PATCH );
+		outKey.push_back( m_dpi );
+		outKey.push_back( m_atlasPageSize );
+		outKey.push_back( static_cast<uint64_t>( m_sdfReferenceSize.value26d6 ) );
+		outKey.push_back( m_sdfSpread );
+		outKey.push_back( m_shapers.size() );
+
+		// setDefaultShaper changes which font m_shapers[0] (i.e. font 0) is
+		uint64_t defaultFont = 0u;
+		for( size_t i = 1u; i < m_shapers.size() && defaultFont == 0u; ++i )
+		{
+			if( m_shapers[i] == m_shapers[0] )
+				defaultFont = i;
+		}
+		outKey.push_back( defaultFont );
 
-		CachedGlyphMap::iterator itor = m_glyphCache.find( glyphKey );
+		// Hashing the whole font files would defeat the purpose of the cache.
+		// Identify them by path, size, and what FreeType says about them instead.
+		ShaperVec::const_iterator itor = m_shapers.empty() ? m_shapers.end() : m_shapers.begin() + 1u;
+		ShaperVec::const_iterator endt = m_shapers.end();
 
-		COLIBRI_ASSERT_LOW( itor != m_glyphCache.end() &&
-							"Invalid glyph cache entry not found. Use-after-free perhaps?" );
-		COLIBRI_ASSERT_LOW( itor->second.refCount > 0 );
+		while( itor != endt )
+		{
+			const std::string &fontLocation = ( *itor )->getFontLocation();
+			FT_Face ftFace = ( *itor )->getFtFace();
 
-		if( itor != m_glyphCache.end() && itor->second.refCount > 0 )
-			--itor->second.refCount;
+			uint64_t hash = 0xCBF29CE484222325ull;
+			hash = hashFnv1a( fontLocation.c_str(), fontLocation.size(), hash );
+			if( ftFace )
+			{
+				const uint64_t faceInfo[3] = { static_cast<uint64_t>( ftFace->stream->size ),
+											   static_cast<uint64_t>( ftFace->num_glyphs ),
+											   static_cast<uint64_t>( ftFace->units_per_EM ) };
+				hash = hashFnv1a( faceInfo, sizeof( faceInfo ), hash );
+			}
+			outKey.push_back( hash );
+			++itor;
+		}
 	}
 	//-------------------------------------------------------------------------
-	void ShaperManager::releaseGlyph( const CachedGlyph *cachedGlyph )
+	bool ShaperManager::saveGlyphCache( const char *fullPath )
 	{
-		const GlyphKey glyphKey( cachedGlyph->codepoint, cachedGlyph->ptSize, cachedGlyph->font );
+		rasterizePendingGlyphs();
 
-		COLIBRI_ASSERT_MEDIUM( m_glyphCache.find( glyphKey ) != m_glyphCache.end() &&
-							   "Invalid glyph cache entry. Use-after-free perhaps?" );
-		COLIBRI_ASSERT_LOW( cachedGlyph->refCount > 0 );
+		LogListener *log = getLogListener();
+		char tmpBuffer[512];
+		Ogre::LwString errorMsg( Ogre::LwString::FromEmptyPointer( tmpBuffer, sizeof( tmpBuffer ) ) );
 
-		CachedGlyph *nonConstCachedGlyph = const_cast<CachedGlyph*>( cachedGlyph );
-		if( nonConstCachedGlyph->refCount > 0 )
-			--nonConstCachedGlyph->refCount;
-	}
-	//-------------------------------------------------------------------------
-	void ShaperManager::flushReleasedGlyphs()
-	{
+		FILE *file = fopen( fullPath, "wb" );
+		if( !file )
+		{
+			errorMsg.clear();
+			errorMsg.a( "[ShaperManager::saveGlyphCache] Could not open ", fullPath, " for writing" );
+			log->log( errorMsg.c_str(), LogSeverity::Error );
+			return false;
+		}
+
+		// The atlas space of whatever we don't save must be free once loaded
+		RangeVec freeRanges( m_freeRanges );
+		std::set<GlyphKey> savedSdfBitmaps;
+
+		std::vector<SerializedGlyph> glyphs;
+		glyphs.reserve( m_glyphCache.size() );
+		{
+			CachedGlyphMap::const_iterator itor = m_glyphCache.begin();
+			CachedGlyphMap::const_iterator endt = m_glyphCache.end();
+
+			while( itor != endt )
+			{
+				const CachedGlyph &glyph = itor->second;
+				// Raster glyphs depend on the BmpFonts, which we don't track
+				if( glyph.isCodepointInPrivateArea() )
+				{
+					if( glyph.getSizeBytes() > 0u )
+					{
+						Range freeRange;
+						freeRange.offset = glyph.offsetStart;
+						freeRange.size = glyph.getSizeBytes();
+						freeRanges.push_back( freeRange );
+						mergeContiguousBlocks( freeRanges.end() - 1u, freeRanges );
+					}
+				}
+				else
+				{
+					if( glyph.isSdf )
+						savedSdfBitmaps.insert( GlyphKey( glyph.codepoint, 0u, glyph.font ) );
+
+					SerializedGlyph serialized;
+					serialized.codepoint = glyph.codepoint;
+					serialized.ptSize = glyph.ptSize;
+					serialized.offsetStart = glyph.offsetStart;
+					serialized.font = glyph.font;
+					serialized.width = glyph.width;
+					serialized.height = glyph.height;
+					serialized.atlasWidth = glyph.atlasWidth;
+					serialized.atlasHeight = glyph.atlasHeight;
+					serialized.flags = glyph.isSdf ? 1u : 0u;
+					serialized.bearingX = glyph.bearingX;
+					serialized.bearingY = glyph.bearingY;
+					serialized.newlineSize = glyph.newlineSize;
+					serialized.regionUp = glyph.regionUp;
+					glyphs.push_back( serialized );
+				}
+				++itor;
+			}
+		}
+
+		std::vector<SerializedSdfBitmap> sdfBitmaps;
+		sdfBitmaps.reserve( m_sdfBitmaps.size() );
+		{
+			SdfBitmapMap::const_iterator itor = m_sdfBitmaps.begin();
+			SdfBitmapMap::const_iterator endt = m_sdfBitmaps.end();
+
+			while( itor != endt )
+			{
+				if( savedSdfBitmaps.find( itor->first ) == savedSdfBitmaps.end() )
+				{
+					// No saved glyph references it (e.g. only skipped ones did)
+					Range freeRange;
+					freeRange.offset = itor->second.offsetStart;
+					freeRange.size = size_t( itor->second.width ) * size_t( itor->second.height );
+					if( freeRange.size > 0u )
+					{
+						freeRanges.push_back( freeRange );
+						mergeContiguousBlocks( freeRanges.end() - 1u, freeRanges );
+					}
+					++itor;
+					continue;
+				}
+
+				SerializedSdfBitmap serialized;
+				serialized.codepoint = itor->first.codepoint;
+				serialized.offsetStart = itor->second.offsetStart;
+				serialized.font = static_cast<uint16_t>( itor->first.fontIdx );
+				serialized.width = itor->second.width;
+				serialized.height = itor->second.height;
+				serialized.padding = 0u;
+				serialized.bearingX = itor->second.bearingX;
+				serialized.bearingY = itor->second.bearingY;
+				sdfBitmaps.push_back( serialized );
+				++itor;
+			}
+		}
+
+		// Header is: key, offsetPtr, numFreeRanges, numGlyphs, numSdfBitmaps
+		std::vector<uint64_t> header;
+		getGlyphCacheKey( header );
+		header.push_back( m_offsetPtr );
+		header.push_back( freeRanges.size() );
+		header.push_back( glyphs.size() );
+		header.push_back( sdfBitmaps.size() );
+
+		const uint64_t headerSize = header.size();
+		bool bSuccess = fwrite( &headerSize, sizeof( headerSize ), 1u, file ) == 1u;
+		bSuccess &= fwrite( &header[0], sizeof( uint64_t ), header.size(), file ) == header.size();
+		if( !freeRanges.empty() )
+		{
+			std::vector<SerializedRange> serializedRanges;
+			serializedRanges.reserve( freeRanges.size() );
+
+			RangeVec::const_iterator itor = freeRanges.begin();
+			RangeVec::const_iterator endt = freeRanges.end();
+
+			while( itor != endt )
+			{
+				SerializedRange serialized;
+				serialized.offset = itor->offset;
+				serialized.size = itor->size;
+				serializedRanges.push_back( serialized );
+				++itor;
+			}
+
+			bSuccess &= fwrite( &serializedRanges[0], sizeof( SerializedRange ),
+								serializedRanges.size(), file ) == serializedRanges.size();
+		}
+		if( !glyphs.empty() )
+		{
+			bSuccess &= fwrite( &glyphs[0], sizeof( SerializedGlyph ), glyphs.size(), file ) ==
+						glyphs.size();
+		}
+		if( !sdfBitmaps.empty() )
+		{
+			bSuccess &= fwrite( &sdfBitmaps[0], sizeof( SerializedSdfBitmap ), sdfBitmaps.size(),
+								file ) == sdfBitmaps.size();
+		}
+		for( size_t pageStart = 0u; pageStart < m_offsetPtr && bSuccess; pageStart += m_atlasPageSize )
+		{
+			const size_t sizeBytes = std::min( m_offsetPtr - pageStart, m_atlasPageSize );
+			bSuccess &= fwrite( getAtlasPtr( pageStart ), 1u, sizeBytes, file ) == sizeBytes;
+		}
+
+		fclose( file );
+
+		if( !bSuccess )
+		{
+			errorMsg.clear();
+			errorMsg.a( "[ShaperManager::saveGlyphCache] Error writing to ", fullPath );
+			log->log( errorMsg.c_str(), LogSeverity::Error );
+			remove( fullPath );
+		}
+
+		return bSuccess;
+	}
+	//-------------------------------------------------------------------------
+	bool ShaperManager::loadGlyphCache( const char *fullPath )
+	{
+		LogListener *log = getLogListener();
+		char tmpBuffer[512];
+		Ogre::LwString errorMsg( Ogre::LwString::FromEmptyPointer( tmpBuffer, sizeof( tmpBuffer ) ) );
+
+		if( !m_glyphCache.empty() || !m_sdfBitmaps.empty() || m_offsetPtr != 1u )
+		{
+			log->log( "[ShaperManager::loadGlyphCache] Must be called before any glyph is created",
+					  LogSeverity::Error );
+			return false;
+		}
+
+		FILE *file = fopen( fullPath, "rb" );
+		if( !file )
+			return false;  // Not an error, the cache may not exist yet
+
+		// Every count in the file is checked against what's left to read, so that
+		// a truncated or corrupt file can't make us allocate an absurd amount
+		uint64_t remainingBytes = 0u;
+		bool bSuccess = fseek( file, 0, SEEK_END ) == 0;
+		if( bSuccess )
+		{
+			const long fileSize = ftell( file );
+			bSuccess = fileSize >= 0 && fseek( file, 0, SEEK_SET ) == 0;
+			remainingBytes = bSuccess ? static_cast<uint64_t>( fileSize ) : 0u;
+		}
+
+		std::vector<uint64_t> expectedKey;
+		getGlyphCacheKey( expectedKey );
+
+		// Header is: key, offsetPtr, numFreeRanges, numGlyphs, numSdfBitmaps
+		uint64_t headerSize = 0u;
+		std::vector<uint64_t> header;
+		bSuccess = bSuccess && fread( &headerSize, sizeof( headerSize ), 1u, file ) == 1u &&
+				   headerSize == expectedKey.size() + 4u;
+		if( bSuccess )
+		{
+			header.resize( headerSize );
+			bSuccess = fread( &header[0], sizeof( uint64_t ), header.size(), file ) == header.size() &&
+					   std::equal( expectedKey.begin(), expectedKey.end(), header.begin() );
+		}
+
+		if( !bSuccess )
+		{
+			fclose( file );
+			errorMsg.clear();
+			errorMsg.a( "[ShaperManager::loadGlyphCache] ", fullPath,
+						" is out of date or was created with different settings. Ignoring" );
+			log->log( errorMsg.c_str(), LogSeverity::Info );
+			return false;
+		}
+
+		remainingBytes -= std::min( remainingBytes, sizeof( uint64_t ) * ( headerSize + 1u ) );
+
+		const uint64_t offsetPtr = header[expectedKey.size()];
+		const uint64_t numFreeRanges = header[expectedKey.size() + 1u];
+		const uint64_t numGlyphs = header[expectedKey.size() + 2u];
+		const uint64_t numSdfBitmaps = header[expectedKey.size() + 3u];
+
+		// The atlas is stored after all the arrays
+		bSuccess = numFreeRanges <= remainingBytes / sizeof( SerializedRange );
+		if( bSuccess )
+		{
+			remainingBytes -= numFreeRanges * sizeof( SerializedRange );
+			bSuccess = numGlyphs <= remainingBytes / sizeof( SerializedGlyph );
+		}
+		if( bSuccess )
+		{
+			remainingBytes -= numGlyphs * sizeof( SerializedGlyph );
+			bSuccess = numSdfBitmaps <= remainingBytes / sizeof( SerializedSdfBitmap );
+		}
+		if( bSuccess )
+		{
+			remainingBytes -= numSdfBitmaps * sizeof( SerializedSdfBitmap );
+			bSuccess = offsetPtr >= 1u && offsetPtr == remainingBytes && offsetPtr <= m_maxAtlasSize;
+		}
+
+		std::vector<SerializedRange> serializedRanges;
+		std::vector<SerializedGlyph> glyphs;
+		std::vector<SerializedSdfBitmap> sdfBitmaps;
+
+		if( bSuccess )
+		{
+			serializedRanges.resize( static_cast<size_t>( numFreeRanges ) );
+			glyphs.resize( static_cast<size_t>( numGlyphs ) );
+			sdfBitmaps.resize( static_cast<size_t>( numSdfBitmaps ) );
+		}
+
+		if( !serializedRanges.empty() )
+		{
+			bSuccess &= fread( &serializedRanges[0], sizeof( SerializedRange ),
+							   serializedRanges.size(), file ) == serializedRanges.size();
+		}
+		if( !glyphs.empty() )
+		{
+			bSuccess &=
+				fread( &glyphs[0], sizeof( SerializedGlyph ), glyphs.size(), file ) == glyphs.size();
+		}
+		if( !sdfBitmaps.empty() )
+		{
+			bSuccess &= fread( &sdfBitmaps[0], sizeof( SerializedSdfBitmap ), sdfBitmaps.size(),
+							   file ) == sdfBitmaps.size();
+		}
+
+		RangeVec freeRanges;
+		freeRanges.reserve( serializedRanges.size() );
+		{
+			std::vector<SerializedRange>::const_iterator itor = serializedRanges.begin();
+			std::vector<SerializedRange>::const_iterator endt = serializedRanges.end();
+
+			while( itor != endt && bSuccess )
+			{
+				bSuccess = isAtlasRegionValid( itor->offset, itor->size, offsetPtr );
+				Range range;
+				range.offset = static_cast<size_t>( itor->offset );
+				range.size = static_cast<size_t>( itor->size );
+				freeRanges.push_back( range );
+				++itor;
+			}
+		}
+		{
+			std::vector<SerializedSdfBitmap>::const_iterator itor = sdfBitmaps.begin();
+			std::vector<SerializedSdfBitmap>::const_iterator endt = sdfBitmaps.end();
+
+			while( itor != endt && bSuccess )
+			{
+				bSuccess = itor->font < m_shapers.size() &&
+						   isAtlasRegionValid( itor->offsetStart,
+											   uint64_t( itor->width ) * uint64_t( itor->height ),
+											   offsetPtr );
+				++itor;
+			}
+		}
+		{
+			std::vector<SerializedGlyph>::const_iterator itor = glyphs.begin();
+			std::vector<SerializedGlyph>::const_iterator endt = glyphs.end();
+
+			while( itor != endt && bSuccess )
+			{
+				// SDF glyphs point to their shared bitmap, which is atlasWidth x atlasHeight
+				const uint64_t sizeBytes =
+					( itor->flags & 1u ) ? uint64_t( itor->atlasWidth ) * uint64_t( itor->atlasHeight )
+										 : uint64_t( itor->width ) * uint64_t( itor->height );
+				bSuccess = itor->font < m_shapers.size() &&
+						   isAtlasRegionValid( itor->offsetStart, sizeBytes, offsetPtr );
+				++itor;
+			}
+		}
+
+		while( bSuccess && m_atlasCapacity < offsetPtr )
+			bSuccess = growAtlas();
+
+		for( size_t pageStart = 0u; pageStart < offsetPtr && bSuccess; pageStart += m_atlasPageSize )
+		{
+			const size_t sizeBytes = std::min( static_cast<size_t>( offsetPtr ) - pageStart,
+											   m_atlasPageSize );
+			bSuccess &= fread( getAtlasPtr( pageStart ), 1u, sizeBytes, file ) == sizeBytes;
+		}
+
+		fclose( file );
+
+		if( !bSuccess )
+		{
+			// We may have grown the atlas, but it's still empty as far as anyone is concerned
+			errorMsg.clear();
+			errorMsg.a( "[ShaperManager::loadGlyphCache] Error reading ", fullPath,
+						". File is corrupt or the atlas is bigger than setMaxGlyphAtlasSize" );
+			log->log( errorMsg.c_str(), LogSeverity::Warning );
+			return false;
+		}
+
+		m_offsetPtr = static_cast<size_t>( offsetPtr );
+		m_freeRanges.swap( freeRanges );
+
+		{
+			std::vector<SerializedSdfBitmap>::const_iterator itor = sdfBitmaps.begin();
+			std::vector<SerializedSdfBitmap>::const_iterator endt = sdfBitmaps.end();
+
+			while( itor != endt )
+			{
+				SdfBitmap sdfBitmap;
+				sdfBitmap.offsetStart = itor->offsetStart;
+				sdfBitmap.width = itor->width;
+				sdfBitmap.height = itor->height;
+				sdfBitmap.bearingX = itor->bearingX;
+				sdfBitmap.bearingY = itor->bearingY;
+				sdfBitmap.refCount = 0u;
+				m_sdfBitmaps.insert(
+					SdfBitmapMap::value_type( GlyphKey( itor->codepoint, 0u, itor->font ), sdfBitmap ) );
+				++itor;
+			}
+		}
+
+		std::vector<SerializedGlyph>::const_iterator itor = glyphs.begin();
+		std::vector<SerializedGlyph>::const_iterator endt = glyphs.end();
+
+		while( itor != endt )
+		{
+			CachedGlyph newGlyph;
+			newGlyph.codepoint = itor->codepoint;
+			newGlyph.ptSize = itor->ptSize;
+			newGlyph.offsetStart = itor->offsetStart;
+			newGlyph.bearingX = itor->bearingX;
+			newGlyph.bearingY = itor->bearingY;
+			newGlyph.width = itor->width;
+			newGlyph.height = itor->height;
+			newGlyph.atlasWidth = itor->atlasWidth;
+			newGlyph.atlasHeight = itor->atlasHeight;
+			newGlyph.newlineSize = itor->newlineSize;
+			newGlyph.regionUp = itor->regionUp;
+			newGlyph.font = itor->font;
+			newGlyph.isSdf = ( itor->flags & 1u ) != 0u;
+			newGlyph.refCount = 0;
+			if( newGlyph.isSdf )
+			{
+				// Each SDF glyph holds a reference to its shared bitmap
+				SdfBitmapMap::iterator itBitmap =
+					m_sdfBitmaps.find( GlyphKey( itor->codepoint, 0u, itor->font ) );
+				if( itBitmap != m_sdfBitmaps.end() )
+					++itBitmap->second.refCount;
+			}
+			m_glyphCache.emplace( GlyphKey( itor->codepoint, itor->ptSize, itor->font ), newGlyph );
+			++itor;
+		}
+
+		// Schedule everything for upload
+		m_dirtyRanges.clear();
+		for( size_t pageStart = 0u; pageStart < m_offsetPtr; pageStart += m_atlasPageSize )
+		{
+			Range dirtyRange;
+			dirtyRange.offset = pageStart;
+			dirtyRange.size = std::min( m_offsetPtr - pageStart, m_atlasPageSize );
+			m_dirtyRanges.push_back( dirtyRange );
+		}
+
+		errorMsg.clear();
+		errorMsg.a( "[ShaperManager::loadGlyphCache] Loaded ", (uint32_t)glyphs.size(),
+					" glyphs from ", fullPath );
+		log->log( errorMsg.c_str(), LogSeverity::Info );
+
+		return true;
+	}
+	//-------------------------------------------------------------------------
+	void ShaperManager::destroyGlyph( CachedGlyphMap::iterator glyphIt )
+	{
+		CachedGlyph &glyph = glyphIt->second;
+
+		if( !m_pendingRasters.empty() && glyph.getSizeBytes() > 0u )
+		{
+			// Don't let the workers write into a region that may be given to someone else
+			PendingRasterVec::iterator itor = m_pendingRasters.begin();
+			PendingRasterVec::iterator endt = m_pendingRasters.end();
+
+			while( itor != endt && itor->offsetStart != glyph.offsetStart )
+				++itor;
+
+			if( itor != endt )
+				Ogre::efficientVectorRemove( m_pendingRasters, itor );
+		}
+
+		if( glyph.isSdf )
+		{
+			// The bitmap is shared by all sizes. Free it once nobody uses it.
+			SdfBitmapMap::iterator itBitmap =
+				m_sdfBitmaps.find( GlyphKey( glyph.codepoint, 0u, glyph.font ) );
+			COLIBRI_ASSERT_LOW( itBitmap != m_sdfBitmaps.end() );
+			--itBitmap->second.refCount;
+			if( itBitmap->second.refCount == 0u )
+			{
+				freeAtlasRange( itBitmap->second.offsetStart,
+								size_t( itBitmap->second.width ) * size_t( itBitmap->second.height ) );
+				m_sdfBitmaps.erase( itBitmap );
+			}
+		}
+		else
+		{
+			freeAtlasRange( glyph.offsetStart, glyph.getSizeBytes() );
+		}
+
+		m_glyphCache.erase( glyphIt );
+	}
+	//-------------------------------------------------------------------------
+	void ShaperManager::freeAtlasRange( size_t offset, size_t sizeBytes )
+	{
+		if( offset + sizeBytes == m_offsetPtr )
+		{
+			//Easy case. LIFO.
+			m_offsetPtr -= sizeBytes;
+		}
+		else
+		{
+			Range freeRange;
+			freeRange.offset= offset;
+			freeRange.size	= sizeBytes;
+			m_freeRanges.push_back( freeRange );
+			mergeContiguousBlocks( m_freeRanges.end() - 1u, m_freeRanges );
+		}
+	}
+	//-------------------------------------------------------------------------
+	void ShaperManager::mergeContiguousBlocks( RangeVec::iterator blockToMerge,
+											   RangeVec &blocks )
+	{
+		RangeVec::iterator itor = blocks.begin();
+		RangeVec::iterator end  = blocks.end();
+
+		// Glyphs can't straddle two pages, so free blocks must not straddle them either
+		const size_t pageSize = m_atlasPageSize;
+
+		while( itor != end )
+		{
+			if( itor->offset + itor->size == blockToMerge->offset &&
+				blockToMerge->offset % pageSize != 0u )
+			{
+				itor->size += blockToMerge->size;
+				ptrdiff_t idx = itor - blocks.begin();
+
+				//When blockToMerge is the last one, its index won't be the same
+				//after removing the other iterator, they will swap.
+				if( idx == ptrdiff_t( blocks.size() - 1u ) )
+					idx = blockToMerge - blocks.begin();
+
+				Ogre::efficientVectorRemove( blocks, blockToMerge );
+
+				blockToMerge = blocks.begin() + idx;
+				itor = blocks.begin();
+				end  = blocks.end();
+			}
+			else if( blockToMerge->offset + blockToMerge->size == itor->offset &&
+					 itor->offset % pageSize != 0u )
+			{
+				blockToMerge->size += itor->size;
+				ptrdiff_t idx = blockToMerge - blocks.begin();
+
+				//When blockToMerge is the last one, its index won't be the same
+				//after removing the other iterator, they will swap.
+				if( idx == ptrdiff_t( blocks.size() - 1u ) )
+					idx = itor - blocks.begin();
+
+				Ogre::efficientVectorRemove( blocks, itor );
+
+				blockToMerge = blocks.begin() + idx;
+				itor = blocks.begin();
+				end  = blocks.end();
+			}
+			else
+			{
+				++itor;
+			}
+		}
+	}
+	//-------------------------------------------------------------------------
+	const CachedGlyph *ShaperManager::acquireGlyph( FT_Face font, uint32_t codepoint, uint32_t ptSize,
+													uint16_t fontIdx, bool bDummy,
+													const bool bUseCodepoint0ForRaster )
+	{
+		CachedGlyph *retVal = 0;
+
+		const GlyphKey glyphKey( codepoint, ptSize, fontIdx );
+		CachedGlyphMap::iterator itor = m_glyphCache.find( glyphKey );
+
+		if( itor != m_glyphCache.end() )
+		{
+			retVal = &itor->second;
+		}
+		else
+		{
+			if( ( !bDummy || !getDefaultBmpFontForRaster() ) && fontIdx < m_shapers.size() &&
+				m_shapers[fontIdx]->getSdfMode() )
+			{
+				retVal = createSdfGlyph( font, codepoint, ptSize, fontIdx, bDummy );
+			}
+			else if( !bDummy || !getDefaultBmpFontForRaster() )
+			{
+				retVal = createGlyph( font, codepoint, ptSize, fontIdx, bDummy );
+			}
+			else
+			{
+				retVal =
+					createRasterGlyph( font, codepoint, ptSize, fontIdx, bUseCodepoint0ForRaster );
+			}
+		}
+
+		++retVal->refCount;
+
+		return retVal;
+	}
+	//-------------------------------------------------------------------------
+	void ShaperManager::addRefCount( const CachedGlyph *cachedGlyph )
+	{
+		const GlyphKey glyphKey( cachedGlyph->codepoint, cachedGlyph->ptSize, cachedGlyph->font );
+
+		COLIBRI_ASSERT_MEDIUM( m_glyphCache.find( glyphKey ) != m_glyphCache.end() &&
+							   "Invalid glyph cache entry. Use-after-free perhaps?" );
+
+		CachedGlyph *nonConstCachedGlyph = const_cast<CachedGlyph*>( cachedGlyph );
+		++nonConstCachedGlyph->refCount;
+	}
+	//-------------------------------------------------------------------------
+	void ShaperManager::releaseGlyph( uint32_t codepoint, uint32_t ptSize, uint16_t fontIdx )
+	{
+		const GlyphKey glyphKey( codepoint, ptSize, fontIdx );
+
+		CachedGlyphMap::iterator itor = m_glyphCache.find( glyphKey );
+
+		COLIBRI_ASSERT_LOW( itor != m_glyphCache.end() &&
+							"Invalid glyph cache entry not found. Use-after-free perhaps?" );
+		COLIBRI_ASSERT_LOW( itor->second.refCount > 0 );
+
+		if( itor != m_glyphCache.end() && itor->second.refCount > 0 )
+			--itor->second.refCount;
+	}
+	//-------------------------------------------------------------------------
+	void ShaperManager::releaseGlyph( const CachedGlyph *cachedGlyph )
+	{
+		const GlyphKey glyphKey( cachedGlyph->codepoint, cachedGlyph->ptSize, cachedGlyph->font );
+
+		COLIBRI_ASSERT_MEDIUM( m_glyphCache.find( glyphKey ) != m_glyphCache.end() &&
+							   "Invalid glyph cache entry. Use-after-free perhaps?" );
+		COLIBRI_ASSERT_LOW( cachedGlyph->refCount > 0 );
+
+		CachedGlyph *nonConstCachedGlyph = const_cast<CachedGlyph*>( cachedGlyph );
+		if( nonConstCachedGlyph->refCount > 0 )
+			--nonConstCachedGlyph->refCount;
+	}
+	//-------------------------------------------------------------------------
+	void ShaperManager::flushReleasedGlyphs()
+	{
 		CachedGlyphMap::iterator itor = m_glyphCache.begin();
 		CachedGlyphMap::iterator end  = m_glyphCache.end();
 
@@ -672,30 +1669,108 @@ namespace Colibri
 		return m_preferredVertReadingDir;
 	}
 	//-------------------------------------------------------------------------
-	void ShaperManager::updateGpuBuffers()
+	void ShaperManager::uploadDirtyRanges()
 	{
-		if( (!m_glyphAtlasBuffer ||
-			 m_atlasCapacity !=
-			 m_glyphAtlasBuffer->getTotalSizeBytes()) &&
-			m_atlasCapacity > 0u )
+		if( m_dirtyRanges.empty() )
+			return;
+
+#ifdef OGRE_VK_WORKAROUND_PVR_ALIGNMENT
+		if( Ogre::Workarounds::mPowerVRAlignment )
 		{
-			// Local buffer has changed (i.e. growAtlas was called). Realloc the GPU buffer.
-			if( m_glyphAtlasBuffer )
+			RangeVec::iterator itor = m_dirtyRanges.begin();
+			RangeVec::iterator endt = m_dirtyRanges.end();
+
+			while( itor != endt )
 			{
-#if OGRE_VERSION >= OGRE_MAKE_VERSION( 2, 3, 0 )
-				if( m_glyphAtlasBuffer->getBufferPackedType() != Ogre::BP_TYPE_TEX )
+				const size_t newOffset =
+					Ogre::alignToPreviousMult( itor->offset, Ogre::Workarounds::mPowerVRAlignment );
+				itor->size += itor->offset - newOffset;
+				itor->offset = newOffset;
+				++itor;
+			}
+		}
+#endif
+
+		// Glyphs created in the same frame tend to be contiguous (they're mostly allocated
+		// from m_offsetPtr). Sort the ranges and merge the ones that overlap or are close
+		// enough that uploading the gap in between is cheaper than issuing another copy.
+		// Ranges from different pages are never merged since they're not contiguous in RAM.
+		std::sort( m_dirtyRanges.begin(), m_dirtyRanges.end() );
+
+		const size_t c_maxGapToMerge = 4096u;
+
+		size_t totalBytes = 0u;
+		RangeVec::iterator merged = m_dirtyRanges.begin();
+		{
+			RangeVec::const_iterator itor = m_dirtyRanges.begin() + 1u;
+			RangeVec::const_iterator endt = m_dirtyRanges.end();
+
+			while( itor != endt )
+			{
+				const size_t mergedEnd = merged->offset + merged->size;
+				if( itor->offset <= mergedEnd + c_maxGapToMerge &&
+					itor->offset / m_atlasPageSize == merged->offset / m_atlasPageSize )
 				{
-					m_vaoManager->destroyReadOnlyBuffer(
-						static_cast<Ogre::ReadOnlyBufferPacked *>( m_glyphAtlasBuffer ) );
+					merged->size = std::max( mergedEnd, itor->offset + itor->size ) - merged->offset;
 				}
 				else
-#endif
 				{
-					m_vaoManager->destroyTexBuffer(
-						static_cast<Ogre::TexBufferPacked *>( m_glyphAtlasBuffer ) );
+					totalBytes += merged->size;
+					++merged;
+					*merged = *itor;
 				}
+				++itor;
+			}
+			totalBytes += merged->size;
+			m_dirtyRanges.erase( merged + 1u, m_dirtyRanges.end() );
+		}
+
+		if( m_dirtyRanges.size() == 1u )
+		{
+			const Range &range = m_dirtyRanges.front();
+			m_glyphAtlasBuffer->upload( getAtlasPtr( range.offset ), range.offset, range.size );
+		}
+		else
+		{
+			// Pack all ranges into a single staging buffer, and issue all copies at once
+			Ogre::StagingBuffer *stagingBuffer = m_vaoManager->getStagingBuffer( totalBytes, true );
+			uint8_t *stagingData = reinterpret_cast<uint8_t *>( stagingBuffer->map( totalBytes ) );
+
+			std::vector<Ogre::StagingBuffer::Destination> destinations;
+			destinations.reserve( m_dirtyRanges.size() );
+
+			size_t srcOffset = 0u;
+			RangeVec::const_iterator itor = m_dirtyRanges.begin();
+			RangeVec::const_iterator endt = m_dirtyRanges.end();
+
+			while( itor != endt )
+			{
+				memcpy( stagingData + srcOffset, getAtlasPtr( itor->offset ), itor->size );
+				destinations.push_back( Ogre::StagingBuffer::Destination(
+					m_glyphAtlasBuffer, itor->offset, srcOffset, itor->size ) );
+				srcOffset += itor->size;
+				++itor;
 			}
 
+			stagingBuffer->unmap( &destinations[0], destinations.size() );
+			stagingBuffer->removeReferenceCount();
+		}
+
+		m_dirtyRanges.clear();
+	}
+	//-------------------------------------------------------------------------
+	void ShaperManager::updateGpuBuffers()
+	{
+		rasterizePendingGlyphs();
+
+		if( (!m_glyphAtlasBuffer ||
+			 m_atlasCapacity !=
+			 m_glyphAtlasBuffer->getTotalSizeBytes()) &&
+			m_atlasCapacity > 0u )
+		{
+			// Local buffer has changed (i.e. growAtlas was called). Realloc the GPU buffer.
+			Ogre::BufferPacked *oldBuffer = m_glyphAtlasBuffer;
+
 #if OGRE_VERSION >= OGRE_MAKE_VERSION( 2, 3, 0 )
 			if( Ogre::HlmsColibri::needsReadOnlyBuffer( m_hlms->getRenderSystem()->getCapabilities(),
 														m_vaoManager ) )
@@ -711,38 +1786,243 @@ namespace Colibri
 			}
 			m_hlms->setGlyphAtlasBuffer( m_glyphAtlasBuffer );
 
-			// The 1st byte is taken. We use this byte to render arbitrary fixed-colour
-			// stuff without having to switch shaders and would complicate rendering.
-			// It's mostly used for the background colour by Label.
-			m_glyphAtlas[0] = 0xff;
+			if( oldBuffer )
+			{
+				// Everything that was already uploaded is still valid. Copy it GPU-side
+				// and only upload what's new (i.e. the new page), instead of sending
+				// the whole atlas again.
+				oldBuffer->copyTo( m_glyphAtlasBuffer, 0u, 0u, oldBuffer->getNumElements() );
 
-			m_glyphAtlasBuffer->upload( m_glyphAtlas, 0, m_offsetPtr );
-			m_dirtyRanges.clear();
+#if OGRE_VERSION >= OGRE_MAKE_VERSION( 2, 3, 0 )
+				if( oldBuffer->getBufferPackedType() != Ogre::BP_TYPE_TEX )
+				{
+					m_vaoManager->destroyReadOnlyBuffer(
+						static_cast<Ogre::ReadOnlyBufferPacked *>( oldBuffer ) );
+				}
+				else
+#endif
+				{
+					m_vaoManager->destroyTexBuffer( static_cast<Ogre::TexBufferPacked *>( oldBuffer ) );
+				}
+
+				uploadDirtyRanges();
+			}
+			else
+			{
+				// Fresh buffer. Upload the used portion of every page.
+				m_dirtyRanges.clear();
+				for( size_t pageStart = 0u; pageStart < m_offsetPtr; pageStart += m_atlasPageSize )
+				{
+					Range dirtyRange;
+					dirtyRange.offset = pageStart;
+					dirtyRange.size = std::min( m_offsetPtr - pageStart, m_atlasPageSize );
+					m_dirtyRanges.push_back( dirtyRange );
+				}
+				uploadDirtyRanges();
+			}
 		}
 		else
 		{
-			RangeVec::const_iterator itor = m_dirtyRanges.begin();
-			RangeVec::const_iterator endt = m_dirtyRanges.end();
+			uploadDirtyRanges();
+		}
+	}
+	//-------------------------------------------------------------------------
+	void ShaperManager::setGlyphAtlasPageSize( size_t pageSizeBytes )
+	{
+		COLIBRI_ASSERT_LOW( m_atlasPages.empty() &&
+							"setGlyphAtlasPageSize must be called before any glyph is created" );
+		// Keep pages aligned to anything the GPU may want (e.g. PowerVR's upload alignment)
+		m_atlasPageSize = std::max<size_t>( Ogre::alignToNextMultiple( pageSizeBytes, 4096u ), 4096u );
+	}
+	//-------------------------------------------------------------------------
+	void ShaperManager::setMaxGlyphAtlasSize( size_t maxSizeBytes ) { m_maxAtlasSize = maxSizeBytes; }
+	//-------------------------------------------------------------------------
+	void ShaperManager::setSdfReferenceSize( FontSize ptSize, uint16_t spread )
+	{
+		COLIBRI_ASSERT_LOW( m_sdfBitmaps.empty() &&
+							"setSdfReferenceSize must be called before any SDF glyph is created" );
+		m_sdfReferenceSize = ptSize;
+		m_sdfSpread = std::max<uint16_t>( spread, 1u );
+	}
+	//-------------------------------------------------------------------------
+	void ShaperManager::setNumRasterThreads( size_t numThreads )
+	{
+#ifdef __ANDROID__
+		if( numThreads > 0u )
+		{
+			getLogListener()->log(
+				"[ShaperManager] setNumRasterThreads is not supported on Android. Ignoring.",
+				LogSeverity::Warning );
+			numThreads = 0u;
+		}
+#endif
+		if( numThreads == getNumRasterThreads() )
+			return;
+
+		rasterizePendingGlyphs();
+
+		if( m_rasterWorkers )
+		{
+			m_rasterWorkers->exitRequested = true;
+			m_rasterWorkers->barrier.sync();
+			Ogre::Threads::WaitForThreads( m_rasterWorkers->threads );
+
+			std::vector<RasterWorkers::Worker>::const_iterator itor = m_rasterWorkers->workers.begin();
+			std::vector<RasterWorkers::Worker>::const_iterator endt = m_rasterWorkers->workers.end();
 
 			while( itor != endt )
 			{
-				size_t offset = itor->offset;
-				size_t size = itor->size;
-#ifdef OGRE_VK_WORKAROUND_PVR_ALIGNMENT
-				if( Ogre::Workarounds::mPowerVRAlignment && offset > 0u )
+				// Also destroys its faces
+				FT_Done_FreeType( itor->library );
+				++itor;
+			}
+
+			delete m_rasterWorkers;
+			m_rasterWorkers = 0;
+		}
+
+		if( numThreads > 0u )
+		{
+			m_rasterWorkers = new RasterWorkers( numThreads );
+			for( size_t i = 0u; i < numThreads; ++i )
+			{
+				FT_Error errorCode = FT_Init_FreeType( &m_rasterWorkers->workers[i].library );
+				if( errorCode )
 				{
-					const size_t newOffset =
-						Ogre::alignToPreviousMult( offset, Ogre::Workarounds::mPowerVRAlignment );
-					size += offset - newOffset;
-					offset = newOffset;
+					LogListener *log = this->getLogListener();
+					char tmpBuffer[512];
+					Ogre::LwString errorMsg(
+						Ogre::LwString::FromEmptyPointer( tmpBuffer, sizeof( tmpBuffer ) ) );
+
+					errorMsg.clear();
+					errorMsg.a( "[Freetype2 error] Could not initialize Freetype for worker thread. "
+								"errorCode: ",
+								errorCode, " Desc: ", ShaperManager::getErrorMessage( errorCode ) );
+					log->log( errorMsg.c_str(), LogSeverity::Error );
+					m_rasterWorkers->workers[i].library = 0;
 				}
-#endif
-				m_glyphAtlasBuffer->upload( m_glyphAtlas + offset, offset, size );
-				++itor;
 			}
 
-			m_dirtyRanges.clear();
+			for( size_t i = 0u; i < numThreads; ++i )
+			{
+				m_rasterWorkers->threads.push_back(
+					Ogre::Threads::CreateThread( THREAD_GET( rasterWorkerThread ), i, this ) );
+			}
+		}
+	}
+	//-------------------------------------------------------------------------
+	size_t ShaperManager::getNumRasterThreads() const
+	{
+		return m_rasterWorkers ? m_rasterWorkers->workers.size() : 0u;
+	}
+	//-------------------------------------------------------------------------
+	void ShaperManager::rasterizePendingGlyphs()
+	{
+		if( m_pendingRasters.empty() )
+			return;
+
+		COLIBRI_ASSERT_LOW( m_rasterWorkers );
+
+		std::sort( m_pendingRasters.begin(), m_pendingRasters.end() );
+
+		m_rasterWorkers->barrier.sync();  // Start
+		m_rasterWorkers->barrier.sync();  // Wait until they're done
+
+		PendingRasterVec::const_iterator itor = m_pendingRasters.begin();
+		PendingRasterVec::const_iterator endt = m_pendingRasters.end();
+
+		while( itor != endt )
+		{
+			//Schedule a transfer to the GPU.
+			Range dirtyRange;
+			dirtyRange.offset = itor->offsetStart;
+			dirtyRange.size = size_t( itor->width ) * size_t( itor->height );
+			m_dirtyRanges.push_back( dirtyRange );
+			++itor;
+		}
+
+		m_pendingRasters.clear();
+	}
+	//-------------------------------------------------------------------------
+	void ShaperManager::rasterizePendingGlyphs( size_t threadIdx )
+	{
+		RasterWorkers::Worker &worker = m_rasterWorkers->workers[threadIdx];
+
+		const size_t numThreads = m_rasterWorkers->workers.size();
+		const size_t numJobs = m_pendingRasters.size();
+		const size_t jobStart = ( numJobs * threadIdx ) / numThreads;
+		const size_t jobEnd = ( numJobs * ( threadIdx + 1u ) ) / numThreads;
+
+		const FT_UInt dpi = m_dpi;
+
+		for( size_t i = jobStart; i < jobEnd; ++i )
+		{
+			const PendingRaster &pendingRaster = m_pendingRasters[i];
+
+			if( worker.faces.size() <= pendingRaster.fontIdx )
+			{
+				worker.faces.resize( pendingRaster.fontIdx + 1u, 0 );
+				worker.faceSizes.resize( pendingRaster.fontIdx + 1u, 0u );
+			}
+
+			FT_Face face = worker.faces[pendingRaster.fontIdx];
+			if( !face && worker.library )
+			{
+				// We can't use the Shaper's face, FreeType faces can't be shared across threads
+				const std::string &fontLocation = m_shapers[pendingRaster.fontIdx]->getFontLocation();
+				if( FT_New_Face( worker.library, fontLocation.c_str(), 0, &face ) )
+					face = 0;
+				worker.faces[pendingRaster.fontIdx] = face;
+			}
+
+			FT_Error errorCode = face ? 0 : FT_Err_Invalid_Face_Handle;
+
+			if( !errorCode && worker.faceSizes[pendingRaster.fontIdx] != pendingRaster.ptSize )
+			{
+				errorCode = FT_Set_Char_Size( face, 0, (FT_F26Dot6)pendingRaster.ptSize, dpi, dpi );
+				worker.faceSizes[pendingRaster.fontIdx] = errorCode ? 0u : pendingRaster.ptSize;
+			}
+			if( !errorCode )
+				errorCode = FT_Load_Glyph( face, pendingRaster.glyphIndex, FT_LOAD_DEFAULT );
+			if( !errorCode )
+				errorCode = FT_Render_Glyph( face->glyph, FT_RENDER_MODE_NORMAL );
+
+			const size_t sizeBytes = size_t( pendingRaster.width ) * size_t( pendingRaster.height );
+			uint8_t *dstData = getAtlasPtr( pendingRaster.offsetStart );
+
+			// We can't log from here. Leave the glyph blank if anything went wrong.
+			if( !errorCode && face->glyph->bitmap.width == pendingRaster.width &&
+				face->glyph->bitmap.rows == pendingRaster.height )
+			{
+				memcpy( dstData, face->glyph->bitmap.buffer, sizeBytes );
+			}
+			else
+			{
+				memset( dstData, 0, sizeBytes );
+			}
+		}
+	}
+	//-------------------------------------------------------------------------
+	unsigned long ShaperManager::_rasterWorkerThread( size_t threadIdx )
+	{
+		RasterWorkers *rasterWorkers = m_rasterWorkers;
+
+		bool bExit = false;
+		while( !bExit )
+		{
+			rasterWorkers->barrier.sync();
+			if( !rasterWorkers->exitRequested )
+			{
+				rasterizePendingGlyphs( threadIdx );
+				rasterWorkers->barrier.sync();
+			}
+			else
+			{
+				bExit = true;
+			}
 		}
+
+		return 0;
 	}
 	//-------------------------------------------------------------------------
 	void ShaperManager::prepareToRender() { m_hlms->setGlyphAtlasBuffer( m_glyphAtlasBuffer ); }
@@ -761,7 +2041,7 @@ namespace Colibri
 	//-------------------------------------------------------------------------
 	size_t CachedGlyph::getSizeBytes() const
 	{
-		if( isCodepointInPrivateArea() )
+		if( isCodepointInPrivateArea() || isSdf )
 			return 0u;
 		return this->width * this->height;
 	}